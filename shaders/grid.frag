@@ -2,8 +2,75 @@
 in vec2 vUV;
 out vec4 FragColor;
 
-uniform sampler2D uTex;
+// Packed cell views, see src/simulation/cell_view.h
+uniform usampler2D uCells;
+// Heat gradient for the energy and age views
+uniform sampler1D uLut;
+// 0 = types, 1 = genomes, 2 = energy, 3 = age
+uniform int uViewMode;
+// Genome key to pick out, or -1
+uniform int uHighlight;
+// Slot + 1 of every page of the grid in the atlas uCells is, or 0
+uniform usampler2D uPages;
+uniform ivec2 uGridSize;
+// uCells holds one view per 2^uLevel x 2^uLevel cells
+uniform int uLevel;
+uniform ivec2 uPageSize;
+uniform int uSlotsX;
+
+const vec3 TYPE_COLOURS[5] = vec3[5](
+  vec3(0.0),
+  vec3(0.2, 0.2, 0.2),
+  vec3(0.047, 1.0, 0.2),
+  vec3(0.063, 0.333, 0.008),
+  vec3(1.0)
+);
+
+vec3 hsv(float h, float s, float v) {
+  vec3 k = clamp(abs(mod(h * 6.0 + vec3(0.0, 4.0, 2.0), 6.0) - 3.0) - 1.0, 0.0, 1.0);
+  return v * mix(vec3(1.0), k, s);
+}
+
+vec3 genomeColour(uint key) {
+  // Spread neighbouring keys over the hue circle; the low bits vary the tone
+  float hue = float(key >> 2u) / 2048.0;
+  float sat = 0.6 + 0.2 * float(key & 1u);
+  float val = 0.75 + 0.15 * float((key >> 1u) & 1u);
+  return hsv(hue, sat, val);
+}
 
 void main() {
-  FragColor = texture(uTex, vUV);
+  ivec2 cell = clamp(ivec2(vUV * vec2(uGridSize)), ivec2(0), uGridSize - 1) >> uLevel;
+  ivec2 page = cell / uPageSize;
+  uint entry = texelFetch(uPages, page, 0).r;
+  if (entry == 0u) {
+    // Not resident yet
+    FragColor = vec4(0.06, 0.06, 0.07, 1.0);
+    return;
+  }
+  int slot = int(entry) - 1;
+  ivec2 texel = ivec2(slot % uSlotsX, slot / uSlotsX) * uPageSize + cell - page * uPageSize;
+
+  uint view = texelFetch(uCells, texel, 0).r;
+  uint type = view & 7u;
+  uint key = view >> 19u;
+
+  vec3 colour;
+  if (type == 0u) {
+    colour = vec3(0.0);
+  } else if (uViewMode == 1) {
+    colour = genomeColour(key);
+  } else if (uViewMode == 2) {
+    colour = texture(uLut, float((view >> 3u) & 127u) / 127.0).rgb;
+  } else if (uViewMode == 3) {
+    colour = texture(uLut, float((view >> 10u) & 63u) / 63.0).rgb;
+  } else {
+    colour = type == 4u ? genomeColour(key) : TYPE_COLOURS[type];
+  }
+
+  if (uHighlight >= 0 && type != 0u && key != uint(uHighlight)) {
+    colour *= 0.2;
+  }
+
+  FragColor = vec4(colour, 1.0);
 }
@@ -0,0 +1,55 @@
+#version 330 core
+in vec2 vLocal;
+flat in uint vView;
+flat in uint vEdges;
+out vec4 FragColor;
+
+// Side of a cell in screen pixels, for line widths
+uniform float uCellPixels;
+
+// Grid::DX8/DY8
+const vec2 DIRECTIONS[8] = vec2[8](
+  vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(1.0, 0.0), vec2(1.0, -1.0),
+  vec2(0.0, -1.0), vec2(-1.0, -1.0), vec2(-1.0, 0.0), vec2(-1.0, 1.0)
+);
+
+bool onArrow(vec2 p, vec2 dir) {
+  float along = dot(p, dir);
+  float across = abs(dot(p, vec2(-dir.y, dir.x)));
+  bool shaft = along > -0.3 && along < 0.05 && across < 0.05;
+  bool head = along >= 0.05 && along < 0.3 && across < (0.3 - along) * 0.9;
+  return shaft || head;
+}
+
+void main() {
+  // Distance to each side in pixels: -x, +x, -y, +y
+  vec4 sides = vec4(vLocal.x, 1.0 - vLocal.x, vLocal.y, 1.0 - vLocal.y) * uCellPixels;
+  float nearest = min(min(sides.x, sides.y), min(sides.z, sides.w));
+
+  // Organism outlines over grid lines over the glyphs
+  uvec4 edges = (uvec4(vEdges) >> uvec4(0u, 1u, 2u, 3u)) & 1u;
+  if (any(lessThan(sides + vec4(1u - edges) * 1e6, vec4(1.5)))) {
+    FragColor = vec4(1.0, 1.0, 1.0, 0.85);
+    return;
+  }
+  if (nearest < 1.0) {
+    FragColor = vec4(0.0, 0.0, 0.0, 0.35);
+    return;
+  }
+  if (vView == 0u) {
+    discard;
+  }
+
+  // Energy bar along the low side
+  float energy = float((vView >> 3u) & 127u) / 127.0;
+  if (vLocal.y > 0.1 && vLocal.y < 0.2 && vLocal.x > 0.1 && vLocal.x < 0.9) {
+    FragColor = (vLocal.x - 0.1) < energy * 0.8 ? vec4(1.0, 0.85, 0.1, 0.9) : vec4(0.0, 0.0, 0.0, 0.5);
+    return;
+  }
+
+  if (onArrow(vLocal - vec2(0.5, 0.55), normalize(DIRECTIONS[(vView >> 16u) & 7u]))) {
+    FragColor = vec4(0.0, 0.0, 0.0, 0.6);
+    return;
+  }
+  discard;
+}
@@ -0,0 +1,61 @@
+#version 330 core
+
+// One quad per visible cell, four strip vertices per instance and no
+// attributes: the instance is the cell, its view says what to draw
+
+// Packed cell views and the page table, as in grid.frag
+uniform usampler2D uCells;
+uniform usampler2D uPages;
+uniform ivec2 uGridSize;
+uniform ivec2 uPageSize;
+uniform int uSlotsX;
+// First visible cell and the visible cells per row
+uniform ivec2 uOrigin;
+uniform int uColumns;
+uniform mat4 uMVP;
+
+out vec2 vLocal;
+flat out uint vView;
+// Sides on an organism's outline: -x, +x, -y, +y
+flat out uint vEdges;
+
+const uint MISSING = 0xFFFFFFFFu;
+
+uint fetchView(ivec2 cell) {
+  if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, uGridSize))) {
+    return 0u;
+  }
+  ivec2 page = cell / uPageSize;
+  uint entry = texelFetch(uPages, page, 0).r;
+  if (entry == 0u) {
+    return MISSING;
+  }
+  int slot = int(entry) - 1;
+  return texelFetch(uCells, ivec2(slot % uSlotsX, slot / uSlotsX) * uPageSize + cell - page * uPageSize, 0).r;
+}
+
+bool isBoundary(uint other) {
+  // Organisms are the connected groups of live cells (OrganismRegistry), so
+  // cells sharing a side always share an organism and the outline is where
+  // live cells meet empty ones. A neighbour not resident yet draws no edge.
+  return other == 0u;
+}
+
+void main() {
+  ivec2 cell = uOrigin + ivec2(gl_InstanceID % uColumns, gl_InstanceID / uColumns);
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+  vLocal = corner;
+
+  uint view = fetchView(cell);
+  vView = view == MISSING ? 0u : view;
+  vEdges = 0u;
+  if (view != MISSING && view != 0u) {
+    vEdges |= isBoundary(fetchView(cell + ivec2(-1, 0))) ? 1u : 0u;
+    vEdges |= isBoundary(fetchView(cell + ivec2(1, 0))) ? 2u : 0u;
+    vEdges |= isBoundary(fetchView(cell + ivec2(0, -1))) ? 4u : 0u;
+    vEdges |= isBoundary(fetchView(cell + ivec2(0, 1))) ? 8u : 0u;
+  }
+
+  // Cells on pages not resident yet are dropped
+  gl_Position = view == MISSING ? vec4(0.0) : uMVP * vec4(vec2(cell) + corner, 0.0, 1.0);
+}
@@ -1,4 +1,5 @@
 #include "application.h"
+#include "../simulation/cell_view.h"
 #include <iostream>
 
 Application::~Application()
@@ -6,13 +7,30 @@ Application::~Application()
   shutdown();
 }
 
-bool Application::init()
+bool Application::init( const LaunchOptions& options )
 {
+  // Simulation first: in multi-process mode workers are forked before SDL starts any threads
+  m_simulation.setPyramidEnabled(true);
+  if ( !m_simulation.init(
+    Config::MAX_ENERGY,
+    Config::MAX_GENOME,
+    Config::GRID_WIDTH,
+    Config::GRID_HEIGHT,
+    Config::USE_HV_DIRECTIONS,
+    options.seed,
+    options.processes,
+    options.threads
+  ))
+  {
+    std::cerr << "Failed to initialize simulation" << std::endl;
+    return false;
+  }
+
   if ( !m_window.init(
     Config::WINDOW_TITLE,
     Config::WINDOW_WIDTH,
     Config::WINDOW_HEIGHT,
-    SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE,
+    (options.software ? 0 : SDL_WINDOW_OPENGL) | SDL_WINDOW_RESIZABLE,
     SDL_INIT_VIDEO | SDL_INIT_EVENTS
   ))
   {
@@ -20,30 +38,27 @@ bool Application::init()
     return false;
   }
 
-  if ( !m_interface.init(m_window.getSDLWindow(), m_window.getGLContext()) )
+  const bool interfaceReady = options.software
+    ? m_interface.init(m_window.getSDLWindow(), m_window.getSDLRenderer())
+    : m_interface.init(m_window.getSDLWindow(), m_window.getGLContext());
+  if ( !interfaceReady )
   {
     std::cerr << "Failed to initialize interface" << std::endl;
     return false;
   }
   
-  if ( !m_simulation.init(
-    Config::MAX_ENERGY,
-    Config::MAX_GENOME,
-    Config::GRID_WIDTH,
-    Config::GRID_HEIGHT,
-    Config::USE_HV_DIRECTIONS
-  ))
-  {
-    std::cerr << "Failed to initialize simulation" << std::endl;
-    return false;
-  }
-
-  if ( !m_renderer.init(Config::GRID_WIDTH, Config::GRID_HEIGHT) )
+  const bool rendererReady = options.software
+    ? m_renderer.initSoftware(Config::GRID_WIDTH, Config::GRID_HEIGHT, static_cast<size_t>(options.threads))
+    : m_renderer.init(Config::GRID_WIDTH, Config::GRID_HEIGHT);
+  if ( !rendererReady )
   {
     std::cerr << "Failed to initialize renderer" << std::endl;
     return false;
   }
 
+  // Large worlds take several frames per epoch instead of stalling input and rendering
+  m_simulation.setUpdateBudget(Config::UPDATE_FRAME_BUDGET);
+
   m_isRunning = true;
   return true;
 }
@@ -84,6 +99,7 @@ void Application::processEvents()
     if ( !m_interface.wantCaptureMouse() )
     {
       handleCameraInput(event);
+      handlePickInput(event);
     }
 
     // Handle window resize
@@ -98,6 +114,8 @@ void Application::processEvents()
 
 void Application::update()
 {
+  // The software frame reads the pixels the simulation is about to replace
+  m_renderer.finishUpload();
   m_simulation.update();
 }
 
@@ -107,11 +125,27 @@ void Application::render()
   m_window.getFramebufferSize(width, height);
 
   // Render grid
-  m_renderer.render(m_simulation.getGrid(), width, height);
+  m_renderer.render(width, height);
+  if ( m_renderer.isSoftware() )
+  {
+    const SoftwareRasterizer& frame = m_renderer.getRasterizer();
+    m_window.drawFrame(frame.getFrame(), frame.getFrameWidth(), frame.getFrameHeight());
+  }
 
   // Render UI
   m_interface.newFrame();
-  m_interface.render(m_simulation, m_renderer.getCamera());
+  m_interface.render(m_simulation, m_renderer);
+
+  // After the UI, which may reset or replace the world
+  m_renderer.beginUpload({
+    m_simulation.getPixels(),
+    m_simulation.getEpoch(),
+    m_simulation.getWorldGeneration(),
+    m_simulation.getTileEpochs(),
+    m_simulation.getTilesX(),
+    Config::PIXEL_TILE,
+    m_simulation.getPixelLevels()
+  });
 
   // Swap buffers
   m_window.swapBuffers();
@@ -165,3 +199,40 @@ void Application::handleCameraInput( const SDL_Event& event )
     camera.drag(event.motion.xrel, event.motion.yrel, fbHeight);
   }
 }
+
+void Application::handlePickInput( const SDL_Event& event )
+{
+  // Right click highlights the genome of the cell under the mouse, or clears it on empty ground
+  if ( event.type != SDL_MOUSEBUTTONDOWN || event.button.button != SDL_BUTTON_RIGHT ) return;
+
+  int cellX, cellY;
+  uint32_t view = 0;
+  if ( screenToCell(event.button.x, event.button.y, cellX, cellY) )
+  {
+    view = m_simulation.getPixels()[static_cast<size_t>(cellY) * m_simulation.getWidth() + cellX];
+  }
+
+  m_renderer.setHighlight(view != 0 ? CellView::getKey(view) : -1);
+}
+
+bool Application::screenToCell( int mouseX, int mouseY, int& cellX, int& cellY )
+{
+  const Camera2D& camera = m_renderer.getCamera();
+
+  // Mouse positions are in window coordinates, not framebuffer pixels
+  int windowWidth, windowHeight;
+  m_window.getWindowSize(windowWidth, windowHeight);
+  float aspect = static_cast<float>(windowWidth) / static_cast<float>(windowHeight);
+
+  // Inverse of Camera2D::getViewMatrix; screen y grows downwards
+  float ndcX = (2.0f * mouseX / windowWidth) - 1.0f;
+  float ndcY = 1.0f - (2.0f * mouseY / windowHeight);
+
+  float worldX = camera.getX() + ndcX / (camera.getZoom() / aspect);
+  float worldY = camera.getY() + ndcY / camera.getZoom();
+  if ( worldX < 0.0f || worldY < 0.0f || worldX >= m_simulation.getWidth() || worldY >= m_simulation.getHeight() ) return false;
+
+  cellX = static_cast<int>(worldX);
+  cellY = static_cast<int>(worldY);
+  return true;
+}
@@ -4,6 +4,7 @@
 #include "../simulation/simulation.h"
 #include "../ui/interface.h"
 #include "config.h"
+#include "launch_options.h"
 
 class Application
 {
@@ -11,7 +12,7 @@ class Application
   Application() = default;
   ~Application();
 
-  bool init();
+  bool init( const LaunchOptions& options );
   void run();
   void shutdown();
 
@@ -28,4 +29,7 @@ class Application
   void render();
 
   void handleCameraInput( const SDL_Event& event );
+  void handlePickInput( const SDL_Event& event );
+  // False when the point is outside the world
+  bool screenToCell( int mouseX, int mouseY, int& cellX, int& cellY );
 };
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 namespace Config
@@ -16,8 +17,64 @@ namespace Config
   constexpr uint16_t MAX_ENERGY = 100;
   constexpr uint16_t MAX_GENOME = 256;
   constexpr bool USE_HV_DIRECTIONS = true; // true = 4 directions, false = 8 directions
+  constexpr float SPROUT_DENSITY = 0.005f; // share of cells seeded with a sprout
+  constexpr uint16_t SPROUT_ENERGY = MAX_ENERGY; // energy of seeded sprouts
+
+  // Sprout action costs
+  constexpr uint16_t GROW_COST = 8;
+  constexpr uint16_t MOVE_COST = 4;
+  constexpr uint16_t DIVIDE_COST = 16;
+  constexpr uint16_t DISPERSE_COST = 64;
+
+  // Seed dispersal
+  constexpr uint16_t SEED_ENERGY = 16; // energy a dispersed seed lands with
+  constexpr int DISPERSAL_RADIUS = 24; // largest offset on either axis
+  constexpr int MAILBOX_TILE = 64; // side of the tiles long-range messages are grouped by
+
+  // Upkeep per epoch; a cell dies when its energy reaches zero
+  constexpr uint8_t WOOD_UPKEEP = 1;
+  constexpr uint8_t LEAF_UPKEEP = 1;
+  constexpr uint8_t ROOT_UPKEEP = 1;
+  constexpr uint8_t SPROUT_UPKEEP = 1;
+
+  // Energy flow
+  constexpr uint16_t LEAF_ENERGY = 4; // gained by each leaf per epoch
+  constexpr uint16_t TRANSPORT_RESERVE = 4; // kept by each cell on the way to a sprout
+  constexpr uint16_t ROOT_DRAIN = 2; // taken from the soil by each root per epoch
+
+  // Soil
+  constexpr int SOIL_SCALE = 2; // cells per soil sample along each axis
+  constexpr float SOIL_INITIAL = 4.0f; // organic matter per sample at start
+  constexpr float DEAD_CELL_ORGANIC = 8.0f; // deposited where a cell dies
+  constexpr uint64_t CORPSE_DECAY_EPOCHS = 20; // epochs until a dead cell reaches the soil
+  constexpr float SOIL_DIFFUSION_RATE = 0.2f; // must stay below 0.25
+  constexpr uint64_t SOIL_DIFFUSION_INTERVAL = 1; // epochs between diffusion steps
+
+  // Mutation of offspring genomes, probabilities per gene
+  constexpr double POINT_MUTATION_RATE = 1.0 / 2048.0;
+  constexpr double INSERTION_RATE = 1.0 / 16384.0;
+  constexpr double DUPLICATION_RATE = 1.0 / 16384.0;
+  constexpr uint16_t MAX_DUPLICATION = 8; // longest duplicated run
+  constexpr uint64_t GENOME_COLLECT_INTERVAL = 64; // epochs between reclaiming unused genome slots
+
+  // Time-sliced updates: work per stripe in one slice of a sliced stage
+  constexpr size_t UPDATE_SLICE_ROWS = 64;
+  constexpr size_t UPDATE_SLICE_CELLS = 16384; // worklist entries
+  constexpr size_t UPDATE_SLICE_FORESTS = 256; // transport forests
+  constexpr double UPDATE_FRAME_BUDGET = 0.008; // seconds of simulation per rendered frame
+
+  // World files
+  constexpr const char* WORLD_FILE = "world.gxw";
 
   // Rendering settings
+  constexpr int PIXEL_TILE = 64; // side of the tiles changed pixels are tracked and uploaded in
+  constexpr int ATLAS_SIZE = 4096; // larger grids are paged into an atlas this big
+  constexpr int TEXTURE_PAGE = 256; // side of an atlas page, a multiple of PIXEL_TILE
+  constexpr bool CELL_OVERLAY = true; // arrows, energy bars and outlines over cells drawn large enough
+  constexpr float OVERLAY_MIN_CELL_PIXELS = 12.0f;
+  constexpr const char* SHADER_CACHE_DIR = "shader_cache"; // linked program binaries; empty disables
+  constexpr bool SHADER_HOT_RELOAD = true; // rebuild the programs when a file in shaders/ changes
+  constexpr bool SOFTWARE_RENDERER = false; // draw on the CPU instead of OpenGL, see --renderer
   constexpr float INITIAL_ZOOM = 2.0f;
   constexpr float MIN_ZOOM = 0.0005f;
   constexpr float MAX_ZOOM = 20.0f;
@@ -26,4 +83,10 @@ namespace Config
   // Performance settings
   constexpr bool ENABLE_VSYNC = false;
   constexpr int TARGET_FPS = 60;
+  constexpr int WORKER_THREADS = 0; // 0 = one per hardware thread
+  constexpr int SLAB_HALO_ROWS = 2; // rows mirrored from each neighbouring slab in multi-process mode; whole soil samples
+
+  // Headless runs and replicate ensembles
+  constexpr uint64_t HEADLESS_EPOCHS = 1000;
+  constexpr const char* FRAME_DIR = "frames"; // headless frames, one PPM per rendered epoch
 }
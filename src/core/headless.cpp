@@ -0,0 +1,183 @@
+#include "headless.h"
+#include "../rendering/offscreen_context.h"
+#include "../rendering/renderer.h"
+#include "../simulation/ensemble.h"
+#include "../simulation/simulation.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace Headless
+{
+  namespace
+  {
+    // Binary PPM, which any image tool and ffmpeg read
+    bool writeFrame( const std::string& directory, uint64_t epoch, const std::vector<uint8_t>& rgba, int width, int height )
+    {
+      char name[32];
+      std::snprintf(name, sizeof(name), "epoch_%08llu.ppm", static_cast<unsigned long long>(epoch));
+      std::ofstream out(std::filesystem::path(directory) / name, std::ios::binary);
+      if ( !out )
+      {
+        std::cerr << "Failed to write frame " << name << std::endl;
+        return false;
+      }
+
+      out << "P6\n" << width << " " << height << "\n255\n";
+      std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+      for ( int y = 0; y < height; ++y )
+      {
+        const uint8_t* source = rgba.data() + static_cast<size_t>(y) * width * 4;
+        for ( int x = 0; x < width; ++x )
+        {
+          row[x * 3 + 0] = source[x * 4 + 0];
+          row[x * 3 + 1] = source[x * 4 + 1];
+          row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+      }
+      return static_cast<bool>(out);
+    }
+  }
+
+  int runWorld( const LaunchOptions& options )
+  {
+    // Nothing reads the coarser pixel levels unless frames are drawn
+    Simulation simulation;
+    simulation.setPyramidEnabled(options.frameEvery > 0);
+    if ( !simulation.init(
+      Config::MAX_ENERGY,
+      Config::MAX_GENOME,
+      Config::GRID_WIDTH,
+      Config::GRID_HEIGHT,
+      Config::USE_HV_DIRECTIONS,
+      options.seed,
+      options.processes,
+      options.threads
+    ))
+    {
+      std::cerr << "Failed to initialize simulation" << std::endl;
+      return 1;
+    }
+
+    // Frames are drawn as the window would draw them, into an offscreen
+    // context; each is read back while the next epochs run
+    const bool frames = options.frameEvery > 0;
+    OffscreenContext context;
+    Renderer renderer;
+    if ( frames )
+    {
+      if ( !context.init(Config::WINDOW_WIDTH, Config::WINDOW_HEIGHT) || !renderer.init(Config::GRID_WIDTH, Config::GRID_HEIGHT) )
+      {
+        std::cerr << "Failed to initialize offscreen rendering" << std::endl;
+        return 1;
+      }
+      renderer.handleResize(context.getWidth(), context.getHeight());
+      renderer.setViewMode(static_cast<Renderer::ViewMode>(options.viewMode));
+      std::error_code error;
+      std::filesystem::create_directories(options.frameDir, error);
+    }
+
+    std::vector<uint8_t> frame;
+    size_t frameCount = 0;
+    auto collectFrames = [&]( bool wait )
+    {
+      uint64_t epoch = 0;
+      while ( context.finishReadback(frame, epoch, wait) )
+      {
+        frameCount += writeFrame(options.frameDir, epoch, frame, context.getWidth(), context.getHeight()) ? 1 : 0;
+      }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for ( uint64_t epoch = 0; epoch < options.epochs; ++epoch )
+    {
+      simulation.update();
+
+      if ( !frames ) continue;
+      collectFrames(false);
+      if ( simulation.getEpoch() % options.frameEvery != 0 ) continue;
+
+      renderer.beginUpload({
+        simulation.getPixels(),
+        simulation.getEpoch(),
+        simulation.getWorldGeneration(),
+        simulation.getTileEpochs(),
+        simulation.getTilesX(),
+        Config::PIXEL_TILE,
+        simulation.getPixelLevels()
+      });
+      renderer.finishUpload();
+      renderer.render(context.getWidth(), context.getHeight());
+      if ( !context.beginReadback(simulation.getEpoch()) )
+      {
+        collectFrames(true);
+        context.beginReadback(simulation.getEpoch());
+      }
+    }
+    if ( frames )
+    {
+      collectFrames(true);
+      renderer.destroy();
+      context.destroy();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // FNV-1a over the final image, to compare runs with different partitioning
+    uint64_t checksum = 0xCBF29CE484222325ull;
+    for ( uint32_t pixel : simulation.getPixels() )
+    {
+      checksum = (checksum ^ pixel) * 0x100000001B3ull;
+    }
+
+    std::cout << "Seed: " << simulation.getSeed() << "\n"
+              << "Processes: " << simulation.getProcessCount() << "\n"
+              << "Epochs: " << simulation.getEpoch() << "\n"
+              << "Alive cells: " << simulation.getAliveCount() << "\n";
+    if ( !simulation.isPartitioned() && simulation.getGrid().hasOrganisms() )
+    {
+      std::cout << "Organisms: " << simulation.getGrid().getOrganisms().getOrganismCount() << "\n";
+    }
+    if ( frames )
+    {
+      std::cout << "Frames: " << frameCount << " in " << options.frameDir << "\n";
+    }
+    std::cout << "Pixel checksum: " << std::hex << checksum << std::dec << "\n"
+              << "Time: " << seconds << " s" << std::endl;
+
+    return 0;
+  }
+
+  int runEnsemble( const LaunchOptions& options )
+  {
+    Ensemble ensemble;
+
+    if ( !ensemble.init(options.replicates, Config::GRID_WIDTH, Config::GRID_HEIGHT, options.threads, options.seed) )
+    {
+      std::cerr << "Failed to initialize ensemble" << std::endl;
+      return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for ( uint64_t epoch = 0; epoch < options.epochs; ++epoch )
+    {
+      ensemble.update();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double worldEpochs = static_cast<double>(options.replicates) * options.epochs;
+
+    std::cout << "Replicates: " << options.replicates << " on " << ensemble.getThreadCount() << " threads\n"
+              << "Epochs: " << ensemble.getEpoch() << "\n"
+              << "Alive cells: " << ensemble.countAlive() << "\n"
+              << "Time: " << seconds << " s, " << (seconds > 0.0 ? worldEpochs / seconds : 0.0) << " world-epochs/s" << std::endl;
+
+    return 0;
+  }
+}
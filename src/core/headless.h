@@ -0,0 +1,9 @@
+#pragma once
+#include "launch_options.h"
+
+// Batch runs without a window, for parameter studies and cluster jobs
+namespace Headless
+{
+  int runWorld( const LaunchOptions& options );
+  int runEnsemble( const LaunchOptions& options );
+}
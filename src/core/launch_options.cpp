@@ -0,0 +1,150 @@
+#include "launch_options.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+bool LaunchOptions::parse( int argc, char* argv[] )
+{
+  bool seedGiven = false;
+
+  for ( int i = 1; i < argc; ++i )
+  {
+    const char* arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+    if ( std::strcmp(arg, "--help") == 0 )
+    {
+      return false;
+    }
+
+    if ( std::strcmp(arg, "--headless") == 0 )
+    {
+      headless = true;
+      continue;
+    }
+
+    if ( std::strcmp(arg, "--mlock") == 0 )
+    {
+      memory.lock = true;
+      continue;
+    }
+
+    if ( !value )
+    {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+
+    if ( std::strcmp(arg, "--replicates") == 0 )
+    {
+      replicates = std::atoi(value);
+    }
+    else if ( std::strcmp(arg, "--epochs") == 0 )
+    {
+      epochs = std::strtoull(value, nullptr, 10);
+    }
+    else if ( std::strcmp(arg, "--threads") == 0 )
+    {
+      threads = std::atoi(value);
+    }
+    else if ( std::strcmp(arg, "--processes") == 0 )
+    {
+      processes = std::atoi(value);
+    }
+    else if ( std::strcmp(arg, "--hugepages") == 0 )
+    {
+      if ( std::strcmp(value, "off") == 0 ) memory.hugePages = MappedMemory::HugePages::Off;
+      else if ( std::strcmp(value, "thp") == 0 ) memory.hugePages = MappedMemory::HugePages::Transparent;
+      else if ( std::strcmp(value, "explicit") == 0 ) memory.hugePages = MappedMemory::HugePages::Explicit;
+      else
+      {
+        std::cerr << "Unknown huge page mode: " << value << std::endl;
+        return false;
+      }
+    }
+    else if ( std::strcmp(arg, "--frames") == 0 )
+    {
+      // strtoull takes "abc" for 0 and wraps negative numbers around
+      char* end = nullptr;
+      frameEvery = std::strtoull(value, &end, 10);
+      if ( value[0] < '0' || value[0] > '9' || *end != '\0' || frameEvery == 0 )
+      {
+        std::cerr << "--frames needs a positive number of epochs: " << value << std::endl;
+        return false;
+      }
+    }
+    else if ( std::strcmp(arg, "--frame-dir") == 0 )
+    {
+      frameDir = value;
+    }
+    else if ( std::strcmp(arg, "--view") == 0 )
+    {
+      const char* modes[] = { "types", "genomes", "energy", "age" };
+      viewMode = -1;
+      for ( int mode = 0; mode < 4; ++mode )
+      {
+        if ( std::strcmp(value, modes[mode]) == 0 ) viewMode = mode;
+      }
+      if ( viewMode < 0 )
+      {
+        std::cerr << "Unknown view mode: " << value << std::endl;
+        return false;
+      }
+    }
+    else if ( std::strcmp(arg, "--renderer") == 0 )
+    {
+      if ( std::strcmp(value, "gl") == 0 ) software = false;
+      else if ( std::strcmp(value, "software") == 0 ) software = true;
+      else
+      {
+        std::cerr << "Unknown renderer: " << value << std::endl;
+        return false;
+      }
+    }
+    else if ( std::strcmp(arg, "--seed") == 0 )
+    {
+      seed = std::strtoull(value, nullptr, 10);
+      seedGiven = true;
+    }
+    else
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return false;
+    }
+
+    ++i;
+  }
+
+  // Replicate ensembles render nothing, so frames would be silently lost
+  if ( replicates > 0 && frameEvery > 0 )
+  {
+    std::cerr << "--frames can't be combined with --replicates" << std::endl;
+    return false;
+  }
+
+  if ( !seedGiven )
+  {
+    std::random_device device;
+    seed = (static_cast<uint64_t>(device()) << 32) | device();
+  }
+
+  return replicates >= 0 && threads >= 0 && processes >= 1;
+}
+
+void LaunchOptions::printUsage( const char* program )
+{
+  std::cerr << "Usage: " << program << " [options]\n"
+            << "  --headless       run the world without a window and print its stats\n"
+            << "  --replicates N   run N replicate worlds headless instead of opening a window\n"
+            << "  --epochs N       epochs to run in headless mode (default " << Config::HEADLESS_EPOCHS << ")\n"
+            << "  --threads N      worker threads, 0 = one per hardware thread\n"
+            << "  --processes N    split the world into N slabs owned by worker processes (Linux)\n"
+            << "  --frames N       run headless, rendering a frame every N epochs (needs EGL, not with --replicates)\n"
+            << "  --frame-dir DIR  where the frames go (default " << Config::FRAME_DIR << ")\n"
+            << "  --view M         frame colouring: types (default), genomes, energy or age\n"
+            << "  --renderer R     draw the window with gl or software, on the CPU (default " << (Config::SOFTWARE_RENDERER ? "software" : "gl") << ")\n"
+            << "  --seed N         world seed, random if omitted\n"
+            << "  --hugepages M    grid memory pages: off, thp (default) or explicit (hugetlbfs)\n"
+            << "  --mlock          lock grid memory so it is never paged out\n";
+}
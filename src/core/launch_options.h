@@ -0,0 +1,26 @@
+#pragma once
+#include "config.h"
+#include "../utils/mapped_memory.h"
+#include <cstdint>
+#include <string>
+
+// Command line switches. Without any, the interactive window is started.
+struct LaunchOptions
+{
+  int replicates{ 0 }; // > 0 runs a headless replicate ensemble
+  bool headless{ false };
+  uint64_t epochs{ Config::HEADLESS_EPOCHS };
+  int threads{ Config::WORKER_THREADS };
+  int processes{ 1 };
+  uint64_t seed{ 0 };
+  uint64_t frameEvery{ 0 }; // > 0 renders a headless frame every N epochs
+  std::string frameDir{ Config::FRAME_DIR };
+  int viewMode{ 0 }; // Renderer::ViewMode of the frames
+  bool software{ Config::SOFTWARE_RENDERER }; // window drawn by the CPU, without OpenGL
+  MappedMemory::Settings memory;
+
+  bool parse( int argc, char* argv[] );
+  static void printUsage( const char* program );
+
+  inline bool isHeadless() const { return headless || replicates > 0 || frameEvery > 0; }
+};
@@ -1,5 +1,6 @@
 #include "window.h"
 #include "core/config.h"
+#include "../rendering/gl_extensions.h"
 #include <iostream>
 
 Window::~Window()
@@ -41,6 +42,22 @@ bool Window::init( const char* title, int width, int height, Uint32 windowFlags,
     return false;
   }
 
+  if ( !(windowFlags & SDL_WINDOW_OPENGL) )
+  {
+    // Drawn by the CPU into the window surface, which works over remote X and framebuffers
+    m_sdlRenderer = SDL_CreateRenderer(m_window, -1, SDL_RENDERER_SOFTWARE);
+    if ( !m_sdlRenderer )
+    {
+      std::cerr << "Software renderer creation failed: " << SDL_GetError() << std::endl;
+      SDL_DestroyWindow(m_window);
+      SDL_Quit();
+      return false;
+    }
+
+    m_isRunning = true;
+    return true;
+  }
+
   m_glContext = SDL_GL_CreateContext(m_window);
   if ( !m_glContext )
   {
@@ -53,7 +70,7 @@ bool Window::init( const char* title, int width, int height, Uint32 windowFlags,
   SDL_GL_MakeCurrent(m_window, m_glContext);
   SDL_GL_SetSwapInterval(Config::ENABLE_VSYNC); // VSync
 
-  if ( !gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress) )
+  if ( !GLExtensions::load(SDL_GL_GetProcAddress) )
   {
     std::cerr << "GLAD initialization failed" << std::endl;
     SDL_GL_DeleteContext(m_glContext);
@@ -68,6 +85,18 @@ bool Window::init( const char* title, int width, int height, Uint32 windowFlags,
 
 void Window::destroy()
 {
+  if ( m_frameTexture )
+  {
+    SDL_DestroyTexture(m_frameTexture);
+    m_frameTexture = nullptr;
+  }
+
+  if ( m_sdlRenderer )
+  {
+    SDL_DestroyRenderer(m_sdlRenderer);
+    m_sdlRenderer = nullptr;
+  }
+
   if ( m_glContext )
   {
     SDL_GL_DeleteContext(m_glContext);
@@ -86,10 +115,52 @@ void Window::destroy()
 
 void Window::swapBuffers()
 {
+  if ( m_sdlRenderer )
+  {
+    SDL_RenderPresent(m_sdlRenderer);
+    return;
+  }
   SDL_GL_SwapWindow(m_window);
 }
 
+void Window::drawFrame( const uint32_t* pixels, int width, int height )
+{
+  if ( width <= 0 || height <= 0 )
+  {
+    // Nothing drawn yet
+    SDL_SetRenderDrawColor(m_sdlRenderer, 26, 26, 31, 255);
+    SDL_RenderClear(m_sdlRenderer);
+    return;
+  }
+
+  if ( !m_frameTexture || width != m_frameWidth || height != m_frameHeight )
+  {
+    if ( m_frameTexture ) SDL_DestroyTexture(m_frameTexture);
+    m_frameTexture = SDL_CreateTexture(m_sdlRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if ( !m_frameTexture )
+    {
+      std::cerr << "Frame texture creation failed: " << SDL_GetError() << std::endl;
+      return;
+    }
+    m_frameWidth = width;
+    m_frameHeight = height;
+  }
+
+  SDL_UpdateTexture(m_frameTexture, nullptr, pixels, width * static_cast<int>(sizeof(uint32_t)));
+  SDL_RenderCopy(m_sdlRenderer, m_frameTexture, nullptr, nullptr);
+}
+
 void Window::getFramebufferSize( int& width, int& height )
 {
+  if ( m_sdlRenderer )
+  {
+    SDL_GetRendererOutputSize(m_sdlRenderer, &width, &height);
+    return;
+  }
   SDL_GL_GetDrawableSize(m_window, &width, &height);
 }
+
+void Window::getWindowSize( int& width, int& height )
+{
+  SDL_GetWindowSize(m_window, &width, &height);
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <SDL.h>
 #include <glad/glad.h>
+#include <cstdint>
 #include <string>
 
 class Window
@@ -9,21 +10,34 @@ class Window
   Window() = default;
   ~Window();
 
+  // Without SDL_WINDOW_OPENGL in windowFlags the window gets a software
+  // SDL_Renderer instead of a GL context, and frames come from drawFrame()
   bool init( const char* title, int width, int height, Uint32 windowFlags, Uint32 initFlags );
   void destroy();
   void swapBuffers();
 
+  // Copies an ARGB8888 frame to the software renderer, stretched to the
+  // window if its size is out of date
+  void drawFrame( const uint32_t* pixels, int width, int height );
+
   inline bool isRunning() const { return m_isRunning; }
   inline int getWidth() const { return m_width; }
   inline int getHeight() const { return m_height; }
   inline SDL_Window* getSDLWindow() { return m_window; }
   inline SDL_GLContext getGLContext() { return m_glContext; }
+  inline SDL_Renderer* getSDLRenderer() { return m_sdlRenderer; }
 
   void getFramebufferSize( int& width, int& height );
+  // In the units of mouse events, which on HiDPI displays differ from framebuffer pixels
+  void getWindowSize( int& width, int& height );
 
   private:
   SDL_Window* m_window{ nullptr };
   SDL_GLContext m_glContext{ nullptr };
+  SDL_Renderer* m_sdlRenderer{ nullptr };
+  SDL_Texture* m_frameTexture{ nullptr };
+  int m_frameWidth{ 0 };
+  int m_frameHeight{ 0 };
 
   int m_width{ 0 };
   int m_height{ 0 };
@@ -1,11 +1,33 @@
 #include "core/application.h"
+#include "core/headless.h"
+#include "core/launch_options.h"
 #include <iostream>
 
 int main( int argc, char* argv[] )
 {
+  LaunchOptions options;
+
+  if ( !options.parse(argc, argv) )
+  {
+    LaunchOptions::printUsage(argv[0]);
+    return 1;
+  }
+
+  MappedMemory::configure(options.memory);
+
+  if ( options.replicates > 0 )
+  {
+    return Headless::runEnsemble(options);
+  }
+
+  if ( options.isHeadless() )
+  {
+    return Headless::runWorld(options);
+  }
+
   Application app;
 
-  if ( !app.init() )
+  if ( !app.init(options) )
   {
     std::cerr << "Failed to initialize application" << std::endl;
     return 1;
@@ -0,0 +1,33 @@
+#include "gl_extensions.h"
+#include <cstring>
+
+namespace GLExtensions
+{
+  namespace
+  {
+    ProcLoader s_loader = nullptr;
+  }
+
+  bool load( ProcLoader loader )
+  {
+    s_loader = loader;
+    return gladLoadGLLoader(reinterpret_cast<GLADloadproc>(loader)) != 0;
+  }
+
+  bool isSupported( const char* extension )
+  {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for ( GLint i = 0; i < count; ++i )
+    {
+      const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+      if ( name && std::strcmp(name, extension) == 0 ) return true;
+    }
+    return false;
+  }
+
+  void* getProcAddress( const char* name )
+  {
+    return s_loader ? s_loader(name) : nullptr;
+  }
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <glad/glad.h>
+
+// The loader the GL functions came from, kept for entry points past the GL
+// 3.3 the loader is generated for. The window loads through SDL, headless
+// runs through EGL; nothing here needs either.
+namespace GLExtensions
+{
+  using ProcLoader = void* (*)( const char* name );
+
+  // Loads the GL 3.3 functions for the current context
+  bool load( ProcLoader loader );
+
+  bool isSupported( const char* extension );
+  // nullptr before load() or for unknown names
+  void* getProcAddress( const char* name );
+}
@@ -0,0 +1,215 @@
+#include "offscreen_context.h"
+#include "gl_extensions.h"
+#include <cstring>
+#include <iostream>
+
+#if defined(HAVE_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace
+{
+#if defined(HAVE_EGL)
+  void* getEglProcAddress( const char* name )
+  {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+  }
+
+  // A display with no window system: surfaceless where Mesa offers it, the
+  // default display otherwise
+  EGLDisplay openDisplay()
+  {
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if ( extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless") )
+    {
+      auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+      if ( getPlatformDisplay )
+      {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if ( display != EGL_NO_DISPLAY ) return display;
+      }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+#endif
+}
+
+OffscreenContext::~OffscreenContext()
+{
+  destroy();
+}
+
+bool OffscreenContext::init( int width, int height )
+{
+  destroy();
+  m_width = width;
+  m_height = height;
+
+#if defined(HAVE_EGL)
+  EGLDisplay display = openDisplay();
+  EGLint major = 0;
+  EGLint minor = 0;
+  if ( display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) )
+  {
+    std::cerr << "EGL initialization failed" << std::endl;
+    return false;
+  }
+  m_display = display;
+
+  // OpenGL 3.3 Core Profile, like the window, and no surface at all
+  const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+  EGLConfig config = nullptr;
+  EGLint configCount = 0;
+  eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+  const EGLint contextAttributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+  EGLContext context = EGL_NO_CONTEXT;
+  if ( eglBindAPI(EGL_OPENGL_API) )
+  {
+    context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+  }
+  if ( context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) )
+  {
+    std::cerr << "EGL context creation failed: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+    if ( context != EGL_NO_CONTEXT ) eglDestroyContext(display, context);
+    destroy();
+    return false;
+  }
+  m_context = context;
+
+  if ( !GLExtensions::load(getEglProcAddress) )
+  {
+    std::cerr << "GLAD initialization failed" << std::endl;
+    destroy();
+    return false;
+  }
+
+  // Everything is drawn into this
+  glGenRenderbuffers(1, &m_colour);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_colour);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glGenFramebuffers(1, &m_framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colour);
+  if ( glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE )
+  {
+    std::cerr << "Offscreen framebuffer incomplete" << std::endl;
+    destroy();
+    return false;
+  }
+  glViewport(0, 0, width, height);
+
+  const GLsizeiptr bytes = static_cast<GLsizeiptr>(width) * height * 4;
+  for ( ReadBuffer& slot : m_ring )
+  {
+    glGenBuffers(1, &slot.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  return true;
+#else
+  std::cerr << "Offscreen rendering needs a build with EGL" << std::endl;
+  return false;
+#endif
+}
+
+void OffscreenContext::destroy()
+{
+#if defined(HAVE_EGL)
+  if ( m_context )
+  {
+    destroyTargets();
+    eglMakeCurrent(static_cast<EGLDisplay>(m_display), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(static_cast<EGLDisplay>(m_display), static_cast<EGLContext>(m_context));
+    m_context = nullptr;
+  }
+  if ( m_display )
+  {
+    eglTerminate(static_cast<EGLDisplay>(m_display));
+    m_display = nullptr;
+  }
+#endif
+  m_pendingCount = 0;
+  m_next = 0;
+}
+
+void OffscreenContext::destroyTargets()
+{
+  for ( ReadBuffer& slot : m_ring )
+  {
+    if ( slot.fence ) glDeleteSync(slot.fence);
+    if ( slot.buffer != 0 ) glDeleteBuffers(1, &slot.buffer);
+    slot = ReadBuffer();
+  }
+  if ( m_framebuffer != 0 )
+  {
+    glDeleteFramebuffers(1, &m_framebuffer);
+    m_framebuffer = 0;
+  }
+  if ( m_colour != 0 )
+  {
+    glDeleteRenderbuffers(1, &m_colour);
+    m_colour = 0;
+  }
+}
+
+bool OffscreenContext::beginReadback( uint64_t tag )
+{
+  if ( !m_context || m_pendingCount == RING_SIZE ) return false;
+
+  // Into the buffer; the call returns before the copy is done
+  ReadBuffer& slot = m_ring[m_next];
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.tag = tag;
+  glFlush();
+
+  m_next = (m_next + 1) % RING_SIZE;
+  m_pendingCount++;
+  return true;
+}
+
+bool OffscreenContext::finishReadback( std::vector<uint8_t>& pixels, uint64_t& tag, bool wait )
+{
+  if ( m_pendingCount == 0 ) return false;
+
+  ReadBuffer& slot = m_ring[(m_next + RING_SIZE - m_pendingCount) % RING_SIZE];
+  GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  while ( wait && status == GL_TIMEOUT_EXPIRED )
+  {
+    status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+  }
+  if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED ) return false;
+
+  // GL rows run bottom up
+  const size_t rowBytes = static_cast<size_t>(m_width) * 4;
+  pixels.resize(rowBytes * m_height);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  const uint8_t* mapped = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(pixels.size()), GL_MAP_READ_BIT));
+  if ( mapped )
+  {
+    for ( int y = 0; y < m_height; ++y )
+    {
+      std::memcpy(pixels.data() + static_cast<size_t>(y) * rowBytes, mapped + static_cast<size_t>(m_height - 1 - y) * rowBytes, rowBytes);
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  tag = slot.tag;
+  m_pendingCount--;
+  return mapped != nullptr;
+}
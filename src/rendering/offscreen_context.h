@@ -0,0 +1,59 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A GL context without a window, for rendering frames in headless runs. It
+// is a surfaceless EGL context (Mesa's llvmpipe is enough) drawing into an
+// RGBA8 framebuffer object. Frames are read back through a ring of pixel
+// buffers: beginReadback() only queues the copy, and the pixels are taken
+// once its fence has passed, so the simulation keeps running meanwhile.
+// Needs EGL at build time; without it init() fails.
+class OffscreenContext
+{
+  public:
+  static constexpr size_t RING_SIZE = 3;
+
+  OffscreenContext() = default;
+  ~OffscreenContext();
+
+  OffscreenContext( const OffscreenContext& ) = delete;
+  OffscreenContext& operator=( const OffscreenContext& ) = delete;
+
+  // Creates the context, makes it current and binds the framebuffer
+  bool init( int width, int height );
+  void destroy();
+
+  // Queues a copy of the framebuffer, tagged for finishReadback(); false
+  // while every buffer of the ring still holds an unread frame
+  bool beginReadback( uint64_t tag );
+  // The oldest queued frame, top row first, 4 bytes per pixel. Without
+  // wait it returns false until the copy is done.
+  bool finishReadback( std::vector<uint8_t>& pixels, uint64_t& tag, bool wait );
+  inline bool hasPendingReadback() const { return m_pendingCount > 0; }
+
+  inline int getWidth() const { return m_width; }
+  inline int getHeight() const { return m_height; }
+
+  private:
+  struct ReadBuffer
+  {
+    GLuint buffer{ 0 };
+    GLsync fence{ nullptr };
+    uint64_t tag{ 0 };
+  };
+
+  void* m_display{ nullptr };
+  void* m_context{ nullptr };
+  GLuint m_framebuffer{ 0 };
+  GLuint m_colour{ 0 };
+  std::array<ReadBuffer, RING_SIZE> m_ring;
+  size_t m_next{ 0 };
+  size_t m_pendingCount{ 0 };
+  int m_width{ 0 };
+  int m_height{ 0 };
+
+  void destroyTargets();
+};
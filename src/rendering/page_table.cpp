@@ -0,0 +1,150 @@
+#include "page_table.h"
+#include <algorithm>
+
+void PageTable::init( int gridWidth, int gridHeight, int pageWidth, int pageHeight, int slotsX, int slotsY )
+{
+  m_pageWidth = pageWidth;
+  m_pageHeight = pageHeight;
+  m_pagesX = (gridWidth + pageWidth - 1) / pageWidth;
+  m_pagesY = (gridHeight + pageHeight - 1) / pageHeight;
+  m_slotsX = slotsX;
+
+  const size_t pages = static_cast<size_t>(m_pagesX) * m_pagesY;
+  const size_t slots = static_cast<size_t>(slotsX) * slotsY;
+  m_pageSlot.assign(pages, NONE);
+  m_entries.assign(pages, MISSING);
+  m_slotPage.assign(slots, NONE);
+  m_slotUsed.assign(slots, 0);
+  m_slotLoaded.assign(slots, 0);
+  m_pending.clear();
+  m_loaded.clear();
+  m_frame = 0;
+  m_missing = 0;
+}
+
+void PageTable::update( const Texture::Rect& view, const Texture::Rect& prefetch )
+{
+  m_frame++;
+
+  // Pages under the view first, then the ones only the prefetch rect covers
+  m_wanted.clear();
+  collectPages(view, { 0, 0, 0, 0 });
+  const size_t visible = m_wanted.size();
+  collectPages(prefetch, view);
+
+  m_missing = 0;
+  for ( size_t i = 0; i < m_wanted.size(); ++i )
+  {
+    if ( !makeResident(m_wanted[i]) && i < visible ) m_missing++;
+  }
+  rebuildLists();
+}
+
+void PageTable::invalidate()
+{
+  for ( int slot = 0; slot < getSlotCount(); ++slot )
+  {
+    if ( m_slotPage[slot] == NONE ) continue;
+    m_slotLoaded[slot] = 0;
+    m_entries[m_slotPage[slot]] = MISSING;
+  }
+  rebuildLists();
+}
+
+void PageTable::markLoaded()
+{
+  for ( int page : m_pending )
+  {
+    const int slot = m_pageSlot[page];
+    m_slotLoaded[slot] = 1;
+    m_entries[page] = static_cast<uint32_t>(slot) + 1;
+  }
+  rebuildLists();
+}
+
+Texture::Rect PageTable::getPageRect( int page ) const
+{
+  return { (page % m_pagesX) * m_pageWidth, (page / m_pagesX) * m_pageHeight, m_pageWidth, m_pageHeight };
+}
+
+void PageTable::collectPages( const Texture::Rect& rect, const Texture::Rect& skip )
+{
+  const int x0 = std::clamp(rect.x / m_pageWidth, 0, m_pagesX);
+  const int y0 = std::clamp(rect.y / m_pageHeight, 0, m_pagesY);
+  const int x1 = std::clamp((rect.x + rect.width + m_pageWidth - 1) / m_pageWidth, 0, m_pagesX);
+  const int y1 = std::clamp((rect.y + rect.height + m_pageHeight - 1) / m_pageHeight, 0, m_pagesY);
+  if ( rect.width <= 0 || rect.height <= 0 || x0 >= x1 || y0 >= y1 ) return;
+
+  const int sx0 = skip.x / m_pageWidth;
+  const int sy0 = skip.y / m_pageHeight;
+  const int sx1 = (skip.x + skip.width + m_pageWidth - 1) / m_pageWidth;
+  const int sy1 = (skip.y + skip.height + m_pageHeight - 1) / m_pageHeight;
+
+  const size_t begin = m_wanted.size();
+  for ( int y = y0; y < y1; ++y )
+  {
+    for ( int x = x0; x < x1; ++x )
+    {
+      if ( skip.width > 0 && x >= sx0 && x < sx1 && y >= sy0 && y < sy1 ) continue;
+      m_wanted.push_back(y * m_pagesX + x);
+    }
+  }
+
+  // Nearest the centre of rect first, so a view larger than the atlas keeps its middle
+  const float cx = (rect.x + rect.width * 0.5f) / m_pageWidth - 0.5f;
+  const float cy = (rect.y + rect.height * 0.5f) / m_pageHeight - 0.5f;
+  auto distance = [&]( int page )
+  {
+    const float dx = page % m_pagesX - cx;
+    const float dy = page / m_pagesX - cy;
+    return dx * dx + dy * dy;
+  };
+  std::stable_sort(m_wanted.begin() + begin, m_wanted.end(), [&]( int a, int b ) { return distance(a) < distance(b); });
+}
+
+bool PageTable::makeResident( int page )
+{
+  if ( m_pageSlot[page] != NONE )
+  {
+    m_slotUsed[m_pageSlot[page]] = m_frame;
+    return true;
+  }
+
+  // A free slot, or the one whose page was wanted longest ago but not this frame
+  int best = NONE;
+  for ( int slot = 0; slot < getSlotCount(); ++slot )
+  {
+    if ( m_slotPage[slot] == NONE )
+    {
+      best = slot;
+      break;
+    }
+    if ( m_slotUsed[slot] < m_frame && (best == NONE || m_slotUsed[slot] < m_slotUsed[best]) )
+    {
+      best = slot;
+    }
+  }
+  if ( best == NONE ) return false;
+
+  if ( m_slotPage[best] != NONE )
+  {
+    m_pageSlot[m_slotPage[best]] = NONE;
+    m_entries[m_slotPage[best]] = MISSING;
+  }
+  m_slotPage[best] = page;
+  m_pageSlot[page] = best;
+  m_slotUsed[best] = m_frame;
+  m_slotLoaded[best] = 0;
+  return true;
+}
+
+void PageTable::rebuildLists()
+{
+  m_pending.clear();
+  m_loaded.clear();
+  for ( int slot = 0; slot < getSlotCount(); ++slot )
+  {
+    if ( m_slotPage[slot] == NONE ) continue;
+    (m_slotLoaded[slot] ? m_loaded : m_pending).push_back(m_slotPage[slot]);
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "texture.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Which pages of the grid live in the atlas texture. The grid is cut into
+// pages of the atlas' slot size; update() gives a slot to every page under
+// the view, nearest the centre first, then to the pages the prefetch rect
+// adds while slots are left, evicting the page least recently wanted. A
+// page given a slot stays pending until its pixels were uploaded, and only
+// loaded pages appear in the table the shader reads, so an upload that is
+// skipped leaves the old page visible rather than a half-filled slot. A
+// grid that fits in the atlas is a single page.
+class PageTable
+{
+  public:
+  static constexpr uint32_t MISSING = 0; // table entry of a page without a loaded slot
+
+  PageTable() = default;
+
+  void init( int gridWidth, int gridHeight, int pageWidth, int pageHeight, int slotsX, int slotsY );
+
+  // Rects in cells; prefetch should contain view
+  void update( const Texture::Rect& view, const Texture::Rect& prefetch );
+  // Every resident page needs uploading again
+  void invalidate();
+  // The pending pages' pixels are on their way
+  void markLoaded();
+
+  inline std::span<const int> getPending() const { return m_pending; }
+  inline std::span<const int> getLoaded() const { return m_loaded; }
+  // Slot + 1 of every loaded page, or MISSING
+  inline std::span<const uint32_t> getEntries() const { return m_entries; }
+
+  Texture::Rect getPageRect( int page ) const;
+  inline int getSlot( int page ) const { return m_pageSlot[page]; }
+  inline int getSlotX( int slot ) const { return (slot % m_slotsX) * m_pageWidth; }
+  inline int getSlotY( int slot ) const { return (slot / m_slotsX) * m_pageHeight; }
+
+  inline int getPageWidth() const { return m_pageWidth; }
+  inline int getPageHeight() const { return m_pageHeight; }
+  inline int getPagesX() const { return m_pagesX; }
+  inline int getPagesY() const { return m_pagesY; }
+  inline int getSlotsX() const { return m_slotsX; }
+  inline int getSlotCount() const { return static_cast<int>(m_slotPage.size()); }
+  // Pages under the last view that got no slot
+  inline size_t getMissingCount() const { return m_missing; }
+
+  private:
+  static constexpr int NONE = -1;
+
+  int m_pageWidth{ 0 };
+  int m_pageHeight{ 0 };
+  int m_pagesX{ 0 };
+  int m_pagesY{ 0 };
+  int m_slotsX{ 0 };
+
+  std::vector<int> m_pageSlot;
+  std::vector<int> m_slotPage;
+  std::vector<uint64_t> m_slotUsed; // frame the slot's page was last wanted
+  std::vector<uint8_t> m_slotLoaded;
+  std::vector<uint32_t> m_entries;
+  std::vector<int> m_pending;
+  std::vector<int> m_loaded;
+  std::vector<int> m_wanted;
+  uint64_t m_frame{ 0 };
+  size_t m_missing{ 0 };
+
+  void collectPages( const Texture::Rect& rect, const Texture::Rect& skip );
+  bool makeResident( int page );
+  void rebuildLists();
+};
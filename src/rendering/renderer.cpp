@@ -1,6 +1,61 @@
 #include "renderer.h"
+#include "view_colours.h"
+#include "core/config.h"
+#include "simulation/cell_view.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
 
+namespace
+{
+  // Frames of camera motion the page prefetch looks ahead
+  constexpr float PREFETCH_FRAMES = 8.0f;
+
+  // Uniform slots of grid.vert/.frag and overlay.vert/.frag, in the order of their names
+  enum GridUniform
+  {
+    GRID_CELLS,
+    GRID_LUT,
+    GRID_VIEW_MODE,
+    GRID_HIGHLIGHT,
+    GRID_PAGES,
+    GRID_GRID_SIZE,
+    GRID_LEVEL,
+    GRID_PAGE_SIZE,
+    GRID_SLOTS_X,
+    GRID_MVP
+  };
+
+  enum OverlayUniform
+  {
+    OVERLAY_CELLS,
+    OVERLAY_PAGES,
+    OVERLAY_GRID_SIZE,
+    OVERLAY_PAGE_SIZE,
+    OVERLAY_SLOTS_X,
+    OVERLAY_ORIGIN,
+    OVERLAY_COLUMNS,
+    OVERLAY_CELL_PIXELS,
+    OVERLAY_MVP
+  };
+
+  // Hot reload follows the sources in the tree; the copy next to the binary
+  // is only refreshed when the program is linked again
+  std::string getShaderDir()
+  {
+#ifdef GENXIDE_SHADER_SOURCE_DIR
+    std::error_code error;
+    if ( Config::SHADER_HOT_RELOAD && std::filesystem::is_directory(GENXIDE_SHADER_SOURCE_DIR, error) )
+    {
+      return GENXIDE_SHADER_SOURCE_DIR;
+    }
+#endif
+    return "shaders";
+  }
+}
+
 Renderer::~Renderer()
 {
   destroy();
@@ -12,28 +67,71 @@ bool Renderer::init( int gridWidth, int gridHeight )
   m_gridHeight = gridHeight;
 
   // Load shader
-  if ( !m_shader.loadFromFiles("shaders/grid.vert", "shaders/grid.frag") )
+  const std::string shaderDir = getShaderDir();
+  m_shader.setUniformNames({ "uCells", "uLut", "uViewMode", "uHighlight", "uPages", "uGridSize", "uLevel", "uPageSize", "uSlotsX", "uMVP" });
+  m_overlayShader.setUniformNames({ "uCells", "uPages", "uGridSize", "uPageSize", "uSlotsX", "uOrigin", "uColumns", "uCellPixels", "uMVP" });
+  if ( !m_shader.loadFromFiles((shaderDir + "/grid.vert").c_str(), (shaderDir + "/grid.frag").c_str())
+    || !m_overlayShader.loadFromFiles((shaderDir + "/overlay.vert").c_str(), (shaderDir + "/overlay.frag").c_str()) )
   {
     std::cerr << "Failed to load shader" << std::endl;
     return false;
   }
 
-  // Create grid texture
-  if ( !m_gridTexture.create(gridWidth, gridHeight, GL_RGBA) )
+  GLint maxSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  m_atlasSize = std::min(Config::ATLAS_SIZE, static_cast<int>(maxSize));
+  m_level = 0;
+  m_uploadedLevel = 0;
+  initPages(gridWidth, gridHeight);
+  m_uploadedPageWidth = m_pages.getPageWidth();
+  m_uploadedPageHeight = m_pages.getPageHeight();
+  m_uploadedSlotsX = m_pages.getSlotsX();
+  const int atlasWidth = m_pages.getSlotsX() * m_pages.getPageWidth();
+  const int atlasHeight = m_pages.getSlotCount() / m_pages.getSlotsX() * m_pages.getPageHeight();
+
+  // Create grid texture, one packed cell view per texel, and the page table
+  if ( !m_gridTexture.create(atlasWidth, atlasHeight, GL_RED_INTEGER, GL_UNSIGNED_INT)
+    || !m_pageTexture.create(m_pages.getPagesX(), m_pages.getPagesY(), GL_RED_INTEGER, GL_UNSIGNED_INT) )
   {
     std::cerr << "Failed to create grid texture" << std::endl;
     return false;
   }
 
+  if ( Config::SHADER_HOT_RELOAD )
+  {
+    m_shaderWatcher.init(shaderDir.c_str());
+  }
+  m_overlayEnabled = Config::CELL_OVERLAY;
+
   // Initialize camera at grid center
   m_camera = Camera2D(
     gridWidth * 0.5f,
     gridHeight * 0.5f,
     2.0f / gridHeight
   );
+  m_lastCameraX = m_camera.getX();
+  m_lastCameraY = m_camera.getY();
 
   // Create quad geometry
   createQuadGeometry();
+  createLut();
+  glGenVertexArrays(1, &m_overlayVao);
+
+  return true;
+}
+
+bool Renderer::initSoftware( int gridWidth, int gridHeight, size_t threadCount )
+{
+  m_gridWidth = gridWidth;
+  m_gridHeight = gridHeight;
+  m_software = true;
+  m_rasterizer.init(gridWidth, gridHeight, threadCount);
+
+  m_camera = Camera2D(
+    gridWidth * 0.5f,
+    gridHeight * 0.5f,
+    2.0f / gridHeight
+  );
 
   return true;
 }
@@ -58,14 +156,35 @@ void Renderer::destroy()
     m_ebo = 0;
   }
 
+  if ( m_overlayVao != 0 )
+  {
+    glDeleteVertexArrays(1, &m_overlayVao);
+    m_overlayVao = 0;
+  }
+
+  if ( m_lut != 0 )
+  {
+    glDeleteTextures(1, &m_lut);
+    m_lut = 0;
+  }
+
   m_gridTexture.destroy();
+  m_pageTexture.destroy();
   m_shader.destroy();
+  m_overlayShader.destroy();
+  m_shaderWatcher.destroy();
 }
 
-void Renderer::render( const Grid& grid, int windowWidth, int windowHeight )
+void Renderer::render( int windowWidth, int windowHeight )
 {
-  // Update texture with grid pixels
-  m_gridTexture.update(grid.getPixels());
+  m_windowWidth = windowWidth;
+  m_windowHeight = windowHeight;
+  if ( m_software ) return;
+
+  if ( m_shaderWatcher.poll() )
+  {
+    reloadShaders();
+  }
 
   // Clear screen
   glClearColor(0.1f, 0.1f, 0.12f, 1.0f);
@@ -80,20 +199,366 @@ void Renderer::render( const Grid& grid, int windowWidth, int windowHeight )
 
   // Use shader and set uniforms
   m_shader.use();
-  m_shader.setInt("uTex", 0);
-  m_shader.setMat4("uMVP", viewMatrix);
+  m_shader.setInt(GRID_CELLS, 0);
+  m_shader.setInt(GRID_LUT, 1);
+  m_shader.setInt(GRID_VIEW_MODE, static_cast<int>(m_viewMode));
+  m_shader.setInt(GRID_HIGHLIGHT, m_highlight);
+  m_shader.setInt(GRID_PAGES, 2);
+  m_shader.setInt2(GRID_GRID_SIZE, m_gridWidth, m_gridHeight);
+  m_shader.setInt(GRID_LEVEL, m_uploadedLevel);
+  m_shader.setInt2(GRID_PAGE_SIZE, m_uploadedPageWidth, m_uploadedPageHeight);
+  m_shader.setInt(GRID_SLOTS_X, m_uploadedSlotsX);
+  m_shader.setMat4(GRID_MVP, viewMatrix);
 
-  // Bind texture
+  // Bind textures
   m_gridTexture.bind(0);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_1D, m_lut);
+  m_pageTexture.bind(2);
 
   // Draw quad
   glBindVertexArray(m_vao);
   glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
   glBindVertexArray(0);
+
+  renderOverlay(viewMatrix);
+}
+
+void Renderer::reloadShaders()
+{
+  // Both are rebuilt, the unchanged one straight from the binary cache; a
+  // program that fails to build keeps running as it was
+  const bool grid = m_shader.reload();
+  const bool overlay = m_overlayShader.reload();
+  m_shaderErrors = !grid || !overlay;
+  m_shaderReloads++;
+}
+
+bool Renderer::wantsOverlay() const
+{
+  return m_overlayEnabled && m_camera.getZoom() * m_windowHeight * 0.5f >= Config::OVERLAY_MIN_CELL_PIXELS;
+}
+
+void Renderer::renderOverlay( const float* viewMatrix )
+{
+  // Culled whole when zoomed out, and until the full views it decodes are up
+  m_overlayCells = 0;
+  if ( !wantsOverlay() || !m_hasUpload || m_uploadedLevel != 0 ) return;
+
+  // Instances for the visible cells only
+  const float aspect = static_cast<float>(m_windowWidth) / static_cast<float>(m_windowHeight);
+  const float halfWidth = aspect / m_camera.getZoom();
+  const float halfHeight = 1.0f / m_camera.getZoom();
+  const int left = std::max(static_cast<int>(std::floor(m_camera.getX() - halfWidth)), 0);
+  const int top = std::max(static_cast<int>(std::floor(m_camera.getY() - halfHeight)), 0);
+  const int right = std::min(static_cast<int>(std::ceil(m_camera.getX() + halfWidth)), m_gridWidth);
+  const int bottom = std::min(static_cast<int>(std::ceil(m_camera.getY() + halfHeight)), m_gridHeight);
+  if ( right <= left || bottom <= top ) return;
+
+  // The grid pass left the views on unit 0 and the page table on unit 2
+  m_overlayShader.use();
+  m_overlayShader.setInt(OVERLAY_CELLS, 0);
+  m_overlayShader.setInt(OVERLAY_PAGES, 2);
+  m_overlayShader.setInt2(OVERLAY_GRID_SIZE, m_gridWidth, m_gridHeight);
+  m_overlayShader.setInt2(OVERLAY_PAGE_SIZE, m_uploadedPageWidth, m_uploadedPageHeight);
+  m_overlayShader.setInt(OVERLAY_SLOTS_X, m_uploadedSlotsX);
+  m_overlayShader.setInt2(OVERLAY_ORIGIN, left, top);
+  m_overlayShader.setInt(OVERLAY_COLUMNS, right - left);
+  m_overlayShader.setFloat(OVERLAY_CELL_PIXELS, m_camera.getZoom() * m_windowHeight * 0.5f);
+  m_overlayShader.setMat4(OVERLAY_MVP, viewMatrix);
+
+  m_overlayCells = static_cast<size_t>(right - left) * (bottom - top);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glBindVertexArray(m_overlayVao);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_overlayCells));
+  glBindVertexArray(0);
+  glDisable(GL_BLEND);
+}
+
+void Renderer::beginUpload( const PixelUpdate& update )
+{
+  if ( m_software )
+  {
+    // The camera may move before the pixels change, so every frame is drawn
+    m_pendingUpdate = update;
+    m_hasPendingUpdate = true;
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  selectLevel(update);
+  updatePages();
+
+  if ( !m_hasUpload || update.generation != m_uploadedGeneration || (update.tileEpochs.empty() && update.epoch != m_uploadedEpoch) )
+  {
+    m_pages.invalidate();
+  }
+  collectRects(update);
+  const std::span<const uint32_t> views = m_level == 0 ? update.pixels : update.levels[m_level - 1];
+
+  // Each rect lies within one page; place it in that page's slot
+  m_regions.clear();
+  for ( const Texture::Rect& rect : m_rects )
+  {
+    const int pageX = rect.x / m_pages.getPageWidth();
+    const int pageY = rect.y / m_pages.getPageHeight();
+    const int slot = m_pages.getSlot(pageY * m_pages.getPagesX() + pageX);
+    const int x = m_pages.getSlotX(slot) + rect.x - pageX * m_pages.getPageWidth();
+    const int y = m_pages.getSlotY(slot) + rect.y - pageY * m_pages.getPageHeight();
+    m_regions.push_back({ { x, y, rect.width, rect.height }, rect.x, rect.y });
+  }
+
+  m_uploadBytes = 0;
+  m_uploadRects = 0;
+  if ( !m_regions.empty() )
+  {
+    m_gridTexture.update(views.data(), m_levelWidth, m_regions);
+    for ( const Texture::Rect& rect : m_rects )
+    {
+      m_uploadBytes += static_cast<size_t>(rect.width) * rect.height * sizeof(uint32_t);
+    }
+    m_uploadRects = m_rects.size();
+    m_hasUpload = true;
+    m_uploadedEpoch = update.epoch;
+    m_uploadedGeneration = update.generation;
+    m_pages.markLoaded();
+    m_pagesPending = true;
+    m_uploadedLevel = m_level;
+    m_uploadedPageWidth = m_pages.getPageWidth();
+    m_uploadedPageHeight = m_pages.getPageHeight();
+    m_uploadedSlotsX = m_pages.getSlotsX();
+  }
+
+  m_beginSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Renderer::initPages( int width, int height )
+{
+  // A grid that fits is one page; a larger one is paged through an atlas
+  m_levelWidth = width;
+  m_levelHeight = height;
+  if ( width <= m_atlasSize && height <= m_atlasSize )
+  {
+    m_pages.init(width, height, width, height, 1, 1);
+  }
+  else
+  {
+    const int slots = m_atlasSize / Config::TEXTURE_PAGE;
+    m_pages.init(width, height, Config::TEXTURE_PAGE, Config::TEXTURE_PAGE, slots, slots);
+  }
+}
+
+int Renderer::getWantedLevel( const PixelUpdate& update ) const
+{
+  // The coarsest level whose texels are still no larger than a screen pixel
+  const float cellsPerPixel = 2.0f / (m_camera.getZoom() * std::max(m_windowHeight, 1));
+  const int coarsest = cellsPerPixel >= 2.0f ? static_cast<int>(std::floor(std::log2(cellsPerPixel))) : 0;
+  return std::min(coarsest, static_cast<int>(update.levels.size()));
+}
+
+void Renderer::selectLevel( const PixelUpdate& update )
+{
+  const int level = getWantedLevel(update);
+  if ( level == m_level ) return;
+
+  // Everything is laid out afresh for the new size
+  m_level = level;
+  const int scale = 1 << level;
+  initPages((m_gridWidth + scale - 1) / scale, (m_gridHeight + scale - 1) / scale);
+}
+
+void Renderer::updatePages()
+{
+  // The cells under the window, and where the camera's motion takes them
+  const float aspect = m_windowHeight > 0 ? static_cast<float>(m_windowWidth) / m_windowHeight : 1.0f;
+  const float halfWidth = aspect / m_camera.getZoom();
+  const float halfHeight = 1.0f / m_camera.getZoom();
+  const float dx = (m_camera.getX() - m_lastCameraX) * PREFETCH_FRAMES;
+  const float dy = (m_camera.getY() - m_lastCameraY) * PREFETCH_FRAMES;
+  m_lastCameraX = m_camera.getX();
+  m_lastCameraY = m_camera.getY();
+
+  // Cells to texels of the level
+  const float scale = static_cast<float>(1 << m_level);
+  auto toRect = [&]( float x0, float y0, float x1, float y1 ) -> Texture::Rect
+  {
+    const float width = static_cast<float>(m_levelWidth);
+    const float height = static_cast<float>(m_levelHeight);
+    const int left = static_cast<int>(std::clamp(std::floor(x0 / scale), 0.0f, width));
+    const int top = static_cast<int>(std::clamp(std::floor(y0 / scale), 0.0f, height));
+    const int right = static_cast<int>(std::clamp(std::ceil(x1 / scale), 0.0f, width));
+    const int bottom = static_cast<int>(std::clamp(std::ceil(y1 / scale), 0.0f, height));
+    return { left, top, right - left, bottom - top };
+  };
+
+  const float x0 = m_camera.getX() - halfWidth;
+  const float y0 = m_camera.getY() - halfHeight;
+  const float x1 = m_camera.getX() + halfWidth;
+  const float y1 = m_camera.getY() + halfHeight;
+  const Texture::Rect view = toRect(x0, y0, x1, y1);
+
+  // A page of margin all round, stretched along the motion
+  const float marginX = m_pages.getPageWidth() * scale;
+  const float marginY = m_pages.getPageHeight() * scale;
+  const Texture::Rect prefetch = toRect(
+    std::min(x0, x0 + dx) - marginX, std::min(y0, y0 + dy) - marginY,
+    std::max(x1, x1 + dx) + marginX, std::max(y1, y1 + dy) + marginY);
+
+  m_pages.update(view, prefetch);
+}
+
+void Renderer::collectRects( const PixelUpdate& update )
+{
+  // Pages new to their slot go up whole
+  m_rects.clear();
+  for ( int page : m_pages.getPending() )
+  {
+    m_rects.push_back(clipToGrid(m_pages.getPageRect(page)));
+  }
+  if ( update.epoch == m_uploadedEpoch || m_pages.getLoaded().empty() ) return;
+
+  // Loaded pages only where they changed; once a texel spans a tile the
+  // level is small enough to send whole
+  m_dirty.clear();
+  if ( (1 << m_level) >= update.tileSize )
+  {
+    m_dirty.push_back({ 0, 0, m_levelWidth, m_levelHeight });
+  }
+  else
+  {
+    collectDirtyRects(update);
+  }
+  std::span<const uint32_t> entries = m_pages.getEntries();
+  for ( const Texture::Rect& rect : m_dirty )
+  {
+    const int x0 = rect.x / m_pages.getPageWidth();
+    const int y0 = rect.y / m_pages.getPageHeight();
+    const int x1 = (rect.x + rect.width - 1) / m_pages.getPageWidth();
+    const int y1 = (rect.y + rect.height - 1) / m_pages.getPageHeight();
+    for ( int y = y0; y <= y1; ++y )
+    {
+      for ( int x = x0; x <= x1; ++x )
+      {
+        const int page = y * m_pages.getPagesX() + x;
+        if ( entries[page] == PageTable::MISSING ) continue;
+
+        const Texture::Rect area = clipToGrid(m_pages.getPageRect(page));
+        const int left = std::max(rect.x, area.x);
+        const int top = std::max(rect.y, area.y);
+        const int right = std::min(rect.x + rect.width, area.x + area.width);
+        const int bottom = std::min(rect.y + rect.height, area.y + area.height);
+        m_rects.push_back({ left, top, right - left, bottom - top });
+      }
+    }
+  }
+}
+
+Texture::Rect Renderer::clipToGrid( const Texture::Rect& rect ) const
+{
+  return { rect.x, rect.y, std::min(rect.width, m_levelWidth - rect.x), std::min(rect.height, m_levelHeight - rect.y) };
+}
+
+void Renderer::collectDirtyRects( const PixelUpdate& update )
+{
+  // Runs of dirty tiles along each tile row, extended downwards while the
+  // next row has a run with the same columns
+  struct Run
+  {
+    int begin;
+    int end;
+    int top;
+  };
+
+  const int tilesX = update.tilesX;
+  const int tilesY = static_cast<int>(update.tileEpochs.size()) / tilesX;
+  std::vector<Run> open;
+  std::vector<Run> next;
+
+  // Tiles are in cells, rects in texels of the level
+  const int scale = 1 << m_level;
+  auto emit = [&]( const Run& run, int bottom )
+  {
+    const int x = run.begin * update.tileSize / scale;
+    const int y = run.top * update.tileSize / scale;
+    const int right = std::min((run.end * update.tileSize + scale - 1) / scale, m_levelWidth);
+    const int lower = std::min((bottom * update.tileSize + scale - 1) / scale, m_levelHeight);
+    m_dirty.push_back({ x, y, right - x, lower - y });
+  };
+
+  for ( int ty = 0; ty <= tilesY; ++ty )
+  {
+    next.clear();
+    for ( int tx = 0; ty < tilesY && tx < tilesX; )
+    {
+      if ( update.tileEpochs[static_cast<size_t>(ty) * tilesX + tx] <= m_uploadedEpoch )
+      {
+        tx++;
+        continue;
+      }
+
+      Run run{ tx, tx, ty };
+      while ( run.end < tilesX && update.tileEpochs[static_cast<size_t>(ty) * tilesX + run.end] > m_uploadedEpoch )
+      {
+        run.end++;
+      }
+      for ( const Run& above : open )
+      {
+        if ( above.begin == run.begin && above.end == run.end )
+        {
+          run.top = above.top;
+        }
+      }
+      next.push_back(run);
+      tx = run.end;
+    }
+
+    // Runs that did not continue into this row are complete
+    for ( const Run& above : open )
+    {
+      const bool continued = std::any_of(next.begin(), next.end(), [&]( const Run& run )
+      {
+        return run.begin == above.begin && run.end == above.end && run.top == above.top;
+      });
+      if ( !continued )
+      {
+        emit(above, ty);
+      }
+    }
+    open.swap(next);
+  }
+}
+
+void Renderer::finishUpload()
+{
+  if ( m_software )
+  {
+    if ( !m_hasPendingUpdate ) return;
+    m_uploadedLevel = getWantedLevel(m_pendingUpdate);
+    const std::span<const uint32_t> views = m_uploadedLevel == 0 ? m_pendingUpdate.pixels : m_pendingUpdate.levels[m_uploadedLevel - 1];
+    m_rasterizer.draw(views, m_uploadedLevel, m_camera, static_cast<int>(m_viewMode), m_highlight, m_windowWidth, m_windowHeight);
+    m_uploadSeconds = m_rasterizer.getDrawSeconds();
+    m_hasPendingUpdate = false;
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  if ( m_pagesPending )
+  {
+    m_pageTexture.update(m_pages.getEntries().data(), 0, 0, m_pages.getPagesX(), m_pages.getPagesY());
+    m_pagesPending = false;
+  }
+  m_uploadSeconds = m_beginSeconds + std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  m_beginSeconds = 0.0;
 }
 
 void Renderer::handleResize( int windowWidth, int windowHeight )
 {
+  // The pyramid level of an upload follows the window, which may come
+  // before the first render()
+  m_windowWidth = windowWidth;
+  m_windowHeight = windowHeight;
+  if ( m_software ) return;
   glViewport(0, 0, windowWidth, windowHeight);
 }
 
@@ -136,3 +601,18 @@ void Renderer::createQuadGeometry()
 
   glBindVertexArray(0);
 }
+
+void Renderer::createLut()
+{
+  // Heat gradient for the energy and age views
+  uint8_t texels[ViewColours::LUT_SIZE * 4];
+  ViewColours::fillHeatLut(texels);
+
+  glGenTextures(1, &m_lut);
+  glBindTexture(GL_TEXTURE_1D, m_lut);
+  glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, ViewColours::LUT_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_1D, 0);
+}
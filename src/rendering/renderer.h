@@ -1,37 +1,167 @@
 #pragma once
 #include "shader.h"
+#include "shader_watcher.h"
 #include "texture.h"
+#include "page_table.h"
 #include "camera2d.h"
-#include "../simulation/grid.h"
+#include "software_rasterizer.h"
 #include <glad/glad.h>
+#include <cstdint>
+#include <span>
 #include <vector>
 
 class Renderer
 {
   public:
+  // The pixels to show and what changed in them: tileEpochs holds, per tile
+  // of tileSize pixels, the last epoch that changed it (empty when unknown).
+  // levels are the coarser copies of the pixels, each half the size of the
+  // one before (see ViewPyramid), or empty.
+  struct PixelUpdate
+  {
+    std::span<const uint32_t> pixels;
+    uint64_t epoch;
+    uint64_t generation;
+    std::span<const uint64_t> tileEpochs;
+    int tilesX;
+    int tileSize;
+    std::span<const std::span<const uint32_t>> levels;
+  };
+
+  // How grid.frag colours the packed cell views; switching is a uniform change
+  enum class ViewMode
+  {
+    Types = 0,
+    Genomes,
+    Energy,
+    Age
+  };
+
   Renderer() = default;
   ~Renderer();
 
   bool init( int gridWidth, int gridHeight );
+  // No OpenGL: finishUpload() rasterizes the frame on the CPU instead (see
+  // SoftwareRasterizer) for the window to present, and render() only takes
+  // the window size. Camera, view mode, highlight and levels work the same.
+  bool initSoftware( int gridWidth, int gridHeight, size_t threadCount );
   void destroy();
 
-  void render( const Grid& grid, int windowWidth, int windowHeight );
+  // Draws the grid texture as of the last finishUpload()
+  void render( int windowWidth, int windowHeight );
   void handleResize( int windowWidth, int windowHeight );
 
+  // An upload is begun once the frame's UI has run and finished before the
+  // simulation touches the pixels again. Only tiles changed since the last
+  // upload are sent, merged into rectangles, and nothing while the epoch
+  // stands still.
+  void beginUpload( const PixelUpdate& update );
+  void finishUpload();
+
+  // Grids larger than Config::ATLAS_SIZE keep only the pages near the view resident
+  inline bool isPaged() const { return m_pages.getSlotCount() > 1; }
+  inline const PageTable& getPages() const { return m_pages; }
+  // Pyramid level drawn: one texel per 2^level x 2^level cells
+  inline int getLevel() const { return m_uploadedLevel; }
+  // Main-thread time spent on the last frame's upload
+  inline double getUploadSeconds() const { return m_uploadSeconds; }
+  inline size_t getUploadBytes() const { return m_uploadBytes; }
+  inline size_t getUploadRects() const { return m_uploadRects; }
+
+  // Direction arrows, energy bars, organism outlines and grid lines, one
+  // instanced quad per visible cell, once cells are drawn at least
+  // Config::OVERLAY_MIN_CELL_PIXELS wide
+  inline void setOverlay( bool enabled ) { m_overlayEnabled = enabled; }
+  inline bool isOverlayEnabled() const { return m_overlayEnabled; }
+  // Cells the overlay drew last frame, 0 while it is culled
+  inline size_t getOverlayCells() const { return m_overlayCells; }
+
+  // Times the edited shaders were rebuilt, and whether the last try failed
+  inline int getShaderReloads() const { return m_shaderReloads; }
+  inline bool hasShaderErrors() const { return m_shaderErrors; }
+
+  inline void setViewMode( ViewMode mode ) { m_viewMode = mode; }
+  inline ViewMode getViewMode() const { return m_viewMode; }
+  // Dims every cell whose genome key differs; -1 shows all
+  inline void setHighlight( int genomeKey ) { m_highlight = genomeKey; }
+  inline int getHighlight() const { return m_highlight; }
+
   inline Camera2D& getCamera() { return m_camera; }
   inline const Camera2D& getCamera() const { return m_camera; }
 
+  inline bool isSoftware() const { return m_software; }
+  // The frame drawn by the last finishUpload() in software mode
+  inline const SoftwareRasterizer& getRasterizer() const { return m_rasterizer; }
+
   private:
   Shader m_shader;
+  Shader m_overlayShader;
+  ShaderWatcher m_shaderWatcher;
+  int m_shaderReloads{ 0 };
+  bool m_shaderErrors{ false };
   Texture m_gridTexture;
+  Texture m_pageTexture;
+  PageTable m_pages;
   Camera2D m_camera;
 
+  GLuint m_lut{ 0 };
+  ViewMode m_viewMode{ ViewMode::Types };
+  int m_highlight{ -1 };
+
   GLuint m_vao{ 0 };
   GLuint m_vbo{ 0 };
   GLuint m_ebo{ 0 };
+  GLuint m_overlayVao{ 0 }; // no attributes; the overlay draws from gl_InstanceID
+  bool m_overlayEnabled{ false };
+  size_t m_overlayCells{ 0 };
+
+  double m_uploadSeconds{ 0.0 };
+  double m_beginSeconds{ 0.0 };
+  size_t m_uploadBytes{ 0 };
+  size_t m_uploadRects{ 0 };
+
+  // What the texture holds
+  bool m_hasUpload{ false };
+  uint64_t m_uploadedEpoch{ 0 };
+  uint64_t m_uploadedGeneration{ 0 };
+  std::vector<Texture::Rect> m_rects; // in cells, each within one page
+  std::vector<Texture::Rect> m_dirty;
+  std::vector<Texture::Region> m_regions;
+  bool m_pagesPending{ false };
+  // Page layout the drawn page table was uploaded with
+  int m_uploadedLevel{ 0 };
+  int m_uploadedPageWidth{ 0 };
+  int m_uploadedPageHeight{ 0 };
+  int m_uploadedSlotsX{ 1 };
+
+  bool m_software{ false };
+  SoftwareRasterizer m_rasterizer;
+  // Valid from beginUpload() to finishUpload(), like the pixels it points at
+  PixelUpdate m_pendingUpdate{};
+  bool m_hasPendingUpdate{ false };
 
   int m_gridWidth{ 0 };
   int m_gridHeight{ 0 };
+  int m_atlasSize{ 0 };
+  // The level the pages are laid out for, and its size in texels
+  int m_level{ 0 };
+  int m_levelWidth{ 0 };
+  int m_levelHeight{ 0 };
+  int m_windowWidth{ 0 };
+  int m_windowHeight{ 0 };
+  float m_lastCameraX{ 0.0f };
+  float m_lastCameraY{ 0.0f };
 
   void createQuadGeometry();
+  void createLut();
+  void initPages( int width, int height );
+  int getWantedLevel( const PixelUpdate& update ) const;
+  void selectLevel( const PixelUpdate& update );
+  void updatePages();
+  void reloadShaders();
+  bool wantsOverlay() const;
+  void renderOverlay( const float* viewMatrix );
+  void collectRects( const PixelUpdate& update );
+  Texture::Rect clipToGrid( const Texture::Rect& rect ) const;
+  void collectDirtyRects( const PixelUpdate& update );
 };
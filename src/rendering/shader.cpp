@@ -1,6 +1,82 @@
 #include "shader.h"
+#include "gl_extensions.h"
+#include "core/config.h"
+#include "../utils/binary_io.h"
 #include "../utils/file_utils.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+  // ARB_get_program_binary is core in 4.1, past what the loader is generated for
+  constexpr GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+  constexpr GLenum PROGRAM_BINARY_LENGTH = 0x8741;
+  using GetProgramBinaryFn = void (APIENTRYP)( GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary );
+  using ProgramBinaryFn = void (APIENTRYP)( GLuint program, GLenum binaryFormat, const void* binary, GLsizei length );
+  using ProgramParameteriFn = void (APIENTRYP)( GLuint program, GLenum pname, GLint value );
+
+  struct BinaryApi
+  {
+    GetProgramBinaryFn getProgramBinary{ nullptr };
+    ProgramBinaryFn programBinary{ nullptr };
+    ProgramParameteriFn programParameteri{ nullptr };
+
+    inline bool isAvailable() const { return getProgramBinary && programBinary && programParameteri; }
+  };
+
+  const BinaryApi& getBinaryApi()
+  {
+    static const BinaryApi api = []
+    {
+      BinaryApi found;
+      if ( Config::SHADER_CACHE_DIR[0] != '\0' && GLExtensions::isSupported("GL_ARB_get_program_binary") )
+      {
+        found.getProgramBinary = reinterpret_cast<GetProgramBinaryFn>(GLExtensions::getProcAddress("glGetProgramBinary"));
+        found.programBinary = reinterpret_cast<ProgramBinaryFn>(GLExtensions::getProcAddress("glProgramBinary"));
+        found.programParameteri = reinterpret_cast<ProgramParameteriFn>(GLExtensions::getProcAddress("glProgramParameteri"));
+      }
+      return found;
+    }();
+    return api;
+  }
+
+  // FNV-1a over both sources and the driver, which may not load another's binaries
+  uint64_t getSourceHash( const char* vertexSource, const char* fragmentSource )
+  {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto add = [&]( const char* text )
+    {
+      for ( const char* c = text ? text : ""; ; ++c )
+      {
+        hash = (hash ^ static_cast<uint8_t>(*c)) * 0x100000001B3ull;
+        if ( *c == '\0' ) break;
+      }
+    };
+    add(vertexSource);
+    add(fragmentSource);
+    for ( GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION } )
+    {
+      add(reinterpret_cast<const char*>(glGetString(name)));
+    }
+    return hash;
+  }
+
+  // One file per program, overwritten by each edit; programs built from
+  // bare sources are named by their hash
+  std::filesystem::path getCachePath( const std::string& name, uint64_t hash )
+  {
+    if ( !name.empty() ) return std::filesystem::path(Config::SHADER_CACHE_DIR) / (name + ".bin");
+
+    char file[32];
+    std::snprintf(file, sizeof(file), "%016llx.bin", static_cast<unsigned long long>(hash));
+    return std::filesystem::path(Config::SHADER_CACHE_DIR) / file;
+  }
+}
 
 Shader::~Shader()
 {
@@ -9,35 +85,32 @@ Shader::~Shader()
 
 bool Shader::loadFromFiles( const char* vertexPath, const char* fragmentPath )
 {
-  std::string vertexSource = FileUtils::readTextFile(vertexPath);
-  std::string fragmentSource = FileUtils::readTextFile(fragmentPath);
+  m_vertexPath = vertexPath;
+  m_fragmentPath = fragmentPath;
+  m_name = std::filesystem::path(vertexPath).stem().string();
+  return reload();
+}
 
-  if ( vertexSource.empty() || fragmentSource.empty() )
-  {
-    return false;
-  }
+bool Shader::loadFromSource( const char* vertexSource, const char* fragmentSource )
+{
+  const GLuint program = buildProgram(vertexSource, fragmentSource);
+  if ( program == 0 ) return false;
 
-  return loadFromSource(vertexSource.c_str(), fragmentSource.c_str());
+  setProgram(program);
+  return true;
 }
 
-bool Shader::loadFromSource( const char* vertexSource, const char* fragmentSource )
+bool Shader::reload()
 {
-  GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
-  if ( vertexShader == 0 ) return false;
+  std::string vertexSource = FileUtils::readTextFile(m_vertexPath.c_str());
+  std::string fragmentSource = FileUtils::readTextFile(m_fragmentPath.c_str());
 
-  GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
-  if ( fragmentShader == 0 )
+  if ( vertexSource.empty() || fragmentSource.empty() )
   {
-    glDeleteShader(vertexShader);
     return false;
   }
 
-  bool success = linkProgram(vertexShader, fragmentShader);
-
-  glDeleteShader(vertexShader);
-  glDeleteShader(fragmentShader);
-
-  return success;
+  return loadFromSource(vertexSource.c_str(), fragmentSource.c_str());
 }
 
 void Shader::destroy()
@@ -47,6 +120,7 @@ void Shader::destroy()
     glDeleteProgram(m_program);
     m_program = 0;
   }
+  m_locations.assign(m_uniformNames.size(), -1);
 }
 
 void Shader::use() const
@@ -54,24 +128,99 @@ void Shader::use() const
   glUseProgram(m_program);
 }
 
-void Shader::setInt( const char* name, int value ) const
+void Shader::setUniformNames( std::vector<std::string> names )
+{
+  m_uniformNames = std::move(names);
+  resolveUniforms();
+}
+
+void Shader::setInt( int uniform, int value ) const
 {
-  glUniform1i(getUniformLocation(name), value);
+  glUniform1i(m_locations[uniform], value);
 }
 
-void Shader::setFloat( const char* name, float value ) const
+void Shader::setInt2( int uniform, int x, int y ) const
 {
-  glUniform1f(getUniformLocation(name), value);
+  glUniform2i(m_locations[uniform], x, y);
 }
 
-void Shader::setMat4( const char* name, const float* value ) const
+void Shader::setFloat( int uniform, float value ) const
 {
-  glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, value);
+  glUniform1f(m_locations[uniform], value);
 }
 
-GLint Shader::getUniformLocation( const char* name ) const
+void Shader::setMat4( int uniform, const float* value ) const
 {
-  return glGetUniformLocation(m_program, name);
+  glUniformMatrix4fv(m_locations[uniform], 1, GL_FALSE, value);
+}
+
+GLuint Shader::buildProgram( const char* vertexSource, const char* fragmentSource )
+{
+  const BinaryApi& api = getBinaryApi();
+  std::filesystem::path cachePath;
+  uint64_t hash = 0;
+  if ( api.isAvailable() )
+  {
+    hash = getSourceHash(vertexSource, fragmentSource);
+    cachePath = getCachePath(m_name, hash);
+
+    // The file holds the last build of the program; other sources rebuild it
+    std::ifstream in(cachePath, std::ios::binary);
+    uint64_t cachedHash = 0;
+    GLenum format = 0;
+    if ( in && BinaryIO::read(in, cachedHash) && cachedHash == hash && BinaryIO::read(in, format) )
+    {
+      const std::vector<char> binary{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+      const GLuint program = glCreateProgram();
+      api.programBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+      // Drivers refuse binaries of other versions; fall through and rebuild
+      GLint success = 0;
+      glGetProgramiv(program, GL_LINK_STATUS, &success);
+      if ( success ) return program;
+      glDeleteProgram(program);
+    }
+  }
+
+  GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+  if ( vertexShader == 0 ) return 0;
+
+  GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+  if ( fragmentShader == 0 )
+  {
+    glDeleteShader(vertexShader);
+    return 0;
+  }
+
+  const GLuint program = linkProgram(vertexShader, fragmentShader);
+
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+
+  // A cache that cannot be written only costs the next launch a compile
+  GLint length = 0;
+  if ( program != 0 && api.isAvailable() )
+  {
+    glGetProgramiv(program, PROGRAM_BINARY_LENGTH, &length);
+  }
+  if ( length > 0 )
+  {
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    api.getProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(cachePath.parent_path(), error);
+    std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+    if ( out )
+    {
+      BinaryIO::write(out, hash);
+      BinaryIO::write(out, format);
+      BinaryIO::writeArray(out, binary.data(), static_cast<size_t>(length));
+    }
+  }
+
+  return program;
 }
 
 GLuint Shader::compileShader( GLenum type, const char* source )
@@ -95,25 +244,47 @@ GLuint Shader::compileShader( GLenum type, const char* source )
   return shader;
 }
 
-bool Shader::linkProgram( GLuint vertexShader, GLuint fragmentShader )
+GLuint Shader::linkProgram( GLuint vertexShader, GLuint fragmentShader )
 {
-  m_program = glCreateProgram();
-  glAttachShader(m_program, vertexShader);
-  glAttachShader(m_program, fragmentShader);
-  glLinkProgram(m_program);
+  GLuint program = glCreateProgram();
+  glAttachShader(program, vertexShader);
+  glAttachShader(program, fragmentShader);
+  if ( getBinaryApi().isAvailable() )
+  {
+    getBinaryApi().programParameteri(program, PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+  glLinkProgram(program);
 
   GLint success = 0;
-  glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
 
   if ( !success )
   {
     char infoLog[1024];
-    glGetProgramInfoLog(m_program, sizeof(infoLog), nullptr, infoLog);
+    glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
     std::cerr << "Shader linking error:\n" << infoLog << std::endl;
-    glDeleteProgram(m_program);
-    m_program = 0;
-    return false;
+    glDeleteProgram(program);
+    return 0;
   }
 
-  return true;
+  return program;
+}
+
+void Shader::setProgram( GLuint program )
+{
+  destroy();
+  m_program = program;
+  resolveUniforms();
+}
+
+void Shader::resolveUniforms()
+{
+  // Names the program does not use, or no program yet, give -1, which the setters ignore
+  m_locations.assign(m_uniformNames.size(), -1);
+  if ( m_program == 0 ) return;
+
+  for ( size_t i = 0; i < m_uniformNames.size(); ++i )
+  {
+    m_locations[i] = glGetUniformLocation(m_program, m_uniformNames[i].c_str());
+  }
 }
@@ -1,7 +1,13 @@
 #pragma once
 #include <glad/glad.h>
 #include <string>
+#include <vector>
 
+// A linked program and its uniform locations, looked up once each time it
+// is linked. Programs are kept as driver binaries in Config::SHADER_CACHE_DIR,
+// one file per program named after its vertex shader and tagged with a hash
+// of the sources and the driver, so later launches skip the compile; changed
+// sources or a binary the driver rejects are built again and overwrite it.
 class Shader
 {
   public:
@@ -10,21 +16,37 @@ class Shader
 
   bool loadFromFiles( const char* vertexPath, const char* fragmentPath );
   bool loadFromSource( const char* vertexSource, const char* fragmentSource );
+  // Builds the files of the last loadFromFiles() again; the old program stays on failure
+  bool reload();
   void destroy();
 
   void use() const;
   inline GLuint getProgram() const { return m_program; }
 
-  // Uniform setters
-  void setInt( const char* name, int value ) const;
-  void setFloat( const char* name, float value ) const;
-  void setMat4( const char* name, const float* value ) const;
+  // The uniforms the setters address, by their index in names (usually an
+  // enum of the caller's); locations are resolved now and after every link
+  void setUniformNames( std::vector<std::string> names );
 
-  GLint getUniformLocation( const char* name ) const;
+  // Uniform setters, by index into the names
+  void setInt( int uniform, int value ) const;
+  void setInt2( int uniform, int x, int y ) const;
+  void setFloat( int uniform, float value ) const;
+  void setMat4( int uniform, const float* value ) const;
+
+  // -1 for uniforms the program does not use
+  inline GLint getUniformLocation( int uniform ) const { return m_locations[uniform]; }
 
   private:
   GLuint m_program{ 0 };
+  std::vector<std::string> m_uniformNames;
+  std::vector<GLint> m_locations;
+  std::string m_vertexPath;
+  std::string m_fragmentPath;
+  std::string m_name; // cache file, empty for programs built from bare sources
 
+  GLuint buildProgram( const char* vertexSource, const char* fragmentSource );
   GLuint compileShader( GLenum type, const char* source );
-  bool linkProgram( GLuint vertexShader, GLuint fragmentShader );
+  GLuint linkProgram( GLuint vertexShader, GLuint fragmentShader );
+  void setProgram( GLuint program );
+  void resolveUniforms();
 };
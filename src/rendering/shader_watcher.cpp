@@ -0,0 +1,85 @@
+#include "shader_watcher.h"
+#include <iostream>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+namespace
+{
+  // Editors write swap and backup files next to the shaders; only finished shaders count
+  bool isShaderFile( std::string_view name )
+  {
+    return name.ends_with(".vert") || name.ends_with(".frag");
+  }
+}
+#endif
+
+ShaderWatcher::~ShaderWatcher()
+{
+  destroy();
+}
+
+bool ShaderWatcher::init( const char* directory )
+{
+  destroy();
+
+#if defined(__linux__)
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if ( m_fd < 0 || inotify_add_watch(m_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0 )
+  {
+    std::cerr << "Failed to watch " << directory << ": " << std::strerror(errno) << std::endl;
+    destroy();
+    return false;
+  }
+  return true;
+#else
+  (void)directory;
+  return false;
+#endif
+}
+
+void ShaderWatcher::destroy()
+{
+#if defined(__linux__)
+  if ( m_fd >= 0 )
+  {
+    close(m_fd);
+  }
+#endif
+  m_fd = -1;
+}
+
+bool ShaderWatcher::poll()
+{
+  if ( m_fd < 0 ) return false;
+
+#if defined(__linux__)
+  // A save is often several events; drain them all and report one change
+  bool changed = false;
+  alignas(inotify_event) char buffer[4096];
+  for ( ;; )
+  {
+    const ssize_t bytes = read(m_fd, buffer, sizeof(buffer));
+    if ( bytes <= 0 ) break;
+
+    for ( ssize_t offset = 0; offset < bytes; )
+    {
+      const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+      if ( event->len > 0 && isShaderFile(event->name) )
+      {
+        changed = true;
+      }
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+    }
+  }
+  return changed;
+#else
+  return false;
+#endif
+}
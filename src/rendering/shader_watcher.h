@@ -0,0 +1,28 @@
+#pragma once
+
+// Changes to the files of one directory, from inotify, so shaders can be
+// edited while a long run keeps going. Files count once they are closed
+// after writing or moved into place, which covers editors that save to a
+// temporary file and rename it. Only .vert and .frag files count, so swap
+// and backup files written beside them do not trigger reloads. Not
+// available outside Linux.
+class ShaderWatcher
+{
+  public:
+  ShaderWatcher() = default;
+  ~ShaderWatcher();
+
+  ShaderWatcher( const ShaderWatcher& ) = delete;
+  ShaderWatcher& operator=( const ShaderWatcher& ) = delete;
+
+  bool init( const char* directory );
+  void destroy();
+
+  // Never blocks; true when a shader changed since the last call
+  bool poll();
+
+  inline bool isWatching() const { return m_fd >= 0; }
+
+  private:
+  int m_fd{ -1 };
+};
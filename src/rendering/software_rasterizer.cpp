@@ -0,0 +1,226 @@
+#include "software_rasterizer.h"
+#include "view_colours.h"
+#include "simulation/cell_view.h"
+#include "utils/cpu_features.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+  // What a row needs to turn views into colours, see SoftwareRasterizer::m_colours
+  struct RowLookup
+  {
+    const int32_t* columns;
+    int width;
+    const uint32_t* colours;
+    int shift;
+    uint32_t mask;
+    uint32_t dimOffset;
+    uint32_t highlight;
+    uint32_t background;
+  };
+
+  void drawRowScalar( const RowLookup& lookup, const uint32_t* row, uint32_t* out, int begin )
+  {
+    for ( int x = begin; x < lookup.width; ++x )
+    {
+      const int32_t column = lookup.columns[x];
+      if ( column < 0 )
+      {
+        out[x] = lookup.background;
+        continue;
+      }
+
+      const uint32_t view = row[column];
+      const uint32_t type = view & 7;
+      uint32_t entry = type | (((view >> lookup.shift) & lookup.mask) << 3);
+      if ( lookup.dimOffset != 0 && type != 0 && (view >> CellView::KEY_SHIFT) != lookup.highlight )
+      {
+        entry += lookup.dimOffset;
+      }
+      out[x] = lookup.colours[entry];
+    }
+  }
+
+#if defined(GENXIDE_HAS_AVX2_PATH)
+
+  __attribute__((target("avx2")))
+  void drawRowAVX2( const RowLookup& lookup, const uint32_t* row, uint32_t* out )
+  {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i outside = _mm256_set1_epi32(-1);
+    const __m256i typeMask = _mm256_set1_epi32(7);
+    const __m256i fieldMask = _mm256_set1_epi32(static_cast<int>(lookup.mask));
+    const __m128i shift = _mm_cvtsi32_si128(lookup.shift);
+    const __m256i dimOffset = _mm256_set1_epi32(static_cast<int>(lookup.dimOffset));
+    const __m256i highlight = _mm256_set1_epi32(static_cast<int>(lookup.highlight));
+    const __m256i background = _mm256_set1_epi32(static_cast<int>(lookup.background));
+
+    int x = 0;
+    for ( ; x + 8 <= lookup.width; x += 8 )
+    {
+      // Lanes outside the grid gather nothing and take the background
+      const __m256i columns = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lookup.columns + x));
+      const __m256i inside = _mm256_cmpgt_epi32(columns, outside);
+      const __m256i views = _mm256_mask_i32gather_epi32(zero, reinterpret_cast<const int*>(row), columns, inside, 4);
+
+      const __m256i type = _mm256_and_si256(views, typeMask);
+      __m256i entry = _mm256_or_si256(type, _mm256_slli_epi32(_mm256_and_si256(_mm256_srl_epi32(views, shift), fieldMask), 3));
+      if ( lookup.dimOffset != 0 )
+      {
+        const __m256i alive = _mm256_cmpgt_epi32(type, zero);
+        const __m256i same = _mm256_cmpeq_epi32(_mm256_srli_epi32(views, CellView::KEY_SHIFT), highlight);
+        entry = _mm256_add_epi32(entry, _mm256_and_si256(_mm256_andnot_si256(same, alive), dimOffset));
+      }
+
+      const __m256i colours = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lookup.colours), entry, 4);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_blendv_epi8(background, colours, inside));
+    }
+
+    drawRowScalar(lookup, row, out, x);
+  }
+
+#endif
+
+  void drawRow( const RowLookup& lookup, const uint32_t* row, uint32_t* out )
+  {
+#if defined(GENXIDE_HAS_AVX2_PATH)
+    if ( CpuFeatures::hasAVX2() )
+    {
+      drawRowAVX2(lookup, row, out);
+      return;
+    }
+#endif
+    drawRowScalar(lookup, row, out, 0);
+  }
+}
+
+SoftwareRasterizer::SoftwareRasterizer() = default;
+SoftwareRasterizer::~SoftwareRasterizer() = default;
+
+void SoftwareRasterizer::init( int gridWidth, int gridHeight, size_t threadCount )
+{
+  m_gridWidth = gridWidth;
+  m_gridHeight = gridHeight;
+  m_pool = std::make_unique<ThreadPool>(threadCount);
+  m_tableMode = -1;
+}
+
+size_t SoftwareRasterizer::getThreadCount() const
+{
+  return m_pool ? m_pool->getThreadCount() : 1;
+}
+
+void SoftwareRasterizer::draw( std::span<const uint32_t> views, int level, const Camera2D& camera, int mode, int highlight, int width, int height )
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  m_frameWidth = std::max(width, 0);
+  m_frameHeight = std::max(height, 0);
+  m_frame.resize(static_cast<size_t>(m_frameWidth) * m_frameHeight);
+  if ( m_frame.empty() || views.empty() || !m_pool ) return;
+
+  buildColours(mode, highlight);
+  mapPixels(level, camera, m_frameWidth, m_frameHeight);
+
+  const RowLookup lookup = {
+    m_columns.data(),
+    m_frameWidth,
+    m_colours.data(),
+    m_shift,
+    m_mask,
+    m_dimOffset,
+    static_cast<uint32_t>(highlight),
+    ViewColours::toARGB(ViewColours::BACKGROUND)
+  };
+
+  // One band of rows per worker
+  m_pool->parallelFor(static_cast<size_t>(m_frameHeight), [&]( size_t begin, size_t end, size_t )
+  {
+    for ( size_t y = begin; y < end; ++y )
+    {
+      uint32_t* out = m_frame.data() + y * m_frameWidth;
+      if ( m_rows[y] < 0 )
+      {
+        std::fill(out, out + m_frameWidth, lookup.background);
+      }
+      else
+      {
+        drawRow(lookup, views.data() + m_rows[y], out);
+      }
+    }
+  });
+
+  m_drawSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SoftwareRasterizer::buildColours( int mode, int highlight )
+{
+  if ( mode == m_tableMode && highlight == m_tableHighlight ) return;
+  m_tableMode = mode;
+  m_tableHighlight = highlight;
+
+  // Modes 2 and 3 (energy, age) colour by their field; the others by the genome key
+  const bool keyed = mode != 2 && mode != 3;
+  m_shift = mode == 2 ? CellView::ENERGY_SHIFT : mode == 3 ? CellView::AGE_SHIFT : CellView::KEY_SHIFT;
+  m_mask = mode == 2 ? CellView::ENERGY_MAX : mode == 3 ? CellView::AGE_MAX : CellView::KEY_MAX;
+
+  // Keyed tables have the highlight baked in; the others get a dimmed second half
+  const size_t entries = (static_cast<size_t>(m_mask) + 1) * 8;
+  m_dimOffset = !keyed && highlight >= 0 ? static_cast<uint32_t>(entries) : 0;
+  m_colours.resize(entries + m_dimOffset);
+
+  uint8_t lut[ViewColours::LUT_SIZE * 4];
+  ViewColours::fillHeatLut(lut);
+
+  for ( uint32_t field = 0; field <= m_mask; ++field )
+  {
+    const ViewColours::Colour fieldColour = keyed ? ViewColours::genomeColour(field)
+      : ViewColours::sampleHeatLut(lut, static_cast<float>(field) / m_mask);
+
+    for ( uint32_t type = 0; type < 8; ++type )
+    {
+      // Types past Sprout never occur; they stay black like empty cells
+      ViewColours::Colour colour = ViewColours::TYPE_COLOURS[0];
+      if ( type != 0 && type < 5 )
+      {
+        colour = mode == 0 && type != 4 ? ViewColours::TYPE_COLOURS[type] : fieldColour;
+      }
+
+      const bool dimmed = keyed && highlight >= 0 && type != 0 && field != static_cast<uint32_t>(highlight);
+      const size_t entry = type | (field << 3);
+      m_colours[entry] = ViewColours::toARGB(colour, dimmed ? ViewColours::HIGHLIGHT_DIM : 1.0f);
+      if ( m_dimOffset != 0 )
+      {
+        m_colours[m_dimOffset + entry] = ViewColours::toARGB(colour, ViewColours::HIGHLIGHT_DIM);
+      }
+    }
+  }
+}
+
+void SoftwareRasterizer::mapPixels( int level, const Camera2D& camera, int width, int height )
+{
+  // Pixel centres through the inverse of Camera2D::getViewMatrix; world y,
+  // and the grid's rows, grow upwards while the frame's rows grow downwards
+  const double zoom = camera.getZoom();
+  const double aspect = static_cast<double>(width) / height;
+  const int scale = 1 << level;
+  const int64_t levelWidth = (m_gridWidth + scale - 1) / scale;
+
+  m_columns.resize(width);
+  for ( int x = 0; x < width; ++x )
+  {
+    const double ndc = 2.0 * (x + 0.5) / width - 1.0;
+    const double world = camera.getX() + ndc * aspect / zoom;
+    m_columns[x] = world >= 0.0 && world < m_gridWidth ? static_cast<int32_t>(world) >> level : -1;
+  }
+
+  m_rows.resize(height);
+  for ( int y = 0; y < height; ++y )
+  {
+    const double ndc = 1.0 - 2.0 * (y + 0.5) / height;
+    const double world = camera.getY() + ndc / zoom;
+    m_rows[y] = world >= 0.0 && world < m_gridHeight ? (static_cast<int64_t>(world) >> level) * levelWidth : -1;
+  }
+}
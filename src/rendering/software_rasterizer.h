@@ -0,0 +1,64 @@
+#pragma once
+#include "camera2d.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// Draws the packed cell views (see CellView) into an ARGB8888 frame on the
+// CPU, for machines where OpenGL is slow or missing. Every pixel samples the
+// nearest view under the camera, the way the grid quad does, and is coloured
+// like shaders/grid.frag through a table built when the view mode or the
+// highlight changes, so a pixel costs two gathers: its view, then its colour.
+// The source columns and rows are mapped once per frame; rows are split into
+// bands across the pool and each row gathered eight pixels at a time with AVX2
+// where the CPU has it.
+class SoftwareRasterizer
+{
+  public:
+  SoftwareRasterizer();
+  ~SoftwareRasterizer();
+
+  // threadCount 0 = one per hardware thread
+  void init( int gridWidth, int gridHeight, size_t threadCount );
+
+  // views hold one view per 2^level x 2^level cells; mode is a
+  // Renderer::ViewMode and highlight a genome key or -1
+  void draw( std::span<const uint32_t> views, int level, const Camera2D& camera, int mode, int highlight, int width, int height );
+
+  inline const uint32_t* getFrame() const { return m_frame.data(); }
+  inline int getFrameWidth() const { return m_frameWidth; }
+  inline int getFrameHeight() const { return m_frameHeight; }
+  inline double getDrawSeconds() const { return m_drawSeconds; }
+  size_t getThreadCount() const;
+
+  private:
+  std::unique_ptr<ThreadPool> m_pool;
+  std::vector<uint32_t> m_frame;
+  int m_frameWidth{ 0 };
+  int m_frameHeight{ 0 };
+  double m_drawSeconds{ 0.0 };
+
+  int m_gridWidth{ 0 };
+  int m_gridHeight{ 0 };
+
+  // Per frame: the view column of every pixel column and the first view of
+  // every pixel row's source row, -1 outside the grid
+  std::vector<int32_t> m_columns;
+  std::vector<int64_t> m_rows;
+
+  // Colour of view v at (v & 7) | ((v >> m_shift) & m_mask) << 3, plus
+  // m_dimOffset when a live cell is not of the highlighted genome
+  std::vector<uint32_t> m_colours;
+  int m_shift{ 0 };
+  uint32_t m_mask{ 0 };
+  uint32_t m_dimOffset{ 0 };
+  int m_tableMode{ -1 };
+  int m_tableHighlight{ -1 };
+
+  void buildColours( int mode, int highlight );
+  void mapPixels( int level, const Camera2D& camera, int width, int height );
+};
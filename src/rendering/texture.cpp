@@ -5,16 +5,28 @@ Texture::~Texture()
   destroy();
 }
 
-bool Texture::create( int width, int height, GLenum format )
+bool Texture::create( int width, int height, GLenum format, GLenum type )
 {
   m_width = width;
   m_height = height;
   m_format = format;
+  m_type = type;
 
   glGenTextures(1, &m_textureID);
   glBindTexture(GL_TEXTURE_2D, m_textureID);
 
-  GLenum internalFormat = (format == GL_RGBA) ? GL_RGBA8 : GL_RGB8;
+  GLenum internalFormat = GL_RGB8;
+  m_pixelSize = 3;
+  if ( format == GL_RGBA )
+  {
+    internalFormat = GL_RGBA8;
+    m_pixelSize = 4;
+  }
+  else if ( format == GL_RED_INTEGER )
+  {
+    internalFormat = (type == GL_UNSIGNED_INT) ? GL_R32UI : (type == GL_UNSIGNED_SHORT) ? GL_R16UI : GL_R8UI;
+    m_pixelSize = (type == GL_UNSIGNED_INT) ? 4 : (type == GL_UNSIGNED_SHORT) ? 2 : 1;
+  }
 
   glTexImage2D(
     GL_TEXTURE_2D,
@@ -24,7 +36,7 @@ bool Texture::create( int width, int height, GLenum format )
     height,
     0,
     format,
-    GL_UNSIGNED_BYTE,
+    m_type,
     nullptr
   );
 
@@ -47,26 +59,40 @@ void Texture::destroy()
   }
 }
 
-void Texture::update( const void* data, int x, int y, int width, int height )
+void Texture::update( const void* data, int x, int y, int width, int height, int rowLength )
 {
   glBindTexture(GL_TEXTURE_2D, m_textureID);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
   glTexSubImage2D(
     GL_TEXTURE_2D,
     0,
     x, y,
     width, height,
     m_format,
-    GL_UNSIGNED_BYTE,
+    m_type,
     data
   );
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
   glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void Texture::update( const std::vector<uint32_t>& pixels )
+void Texture::update( std::span<const uint32_t> pixels )
 {
   update(pixels.data(), 0, 0, m_width, m_height);
 }
 
+void Texture::update( const void* pixels, int sourceWidth, std::span<const Region> regions )
+{
+  const uint8_t* bytes = static_cast<const uint8_t*>(pixels);
+  for ( const Region& region : regions )
+  {
+    const Rect& rect = region.target;
+    update(bytes + (static_cast<size_t>(region.sourceY) * sourceWidth + region.sourceX) * m_pixelSize, rect.x, rect.y, rect.width, rect.height, sourceWidth);
+  }
+}
+
 void Texture::bind( GLuint textureUnit ) const
 {
   glActiveTexture(GL_TEXTURE0 + textureUnit);
@@ -1,19 +1,43 @@
 #pragma once
 #include <glad/glad.h>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <span>
 
+// A 2D texture updated synchronously from client memory. Uploads can cover
+// a list of regions, each a rectangle of the texture filled from a
+// rectangle of a larger source array.
 class Texture
 {
   public:
+  struct Rect
+  {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  // A rect of the texture and where its pixels start in the source array
+  struct Region
+  {
+    Rect target;
+    int sourceX;
+    int sourceY;
+  };
+
   Texture() = default;
   ~Texture();
 
-  bool create( int width, int height, GLenum format = GL_RGBA );
+  // GL_RED_INTEGER gives an unsigned integer texture, R8UI, R16UI or R32UI by type
+  bool create( int width, int height, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE );
   void destroy();
 
-  void update( const void* data, int x, int y, int width, int height );
-  void update( const std::vector<uint32_t>& pixels );
+  // rowLength is the row pitch of data in pixels, 0 when rows are packed
+  void update( const void* data, int x, int y, int width, int height, int rowLength = 0 );
+  void update( std::span<const uint32_t> pixels );
+  // Regions of pixels, an array sourceWidth pixels wide
+  void update( const void* pixels, int sourceWidth, std::span<const Region> regions );
 
   void bind( GLuint textureUnit = 0 ) const;
   void unbind() const;
@@ -21,10 +45,13 @@ class Texture
   inline GLuint getID() const { return m_textureID; }
   inline int getWidth() const { return m_width; }
   inline int getHeight() const { return m_height; }
+  inline size_t getPixelSize() const { return m_pixelSize; }
 
   private:
   GLuint m_textureID{ 0 };
   int m_width{ 0 };
   int m_height{ 0 };
   GLenum m_format{ GL_RGBA };
+  GLenum m_type{ GL_UNSIGNED_BYTE };
+  size_t m_pixelSize{ 4 };
 };
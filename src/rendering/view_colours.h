@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// The colours of shaders/grid.frag on the CPU, for the heat gradient texture
+// and the software rasterizer. Keep both in step with the shader.
+namespace ViewColours
+{
+  struct Colour
+  {
+    float r, g, b;
+  };
+
+  constexpr Colour BACKGROUND = { 0.1f, 0.1f, 0.12f };
+  constexpr Colour TYPE_COLOURS[5] = {
+    { 0.0f, 0.0f, 0.0f },
+    { 0.2f, 0.2f, 0.2f },
+    { 0.047f, 1.0f, 0.2f },
+    { 0.063f, 0.333f, 0.008f },
+    { 1.0f, 1.0f, 1.0f }
+  };
+  constexpr float HIGHLIGHT_DIM = 0.2f;
+
+  constexpr int LUT_SIZE = 256;
+
+  // Heat gradient for the energy and age views: black, purple, red, yellow, white
+  inline void fillHeatLut( uint8_t* rgba )
+  {
+    constexpr int STOP_COUNT = 5;
+    constexpr float STOPS[STOP_COUNT][3] = {
+      { 0.05f, 0.0f, 0.1f },
+      { 0.45f, 0.05f, 0.55f },
+      { 0.9f, 0.15f, 0.1f },
+      { 1.0f, 0.8f, 0.1f },
+      { 1.0f, 1.0f, 0.9f }
+    };
+
+    for ( int i = 0; i < LUT_SIZE; ++i )
+    {
+      const float t = static_cast<float>(i) / (LUT_SIZE - 1) * (STOP_COUNT - 1);
+      const int stop = std::min(static_cast<int>(t), STOP_COUNT - 2);
+      const float f = t - stop;
+      for ( int c = 0; c < 3; ++c )
+      {
+        const float value = STOPS[stop][c] + (STOPS[stop + 1][c] - STOPS[stop][c]) * f;
+        rgba[i * 4 + c] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+      }
+      rgba[i * 4 + 3] = 255;
+    }
+  }
+
+  // The filtered lookup the shader's texture() does, t in [0, 1]
+  inline Colour sampleHeatLut( const uint8_t* rgba, float t )
+  {
+    const float position = std::clamp(t * LUT_SIZE - 0.5f, 0.0f, static_cast<float>(LUT_SIZE - 1));
+    const int i = std::min(static_cast<int>(position), LUT_SIZE - 2);
+    const float f = position - i;
+    auto channel = [&]( int c )
+    {
+      return (rgba[i * 4 + c] + (rgba[(i + 1) * 4 + c] - rgba[i * 4 + c]) * f) / 255.0f;
+    };
+    return { channel(0), channel(1), channel(2) };
+  }
+
+  inline Colour hsv( float h, float s, float v )
+  {
+    auto channel = [&]( float offset )
+    {
+      const float k = std::clamp(std::abs(std::fmod(h * 6.0f + offset, 6.0f) - 3.0f) - 1.0f, 0.0f, 1.0f);
+      return v * (1.0f + (k - 1.0f) * s);
+    };
+    return { channel(0.0f), channel(4.0f), channel(2.0f) };
+  }
+
+  inline Colour genomeColour( uint32_t key )
+  {
+    // Spread neighbouring keys over the hue circle; the low bits vary the tone
+    const float hue = static_cast<float>(key >> 2) / 2048.0f;
+    const float sat = 0.6f + 0.2f * static_cast<float>(key & 1);
+    const float val = 0.75f + 0.15f * static_cast<float>((key >> 1) & 1);
+    return hsv(hue, sat, val);
+  }
+
+  // 0xAARRGGBB, SDL_PIXELFORMAT_ARGB8888
+  inline uint32_t toARGB( const Colour& colour, float scale = 1.0f )
+  {
+    auto channel = [&]( float value )
+    {
+      return static_cast<uint32_t>(std::clamp(value * scale, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+    return 0xFF000000u | (channel(colour.r) << 16) | (channel(colour.g) << 8) | channel(colour.b);
+  }
+}
@@ -22,77 +22,49 @@ uint8_t CellFactory::randomDirection()
   }
 }
 
-Cell CellFactory::createEmpty()
+Cell CellFactory::create( CellType type, uint8_t direction ) const
 {
   Cell c{};
-  c.type = CellType::Empty;
-  c.r = 0;
-  c.g = 0;
-  c.b = 0;
+  c.type = type;
+  c.energy = 0;
+  c.direction = direction;
+
   return c;
 }
 
+Cell CellFactory::createEmpty()
+{
+  return create(CellType::Empty, 0);
+}
+
 Cell CellFactory::createWood()
 {
-  Cell c{};
-  c.type = CellType::Wood;
-  c.energy = 0;
-  c.direction = randomDirection();
-  c.r = 51;
-  c.g = 51;
-  c.b = 51;
-  return c;
+  return create(CellType::Wood, randomDirection());
 }
 
 Cell CellFactory::createLeaf()
 {
-  Cell c{};
-  c.type = CellType::Leaf;
-  c.energy = 0;
-  c.direction = randomDirection();
-  c.r = 12;
-  c.g = 255;
-  c.b = 51;
-  return c;
+  return create(CellType::Leaf, randomDirection());
 }
 
 Cell CellFactory::createRoot()
 {
-  Cell c{};
-  c.type = CellType::Root;
-  c.energy = 0;
-  c.direction = randomDirection();
-  c.r = 16;
-  c.g = 85;
-  c.b = 2;
-  return c;
+  return create(CellType::Root, randomDirection());
 }
 
 Cell CellFactory::createSprout( uint32_t genomeIndex )
 {
-  Cell c{};
-  c.type = CellType::Sprout;
-  c.energy = 0;
-  c.direction = randomDirection();
+  Cell c = create(CellType::Sprout, randomDirection());
   c.genomeIndex = genomeIndex;
-  
-  // Color will be set based on genome
-  c.r = 255;
-  c.g = 255;
-  c.b = 255;
-  
   return c;
 }
 
-Genome CellFactory::createRandomGenome()
+void CellFactory::randomizeGenome( std::span<uint16_t> genes )
 {
-  Genome genome(m_maxGenome);
   std::uniform_int_distribution<uint16_t> dist(0, m_maxGenome - 1);
   
-  for ( uint16_t& gene : genome.genes )
+  for ( uint16_t& gene : genes )
   {
     gene = dist(m_rng);
   }
-  
-  return genome;
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include "cell.h"
+#include "utils/random.h"
 #include <random>
+#include <span>
 
 class CellFactory
 {
@@ -13,7 +15,12 @@ class CellFactory
   Cell createRoot();
   Cell createSprout( uint32_t genomeIndex );
 
-  Genome createRandomGenome();
+  // Fixed direction and no rng use, so it is safe to call from worker threads
+  Cell create( CellType type, uint8_t direction ) const;
+
+  void randomizeGenome( std::span<uint16_t> genes );
+
+  inline void reseed( uint64_t seed ) { m_rng.seed(seed); }
 
   inline uint16_t getMaxEnergy() const { return m_maxEnergy; }
   inline uint16_t getMaxGenome() const { return m_maxGenome; }
@@ -22,7 +29,7 @@ class CellFactory
   uint16_t m_maxEnergy;
   uint16_t m_maxGenome;
   bool m_useHVDirections;
-  std::mt19937 m_rng;
+  Random::SplitMix64 m_rng;
 
   uint8_t randomDirection();
 };
@@ -0,0 +1,101 @@
+#pragma once
+#include "cell.h"
+#include "genome_store.h"
+#include <bit>
+#include <cstdint>
+
+// The 32 bits of a cell the renderer needs, colored in shaders/grid.frag:
+//   bits 0-2    type (0 = empty, and then the whole value is 0)
+//   bits 3-9    energy, clamped to 127
+//   bits 10-15  age on a log scale, 4 steps per doubling
+//   bits 16-18  direction the cell faces, in Grid::DX8/DY8 order
+//   bits 19-31  genome key, from the hash of the genes, so equal genomes share it
+// Keep the shader's decoding in step with this layout.
+namespace CellView
+{
+  constexpr int ENERGY_SHIFT = 3;
+  constexpr uint32_t ENERGY_MAX = 127;
+  constexpr int AGE_SHIFT = 10;
+  constexpr uint32_t AGE_MAX = 63;
+  constexpr int DIRECTION_SHIFT = 16;
+  constexpr int KEY_SHIFT = 19;
+  constexpr uint32_t KEY_MAX = 0x1FFF;
+  constexpr int KEY_BITS = std::bit_width(KEY_MAX);
+  static_assert(KEY_SHIFT + KEY_BITS == 32 && KEY_MAX == (1u << KEY_BITS) - 1, "The genome key fills the top bits");
+
+  inline uint32_t getAgeCode( uint32_t age )
+  {
+    // floor(4 * log2(age + 1)) from the leading bit and the two after it
+    const uint64_t value = static_cast<uint64_t>(age) + 1;
+    const int exponent = std::bit_width(value) - 1;
+    const uint32_t fraction = static_cast<uint32_t>(exponent >= 2 ? value >> (exponent - 2) : value << (2 - exponent)) & 3;
+    const uint32_t code = static_cast<uint32_t>(exponent) * 4 + fraction;
+    return code < AGE_MAX ? code : AGE_MAX;
+  }
+
+  inline uint16_t getGenomeKey( uint64_t genomeHash )
+  {
+    // The top bits of the hash, as many as the key holds
+    return static_cast<uint16_t>(genomeHash >> (64 - KEY_BITS));
+  }
+
+  // directionStep is 2 when cells only use the four straight directions,
+  // whose indices then count every other entry of DX8/DY8
+  inline uint32_t pack( const Cell& cell, const GenomeStore& genomes, int directionStep )
+  {
+    if ( !cell.isAlive() ) return 0;
+
+    const uint32_t energy = cell.energy < ENERGY_MAX ? cell.energy : ENERGY_MAX;
+    const uint32_t direction = (static_cast<uint32_t>(cell.direction) * directionStep) & 7;
+    return static_cast<uint32_t>(cell.type)
+      | (energy << ENERGY_SHIFT)
+      | (getAgeCode(cell.age) << AGE_SHIFT)
+      | (direction << DIRECTION_SHIFT)
+      | (static_cast<uint32_t>(getGenomeKey(genomes.getHash(cell.genomeIndex))) << KEY_SHIFT);
+  }
+
+  // One view standing for a 2x2 block: the most common type (sprouts first
+  // on a tie, empty only by majority) with the direction and genome key of
+  // its first cell, and the mean energy and age of the live cells
+  inline uint32_t merge( uint32_t a, uint32_t b, uint32_t c, uint32_t d )
+  {
+    const uint32_t views[4] = { a, b, c, d };
+    int counts[8] = {};
+    uint32_t energy = 0;
+    uint32_t age = 0;
+    uint32_t live = 0;
+    for ( uint32_t view : views )
+    {
+      counts[view & 7]++;
+      if ( view == 0 ) continue;
+      energy += (view >> ENERGY_SHIFT) & ENERGY_MAX;
+      age += (view >> AGE_SHIFT) & AGE_MAX;
+      live++;
+    }
+
+    int type = static_cast<int>(CellType::Sprout);
+    for ( int t = type - 1; t >= 1; --t )
+    {
+      if ( counts[t] > counts[type] ) type = t;
+    }
+    if ( counts[type] == 0 || counts[type] < counts[0] ) return 0;
+
+    uint32_t first = 0;
+    for ( uint32_t view : views )
+    {
+      if ( static_cast<int>(view & 7) == type )
+      {
+        first = view;
+        break;
+      }
+    }
+    return static_cast<uint32_t>(type)
+      | (((energy + live / 2) / live) << ENERGY_SHIFT)
+      | (((age + live / 2) / live) << AGE_SHIFT)
+      | (first & ~((1u << DIRECTION_SHIFT) - 1));
+  }
+
+  inline CellType getType( uint32_t view ) { return static_cast<CellType>(view & 7); }
+  inline int getDirection( uint32_t view ) { return static_cast<int>((view >> DIRECTION_SHIFT) & 7); }
+  inline uint16_t getKey( uint32_t view ) { return static_cast<uint16_t>(view >> KEY_SHIFT); }
+}
@@ -0,0 +1,99 @@
+#include "cell_worklists.h"
+#include <algorithm>
+#include <iterator>
+
+void CellWorklists::rebuild( const Cell* cells, size_t count )
+{
+  for ( int type = 0; type < TYPE_COUNT; ++type )
+  {
+    m_lists[type].clear();
+    m_added[type].clear();
+    m_removed[type].clear();
+  }
+
+  // Empty cells are never visited by a rule, so they get no list
+  for ( uint32_t cell = 0; cell < count; ++cell )
+  {
+    if ( cells[cell].isAlive() )
+    {
+      m_lists[static_cast<int>(cells[cell].type)].push_back(cell);
+    }
+  }
+}
+
+void CellWorklists::rebuildRange( const Cell* cells, uint32_t begin, uint32_t end )
+{
+  for ( int type = 1; type < TYPE_COUNT; ++type )
+  {
+    std::vector<uint32_t>& list = m_lists[type];
+    auto first = std::lower_bound(list.begin(), list.end(), begin);
+    auto last = std::lower_bound(first, list.end(), end);
+
+    m_scratch.clear();
+    for ( uint32_t cell = begin; cell < end; ++cell )
+    {
+      if ( static_cast<int>(cells[cell].type) == type )
+      {
+        m_scratch.push_back(cell);
+      }
+    }
+
+    const size_t at = first - list.begin();
+    list.erase(first, last);
+    list.insert(list.begin() + at, m_scratch.begin(), m_scratch.end());
+  }
+}
+
+void CellWorklists::commit()
+{
+  for ( int type = 1; type < TYPE_COUNT; ++type )
+  {
+    std::vector<uint32_t>& added = m_added[type];
+    std::vector<uint32_t>& removed = m_removed[type];
+    if ( added.empty() && removed.empty() ) continue;
+
+    std::sort(added.begin(), added.end());
+    std::sort(removed.begin(), removed.end());
+
+    // A cell born and killed in the same epoch (or the reverse) leaves the list as it was
+    m_scratch.clear();
+    std::set_intersection(added.begin(), added.end(), removed.begin(), removed.end(), std::back_inserter(m_scratch));
+    if ( !m_scratch.empty() )
+    {
+      auto minus = [&]( std::vector<uint32_t>& values )
+      {
+        std::vector<uint32_t> kept;
+        std::set_difference(values.begin(), values.end(), m_scratch.begin(), m_scratch.end(), std::back_inserter(kept));
+        values.swap(kept);
+      };
+      minus(added);
+      minus(removed);
+    }
+
+    // One merge pass: drop the removed entries and interleave the added ones
+    std::vector<uint32_t>& list = m_lists[type];
+    m_scratch.clear();
+    m_scratch.reserve(list.size() + added.size());
+
+    auto next = removed.begin();
+    auto born = added.begin();
+    for ( uint32_t cell : list )
+    {
+      if ( next != removed.end() && *next == cell )
+      {
+        ++next;
+        continue;
+      }
+      while ( born != added.end() && *born < cell )
+      {
+        m_scratch.push_back(*born++);
+      }
+      m_scratch.push_back(cell);
+    }
+    m_scratch.insert(m_scratch.end(), born, added.end());
+
+    list.swap(m_scratch);
+    added.clear();
+    removed.clear();
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "cell.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Indices of the cells of each CellType, kept sorted so a walk over a list
+// visits memory in address order. Rules run as one loop per type instead of
+// a switch per cell. Type transitions are recorded as they happen and merged
+// into the lists once per epoch, so the cost follows the number of
+// transitions rather than the grid size.
+class CellWorklists
+{
+  public:
+  static constexpr int TYPE_COUNT = 5;
+
+  CellWorklists() = default;
+
+  void rebuild( const Cell* cells, size_t count );
+
+  // Replaces the entries of cells [begin, end) with what the cells hold now
+  void rebuildRange( const Cell* cells, uint32_t begin, uint32_t end );
+
+  // Pending until commit(); an add and a remove of the same entry cancel out
+  inline void add( CellType type, uint32_t cell ) { m_added[static_cast<int>(type)].push_back(cell); }
+  inline void remove( CellType type, uint32_t cell ) { m_removed[static_cast<int>(type)].push_back(cell); }
+  void commit();
+
+  inline std::span<const uint32_t> get( CellType type ) const { return m_lists[static_cast<int>(type)]; }
+
+  private:
+  std::array<std::vector<uint32_t>, TYPE_COUNT> m_lists;
+  std::array<std::vector<uint32_t>, TYPE_COUNT> m_added;
+  std::array<std::vector<uint32_t>, TYPE_COUNT> m_removed;
+  std::vector<uint32_t> m_scratch;
+};
@@ -0,0 +1,52 @@
+#include "ensemble.h"
+#include "core/config.h"
+#include "utils/random.h"
+#include <atomic>
+
+bool Ensemble::init( int replicates, int width, int height, size_t threadCount, uint64_t seed )
+{
+  if ( replicates < 1 ) return false;
+
+  m_epoch = 0;
+  m_pool = std::make_unique<ThreadPool>(threadCount);
+  m_worlds.clear();
+  m_worlds.resize(replicates);
+
+  // Each worker allocates and fills the worlds it will later update
+  std::atomic<bool> ok{ true };
+  m_pool->parallelFor(m_worlds.size(), [&]( size_t begin, size_t end, size_t )
+  {
+    for ( size_t i = begin; i < end; ++i )
+    {
+      if ( !m_worlds[i].init(Config::MAX_ENERGY, Config::MAX_GENOME, width, height, Config::USE_HV_DIRECTIONS, Random::hash(seed, i)) )
+      {
+        ok = false;
+      }
+    }
+  });
+
+  return ok;
+}
+
+void Ensemble::update()
+{
+  m_pool->parallelFor(m_worlds.size(), [this]( size_t begin, size_t end, size_t )
+  {
+    for ( size_t i = begin; i < end; ++i )
+    {
+      m_worlds[i].update();
+    }
+  });
+
+  m_epoch++;
+}
+
+uint64_t Ensemble::countAlive() const
+{
+  uint64_t alive = 0;
+  for ( const Grid& world : m_worlds )
+  {
+    alive += world.getAliveCount();
+  }
+  return alive;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "grid.h"
+#include "utils/thread_pool.h"
+#include <memory>
+#include <vector>
+
+// Runs many replicate worlds over a thread pool. Each replicate is a whole
+// Grid updated inline by the worker whose stripe holds it, so throughput
+// scales with core count up to one replicate per thread.
+class Ensemble
+{
+  public:
+  Ensemble() = default;
+
+  // Replicate i is a Grid seeded with Random::hash(seed, i)
+  bool init( int replicates, int width, int height, size_t threadCount, uint64_t seed );
+  void update();
+
+  uint64_t countAlive() const;
+
+  inline int getReplicates() const { return static_cast<int>(m_worlds.size()); }
+  inline size_t getThreadCount() const { return m_pool ? m_pool->getThreadCount() : 1; }
+  inline uint64_t getEpoch() const { return m_epoch; }
+  inline const Grid& getWorld( int replicate ) const { return m_worlds[replicate]; }
+
+  private:
+  std::vector<Grid> m_worlds;
+  std::unique_ptr<ThreadPool> m_pool;
+
+  uint64_t m_epoch{ 0 };
+};
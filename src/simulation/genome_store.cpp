@@ -0,0 +1,89 @@
+#include "genome_store.h"
+#include "utils/binary_io.h"
+#include "utils/random.h"
+#include <algorithm>
+
+void GenomeStore::init( uint16_t stride, size_t count )
+{
+  m_stride = stride;
+  m_genes.clear();
+  m_genes.resize(static_cast<size_t>(stride) * count);
+  m_hashes.assign(count, hashGenes(std::vector<uint16_t>(stride, 0)));
+  m_free.clear();
+}
+
+uint32_t GenomeStore::allocate()
+{
+  uint32_t index;
+  if ( !m_free.empty() )
+  {
+    index = m_free.back();
+    m_free.pop_back();
+  }
+  else
+  {
+    index = static_cast<uint32_t>(size());
+    m_genes.resize(m_genes.size() + m_stride);
+    m_hashes.push_back(0);
+  }
+
+  std::span<uint16_t> genes = get(index);
+  std::fill(genes.begin(), genes.end(), 0);
+  rehash(index);
+  return index;
+}
+
+uint64_t GenomeStore::hashGenes( std::span<const uint16_t> genes )
+{
+  // Four genes per mixing step
+  uint64_t hash = genes.size();
+  size_t gene = 0;
+  for ( ; gene + 4 <= genes.size(); gene += 4 )
+  {
+    const uint64_t packed = static_cast<uint64_t>(genes[gene])
+      | (static_cast<uint64_t>(genes[gene + 1]) << 16)
+      | (static_cast<uint64_t>(genes[gene + 2]) << 32)
+      | (static_cast<uint64_t>(genes[gene + 3]) << 48);
+    hash = Random::mix(hash ^ packed);
+  }
+  for ( ; gene < genes.size(); ++gene )
+  {
+    hash = Random::mix(hash ^ genes[gene]);
+  }
+  return hash;
+}
+
+void GenomeStore::collect( std::span<const uint8_t> used )
+{
+  m_free.clear();
+  for ( size_t index = size(); index-- > 0; )
+  {
+    if ( index >= used.size() || !used[index] )
+    {
+      m_free.push_back(static_cast<uint32_t>(index));
+    }
+  }
+}
+
+void GenomeStore::write( std::ostream& out ) const
+{
+  BinaryIO::write(out, m_stride);
+  BinaryIO::write(out, static_cast<uint64_t>(size()));
+  BinaryIO::writeArray(out, m_genes.data(), m_genes.size());
+}
+
+bool GenomeStore::read( std::istream& in )
+{
+  uint16_t stride = 0;
+  uint64_t count = 0;
+  if ( !BinaryIO::read(in, stride) || !BinaryIO::read(in, count) ) return false;
+
+  init(stride, count);
+  if ( !BinaryIO::readArray(in, m_genes.data(), m_genes.size()) ) return false;
+
+  for ( size_t index = 0; index < count; ++index )
+  {
+    rehash(static_cast<uint32_t>(index));
+  }
+  return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "utils/mapped_memory.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <vector>
+
+// All genomes in one flat buffer with a fixed stride of maxGenome genes,
+// genome i occupying genes [i * stride, (i + 1) * stride). Slots no longer
+// referenced are handed back by collect() and reused by allocate(). Every
+// slot also has a hash of its genes, so equal genomes in different slots
+// compare equal in O(1); whoever writes genes through get() calls rehash().
+class GenomeStore
+{
+  public:
+  GenomeStore() = default;
+
+  // Sizes the store for count genomes without touching their pages
+  void init( uint16_t stride, size_t count );
+  uint32_t allocate();
+  // Refreshes the hash of a slot after its genes were written
+  inline void rehash( uint32_t index ) { m_hashes[index] = hashGenes(get(index)); }
+  // used holds one flag per slot; every slot without one becomes free
+  void collect( std::span<const uint8_t> used );
+
+  inline std::span<uint16_t> get( uint32_t index ) { return { m_genes.data() + static_cast<size_t>(index) * m_stride, m_stride }; }
+  inline std::span<const uint16_t> get( uint32_t index ) const { return { m_genes.data() + static_cast<size_t>(index) * m_stride, m_stride }; }
+
+  inline uint64_t getHash( uint32_t index ) const { return m_hashes[index]; }
+  static uint64_t hashGenes( std::span<const uint16_t> genes );
+
+  inline uint16_t getStride() const { return m_stride; }
+  inline size_t size() const { return m_stride ? m_genes.size() / m_stride : 0; }
+  inline size_t getFreeCount() const { return m_free.size(); }
+
+  void write( std::ostream& out ) const;
+  bool read( std::istream& in );
+
+  private:
+  MappedVector<uint16_t> m_genes;
+  std::vector<uint64_t> m_hashes;
+  std::vector<uint32_t> m_free; // highest first, so the lowest slot is reused next
+  uint16_t m_stride{ 0 };
+};
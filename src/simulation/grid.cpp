@@ -1,91 +1,1159 @@
 #include "grid.h"
+#include "cell_view.h"
+#include "metabolism.h"
+#include "utils/binary_io.h"
+#include "utils/random.h"
+#include "utils/thread_pool.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <limits>
 
-bool Grid::init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections )
+namespace
+{
+  // Worklists shorter than this run inline; waking the pool costs more
+  constexpr size_t PARALLEL_LIST_LENGTH = 2048;
+}
+
+bool Grid::init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections, uint64_t seed )
+{
+  return initWindow(maxEnergy, maxGenome, width, height, useHVDirections, seed, 0, height);
+}
+
+bool Grid::initWindow( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections, uint64_t seed, int originY, int worldHeight )
 {
   m_width = width;
   m_height = height;
+  m_originY = originY;
+  m_worldHeight = worldHeight;
+  m_epoch = 0;
+  m_seed = seed;
   m_useHVDirections = useHVDirections;
 
   m_cellFactory = CellFactory(maxEnergy, maxGenome, useHVDirections);
 
-  const size_t totalCells = width * height;
+  const size_t totalCells = static_cast<size_t>(width) * height;
   m_cells.resize(totalCells);
   m_pixels.resize(totalCells);
+  m_backPixels.resize(totalCells);
+  m_tilesX = (width + Config::PIXEL_TILE - 1) / Config::PIXEL_TILE;
+  m_tileEpochs.assign(static_cast<size_t>(m_tilesX) * ((height + Config::PIXEL_TILE - 1) / Config::PIXEL_TILE), 0);
+  // Only a whole world is drawn from the grid itself
+  m_pyramid = ViewPyramid();
+  if ( m_pyramidEnabled && height == worldHeight )
+  {
+    m_pyramid.init(width, height, Config::PIXEL_TILE);
+  }
+  resetCursor();
+
+  m_planes.init(width, height);
+  m_soil.init(width, height, Config::SOIL_SCALE, Config::SOIL_INITIAL, m_pool);
+  m_timers.init(m_epoch);
+  m_intents.init(totalCells, getStripeCount());
+  m_mailbox.init(width, height, Config::MAILBOX_TILE, getStripeCount());
+  m_remoteMail.assign(getStripeCount(), {});
+  m_mutations.init(Config::POINT_MUTATION_RATE, Config::INSERTION_RATE, Config::DUPLICATION_RATE, Config::MAX_DUPLICATION, maxGenome);
+  m_offspring.clear();
+  // A linked window only builds forests over its owned rows; the plants
+  // that leave them are rebuilt from what the other slabs publish
+  m_transport.init(width, m_link.shareEdges ? m_link.ownedEnd - m_link.ownedBegin : height, useHVDirections);
+  m_changedCells.clear();
 
-  // Reserve some genome space
-  m_genomes.reserve(1024);
+  // One genome per starting sprout, genome i belonging to cell i
+  m_genomes.init(maxGenome, totalCells);
+  m_importedGenomes.clear();
 
-  // Initialize grid with sprouts
-  for ( int y = 0; y < height; ++y )
+  // Scatter sprouts over an empty world. Each cell draws from its own stream
+  // keyed by its world position, so a window reproduces the same rows as the
+  // full world and stripes can be filled in parallel. Every stripe is written
+  // first by the worker that updates it later, which places its pages on that
+  // worker's node.
+  forEachRowStripe([&]( int rowBegin, int rowEnd, size_t )
   {
-    for ( int x = 0; x < width; ++x )
+    CellFactory factory = m_cellFactory;
+
+    for ( int y = rowBegin; y < rowEnd; ++y )
     {
-      Genome genome = m_cellFactory.createRandomGenome();
-      uint32_t genomeIdx = allocateGenome(std::move(genome));
+      for ( int x = 0; x < width; ++x )
+      {
+        const uint64_t worldIndex = getWorldIndex(x, y);
+        const uint32_t genomeIdx = static_cast<uint32_t>(getIndex(x, y));
+        Cell& cell = getCell(x, y);
 
-      Cell& cell = getCell(x, y);
-      cell = m_cellFactory.createSprout(genomeIdx);
+        if ( !isSeededCell(seed, worldIndex) )
+        {
+          cell = factory.createEmpty();
+          continue;
+        }
 
-      // Set color based on first 3 genes
-      const Genome& g = getGenome(genomeIdx);
-      cell.r = static_cast<uint8_t>((float)g.genes[0] / (maxGenome - 1) * 255.0f);
-      cell.g = static_cast<uint8_t>((float)g.genes[1] / (maxGenome - 1) * 255.0f);
-      cell.b = static_cast<uint8_t>((float)g.genes[2] / (maxGenome - 1) * 255.0f);
+        factory.reseed(Random::hash(seed, worldIndex));
+
+        std::span<uint16_t> genes = m_genomes.get(genomeIdx);
+        factory.randomizeGenome(genes);
+        m_genomes.rehash(genomeIdx);
+
+        cell = factory.createSprout(genomeIdx);
+        cell.energy = Config::SPROUT_ENERGY;
+      }
     }
+  });
+
+  m_worklists.rebuild(m_cells.data(), m_cells.size());
+  m_structureChanged = true;
+  m_trackOrganisms = height == worldHeight;
+  if ( m_trackOrganisms )
+  {
+    m_organisms.init(width, height, useHVDirections);
+    m_organisms.rebuild(m_cells.data(), m_epoch);
+    m_organisms.refreshEnergy(m_cells.data(), m_pool);
   }
 
   updatePixelBuffer();
+  rebuildPlanes();
   return true;
 }
 
+bool Grid::isSeededCell( uint64_t seed, uint64_t worldIndex )
+{
+  // Separate stream from the genome draw so density does not shift genomes
+  const double sample = (Random::hash(seed, worldIndex, 0x5EEDull) >> 11) * 0x1.0p-53;
+  return sample < Config::SPROUT_DENSITY;
+}
+
 void Grid::update()
 {
-  // Update each cell based on its type
-  for ( int y = 0; y < m_height; ++y )
+  advance(std::numeric_limits<double>::infinity());
+}
+
+bool Grid::advance( double maxSeconds )
+{
+  const auto start = std::chrono::steady_clock::now();
+  double elapsed = 0.0;
+
+  do
   {
-    for ( int x = 0; x < m_width; ++x )
+    const Stage stage = m_stage;
+    const auto stageStart = std::chrono::steady_clock::now();
+    const bool done = runStage(stage);
+    const auto stageEnd = std::chrono::steady_clock::now();
+
+    m_epochSeconds += std::chrono::duration<double>(stageEnd - stageStart).count();
+    elapsed = std::chrono::duration<double>(stageEnd - start).count();
+
+    if ( !done ) continue;
+
+    m_pass = 0;
+    m_sliceDone = 0;
+    m_sliceTotal = 0;
+    if ( stage == Stage::Signatures )
     {
-      Cell& cell = getCell(x, y);
+      finishEpoch();
+      return true;
+    }
+    m_stage = static_cast<Stage>(static_cast<int>(stage) + 1);
+  }
+  while ( elapsed < maxSeconds );
+
+  return false;
+}
+
+float Grid::getEpochProgress() const
+{
+  const float slice = m_sliceTotal ? std::min(1.0f, static_cast<float>(m_sliceDone) / m_sliceTotal) : 0.0f;
+  return (static_cast<int>(m_stage) + slice) / static_cast<int>(Stage::Count);
+}
+
+bool Grid::runStage( Stage stage )
+{
+  bool done = true;
+
+  switch ( stage )
+  {
+    // Propose: each rule runs as one loop over its type's worklist, updating
+    // its cells in place and queueing writes to other cells as intents.
+    // Targets are chosen from the signatures of the previous epoch, so the
+    // outcome does not depend on the order cells are visited in.
+    case Stage::Leaves:
+      timeStage(CellType::Leaf, [&]() { done = updateLeaves(); });
+      break;
+    case Stage::Sprouts:
+      timeStage(CellType::Sprout, [&]() { done = updateSprouts(); });
+      break;
+
+    case Stage::Resolve:
+      done = resolveIntents();
+      break;
+    case Stage::Soil:
+      done = updateSoil();
+      break;
+    case Stage::Transport:
+      timeStage(CellType::Wood, [&]() { done = updateTransport(); });
+      break;
 
-      switch ( cell.type )
+    case Stage::Metabolism:
+      done = updateMetabolism();
+      break;
+    case Stage::Deaths:
+      done = handleDeaths();
+      break;
+    case Stage::Finish:
+      done = finishCells();
+      break;
+
+    // The view of the finished cells: pixels and their coarser levels, then
+    // the signatures the next epoch reads. Signatures read the rows above and
+    // below, so all rows are built first.
+    case Stage::Pixels:
+      done = forEachRowSlice([this]( int rowBegin, int rowEnd, size_t )
+      {
+        updatePixelRows(rowBegin, rowEnd);
+      });
+      break;
+    case Stage::Pyramid:
+      done = updatePyramid();
+      break;
+    case Stage::PlaneRows:
+      done = forEachRowSlice([this]( int rowBegin, int rowEnd, size_t )
+      {
+        m_planes.buildRows(m_cells.data(), rowBegin, rowEnd);
+      });
+      break;
+    case Stage::Signatures:
+      if ( m_sliceDone == 0 )
       {
-        case CellType::Empty:
-          break;
-        case CellType::Wood:
-          updateWood(cell, x, y);
-          break;
-        case CellType::Leaf:
-          updateLeaf(cell, x, y);
-          break;
-        case CellType::Root:
-          updateRoot(cell, x, y);
-          break;
-        case CellType::Sprout:
-          updateSprout(cell, x, y);
-          break;
+        m_stripeCounts.assign(getStripeCount(), {});
       }
+      done = forEachRowSlice([this]( int rowBegin, int rowEnd, size_t worker )
+      {
+        m_planes.buildSignatures(rowBegin, rowEnd);
+        for ( int plane = 0; plane < NeighbourPlanes::TYPE_PLANES; ++plane )
+        {
+          m_stripeCounts[worker][plane] += m_planes.count(plane, rowBegin, rowEnd);
+        }
+      });
+      break;
+
+    case Stage::Count:
+      break;
+  }
 
-      if ( cell.isAlive() )
+  return done;
+}
+
+bool Grid::resolveIntents()
+{
+  // One winner per target cell, picked by seeded priority, then the
+  // bookkeeping for the winners, in slices of its own
+  if ( m_pass == 0 )
+  {
+    const bool resolved = m_intents.resolve(m_pool, [this]( const Intent& intent )
+    {
+      applyIntent(intent);
+    }, Config::UPDATE_SLICE_CELLS);
+    if ( resolved )
+    {
+      beginPass();
+    }
+    return false;
+  }
+
+  std::span<const Intent> applied = m_intents.getApplied();
+  return forEachStripeSlice(applied.size(), Config::UPDATE_SLICE_CELLS, false, [&]( size_t begin, size_t end, size_t )
+  {
+    for ( const Intent& intent : applied.subspan(begin, end - begin) )
+    {
+      m_changedCells.push_back(intent.source);
+      m_changedCells.push_back(intent.target);
+      if ( intent.kind == IntentKind::Move )
+      {
+        m_worklists.remove(CellType::Sprout, intent.source);
+        m_worklists.add(CellType::Wood, intent.source);
+      }
+      if ( intent.kind == IntentKind::Divide )
       {
-        cell.age++;
+        m_offspring.push_back(intent.target);
+      }
+      m_worklists.add(m_cells[intent.target].type, intent.target);
+
+      // Every birth is next to the cell that caused it
+      if ( m_trackOrganisms )
+      {
+        m_organisms.addCell(intent.target, intent.source);
       }
     }
+  });
+}
+
+bool Grid::updateSoil()
+{
+  // Roots drain the soil before transport carries their energy away, then
+  // it diffuses: sample rows, the halo exchange, the stencil over rows or
+  // tiles and the buffer swap, each its own pass
+  const auto soilStart = std::chrono::steady_clock::now();
+  bool passDone = true;
+  bool done = false;
+
+  switch ( m_pass )
+  {
+    case 0:
+      timeStage(CellType::Root, [&]()
+      {
+        passDone = forEachStripeSlice(m_soil.getHeight(), Config::UPDATE_SLICE_ROWS, true, [this]( size_t begin, size_t end, size_t )
+        {
+          m_soil.absorbRows(m_cells.data(), Config::ROOT_DRAIN, m_cellFactory.getMaxEnergy(), static_cast<int>(begin), static_cast<int>(end));
+        });
+      });
+      break;
+    case 1:
+      if ( m_link.exchangeSoil )
+      {
+        m_link.exchangeSoil(m_soil);
+      }
+      done = m_epoch % Config::SOIL_DIFFUSION_INTERVAL != 0;
+      if ( !done )
+      {
+        m_soil.beginDiffuse();
+      }
+      break;
+    case 2:
+      passDone = forEachStripeSlice(m_soil.getHeight(), Config::UPDATE_SLICE_ROWS, true, [this]( size_t begin, size_t end, size_t )
+      {
+        m_soil.diffuseRows(Config::SOIL_DIFFUSION_RATE, static_cast<int>(begin), static_cast<int>(end));
+      });
+      break;
+    default:
+      m_soil.endDiffuse();
+      done = true;
+      break;
+  }
+
+  m_epochSoilSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - soilStart).count();
+  if ( passDone && !done )
+  {
+    beginPass();
+  }
+  return done;
+}
+
+bool Grid::updateTransport()
+{
+  // Move energy from leaves and roots to sprouts along the current wood
+  // network: pick the forests to build, build them, then reduce the large
+  // forests one at a time and the small ones in slices
+  switch ( m_pass )
+  {
+    case 0:
+      prepareTransport();
+      break;
+    case 1:
+    {
+      const bool built = forEachStripeSlice(m_transport.getPendingCount(), Config::UPDATE_SLICE_FORESTS, true, [this]( size_t begin, size_t end, size_t )
+      {
+        m_transport.buildPending(m_transportCells, begin, end);
+      });
+      if ( !built ) return false;
+
+      // A linked window's network covers its owned rows only
+      if ( m_link.shareEdges )
+      {
+        Cell* owned = &m_cells[getIndex(0, m_link.ownedBegin)];
+        m_transport.planRun(owned, owned, 0, static_cast<size_t>(m_link.ownedEnd - m_link.ownedBegin) * m_width,
+                            m_cellFactory.getMaxEnergy(), Config::TRANSPORT_RESERVE, m_pool);
+      }
+      else
+      {
+        m_transport.planRun(m_cells.data(), m_cells.data(), 0, m_cells.size(), m_cellFactory.getMaxEnergy(), Config::TRANSPORT_RESERVE, m_pool);
+      }
+      break;
+    }
+    case 2:
+      if ( !forEachStripeSlice(m_transport.getLargeCount(), 1, false, [this]( size_t begin, size_t, size_t )
+      {
+        m_transport.runLarge(begin, m_pool);
+      }) ) return false;
+      break;
+    default:
+      return forEachStripeSlice(m_transport.getSmallCount(), Config::UPDATE_SLICE_FORESTS, true, [this]( size_t begin, size_t end, size_t )
+      {
+        m_transport.runSmall(begin, end);
+      });
+  }
+
+  beginPass();
+  return false;
+}
+
+void Grid::prepareTransport()
+{
+  // A whole world keeps one forest per organism and rebuilds only the
+  // organisms that changed; a window cannot tell organisms apart and
+  // rebuilds everything after any change
+  m_transportCells = m_cells.data();
+
+  if ( m_link.shareEdges )
+  {
+    // The halo is a step behind, so a linked window builds the plants
+    // within its owned rows and leaves those reaching a row next to another
+    // slab, which may go on there, to transportEdges(). Other slabs change
+    // every epoch.
+    const Cell* owned = &m_cells[getIndex(0, m_link.ownedBegin)];
+    const size_t ownedCells = static_cast<size_t>(m_link.ownedEnd - m_link.ownedBegin) * m_width;
+    const size_t lastRow = ownedCells - m_width;
+    const bool above = m_link.ownedBegin > 0;
+    const bool below = m_link.ownedEnd < m_height;
+
+    std::vector<uint32_t> edgeCells;
+    m_transportCells = owned;
+    m_transport.clear();
+    m_transport.prepareTouching(owned, 0, ownedCells, [&]( std::span<const uint32_t> component )
+    {
+      const bool reachesEdge = std::ranges::any_of(component, [&]( uint32_t cell )
+      {
+        return (above && cell < static_cast<uint32_t>(m_width)) || (below && cell >= lastRow);
+      });
+      if ( reachesEdge )
+      {
+        edgeCells.insert(edgeCells.end(), component.begin(), component.end());
+      }
+      return !reachesEdge;
+    });
+    transportEdges(edgeCells);
+  }
+  else if ( !m_trackOrganisms )
+  {
+    if ( m_structureChanged || !m_changedCells.empty() )
+    {
+      m_transport.clear();
+      m_transport.prepareTouching(m_cells.data(), 0, m_cells.size());
+    }
+  }
+  else
+  {
+    // Renumbered organisms invalidate every key
+    const bool rebuild = m_structureChanged || m_transportGeneration != m_organisms.getGeneration();
+    if ( rebuild || !m_changedCells.empty() )
+    {
+      // Changed organisms: those of the changed cells still alive, and those
+      // next to cells that died, which may have shrunk or split
+      std::vector<uint8_t> dirty(m_organisms.getIdCount(), rebuild ? 1 : 0);
+      auto markCell = [&]( int x, int y )
+      {
+        const uint32_t organism = m_organisms.getOrganism(static_cast<uint32_t>(getIndex(x, y)));
+        if ( organism != OrganismRegistry::NONE )
+        {
+          dirty[organism] = 1;
+        }
+      };
+
+      const int step = m_useHVDirections ? 2 : 1;
+      for ( uint32_t cell : rebuild ? std::span<const uint32_t>() : std::span<const uint32_t>(m_changedCells) )
+      {
+        const int x = static_cast<int>(cell % m_width);
+        const int y = static_cast<int>(cell / m_width);
+        if ( m_cells[cell].isAlive() )
+        {
+          markCell(x, y);
+          continue;
+        }
+
+        for ( int d = 0; d < 8; d += step )
+        {
+          if ( isInBounds(x + DX8[d], y + DY8[d]) )
+          {
+            markCell(x + DX8[d], y + DY8[d]);
+          }
+        }
+      }
+
+      // Sprouts now: those of the last epoch minus moved ones, plus this epoch's births
+      std::vector<TransportNetwork::Sprout> sprouts;
+      auto addSprout = [&]( uint32_t cell )
+      {
+        if ( m_cells[cell].type != CellType::Sprout ) return;
+        const uint32_t organism = m_organisms.getOrganism(cell);
+        if ( dirty[organism] )
+        {
+          sprouts.push_back({ organism, cell });
+        }
+      };
+      for ( uint32_t cell : m_worklists.get(CellType::Sprout) )
+      {
+        addSprout(cell);
+      }
+      for ( const Intent& intent : m_intents.getApplied() )
+      {
+        addSprout(intent.target);
+      }
+      std::sort(sprouts.begin(), sprouts.end(), []( const auto& a, const auto& b ) { return a.key != b.key ? a.key < b.key : a.cell < b.cell; });
+
+      // Merged or emptied organisms are dropped along with the changed ones
+      if ( rebuild )
+      {
+        m_transport.clear();
+      }
+      else
+      {
+        m_transport.removeIf([&]( uint32_t key ) { return !m_organisms.isLive(key) || dirty[key]; });
+      }
+      m_transport.prepare(sprouts);
+      m_transportGeneration = m_organisms.getGeneration();
+    }
+  }
+
+  m_structureChanged = false;
+  m_changedCells.clear();
+}
+
+void Grid::transportEdges( std::vector<uint32_t>& owned )
+{
+  // Publish the owned cells of the edge plants
+  std::sort(owned.begin(), owned.end());
+  const uint64_t ownedFirst = static_cast<uint64_t>(m_originY + m_link.ownedBegin) * m_width;
+  std::vector<uint64_t> indices(owned.size());
+  std::vector<Cell> cells(owned.size());
+  for ( size_t i = 0; i < owned.size(); ++i )
+  {
+    indices[i] = ownedFirst + owned[i];
+    cells[i] = m_cells[getIndex(0, m_link.ownedBegin) + owned[i]];
+  }
+  m_link.shareEdges(indices, cells, m_edgeIndices, m_edgeCells);
+
+  // Numbered in world order, the published cells form a graph whose forests
+  // are those a single grid would build. Neighbour indices grow with the
+  // cell's, so one cursor per direction finds them all.
+  const size_t count = m_edgeIndices.size();
+  const int step = m_useHVDirections ? 2 : 1;
+  std::vector<uint32_t> neighbours(count * 8, TransportNetwork::NO_CELL);
+  for ( int d = 0; d < 8; d += step )
+  {
+    size_t cursor = 0;
+    for ( size_t i = 0; i < count; ++i )
+    {
+      const int x = static_cast<int>(m_edgeIndices[i] % m_width) + DX8[d];
+      const int y = static_cast<int>(m_edgeIndices[i] / m_width) + DY8[d];
+      if ( x < 0 || x >= m_width || y < 0 || y >= m_worldHeight ) continue;
+
+      const uint64_t next = static_cast<uint64_t>(y) * m_width + x;
+      while ( cursor < count && m_edgeIndices[cursor] < next )
+      {
+        cursor++;
+      }
+      if ( cursor < count && m_edgeIndices[cursor] == next )
+      {
+        neighbours[i * 8 + d] = static_cast<uint32_t>(cursor);
+      }
+    }
+  }
+
+  // Edge plants are few; build and reduce those holding owned cells at once
+  // and keep the energies of the owned cells
+  const size_t ownBegin = indices.empty() ? 0 : std::lower_bound(m_edgeIndices.begin(), m_edgeIndices.end(), indices.front()) - m_edgeIndices.begin();
+  const size_t ownEnd = ownBegin + indices.size();
+  m_edgeTransport.initGraph(std::move(neighbours), m_useHVDirections);
+  m_edgeTransport.prepareTouching(m_edgeCells.data(), ownBegin, ownEnd);
+  m_edgeTransport.buildPending(m_edgeCells.data(), 0, m_edgeTransport.getPendingCount());
+  m_edgeTransport.planRun(m_edgeCells.data(), m_edgeCells.data(), 0, count,
+                          m_cellFactory.getMaxEnergy(), Config::TRANSPORT_RESERVE, m_pool);
+  for ( size_t i = 0; i < m_edgeTransport.getLargeCount(); ++i )
+  {
+    m_edgeTransport.runLarge(i, m_pool);
+  }
+  m_edgeTransport.runSmall(0, m_edgeTransport.getSmallCount());
+
+  for ( size_t i = 0; i < owned.size(); ++i )
+  {
+    m_cells[getIndex(0, m_link.ownedBegin) + owned[i]].energy = m_edgeCells[ownBegin + i].energy;
+  }
+}
+
+bool Grid::updateMetabolism()
+{
+  // Upkeep, ageing and death detection in one vectorized sweep per stripe.
+  // Deaths collect over all slices and are handled once the sweep is done.
+  if ( m_sliceDone == 0 )
+  {
+    m_deaths.resize(getStripeCount());
+    for ( std::vector<uint32_t>& deaths : m_deaths )
+    {
+      deaths.clear();
+    }
+  }
+
+  return forEachRowSlice([this]( int rowBegin, int rowEnd, size_t worker )
+  {
+    Metabolism::sweep(m_cells.data(), static_cast<size_t>(rowBegin) * m_width, static_cast<size_t>(rowEnd) * m_width, m_deaths[worker]);
+  });
+}
+
+bool Grid::handleDeaths()
+{
+  // Stripes cover the rows in order and each is swept in order, so the
+  // deaths are handled in cell order and decay events (and the soil sums
+  // they make) are the same for any thread count or slicing
+  size_t total = 0;
+  for ( const std::vector<uint32_t>& deaths : m_deaths )
+  {
+    total += deaths.size();
+  }
+
+  return forEachStripeSlice(total, Config::UPDATE_SLICE_CELLS, false, [this]( size_t begin, size_t end, size_t )
+  {
+    size_t offset = 0;
+    for ( const std::vector<uint32_t>& deaths : m_deaths )
+    {
+      const size_t from = std::max(begin, offset);
+      const size_t to = std::min(end, offset + deaths.size());
+      for ( size_t i = from; i < to; ++i )
+      {
+        const uint32_t index = deaths[i - offset];
+        m_timers.schedule(m_epoch + Config::CORPSE_DECAY_EPOCHS, index, CellEvent::Decay);
+        if ( m_trackOrganisms )
+        {
+          m_organisms.removeCell(index);
+        }
+        m_worklists.remove(m_cells[index].type, index);
+        m_cells[index] = m_cellFactory.create(CellType::Empty, 0);
+        m_changedCells.push_back(index);
+      }
+      offset += deaths.size();
+    }
+  });
+}
+
+bool Grid::finishCells()
+{
+  // Due timers in slices, mail, organism splits, their energies by rows,
+  // then the worklists and, every so often, genome collection by rows
+  const bool collect = m_epoch % Config::GENOME_COLLECT_INTERVAL == 0;
+
+  switch ( m_pass )
+  {
+    case 0:
+      if ( !m_timers.advance([this]( const TimedEvent& event ) { fireEvent(event); }, Config::UPDATE_SLICE_CELLS) ) return false;
+      break;
+    case 1:
+      deliverMessages();
+      break;
+    case 2:
+      if ( m_trackOrganisms )
+      {
+        m_organisms.endEpoch(m_cells.data());
+        m_organisms.beginEnergy(getStripeCount());
+      }
+      break;
+    case 3:
+      if ( m_trackOrganisms && !forEachRowSlice([this]( int rowBegin, int rowEnd, size_t worker )
+      {
+        m_organisms.sumEnergy(m_cells.data(), static_cast<size_t>(rowBegin) * m_width, static_cast<size_t>(rowEnd) * m_width, worker);
+      }) ) return false;
+      break;
+    case 4:
+      if ( m_trackOrganisms )
+      {
+        m_organisms.endEnergy();
+      }
+      m_worklists.commit();
+      if ( !collect ) return true;
+      m_genomeMarks.assign(m_genomes.size(), 0);
+      break;
+    case 5:
+      if ( !forEachRowSlice([this]( int rowBegin, int rowEnd, size_t )
+      {
+        markGenomeRows(rowBegin, rowEnd);
+      }) ) return false;
+      break;
+    default:
+      sweepGenomes();
+      return true;
+  }
+
+  beginPass();
+  return false;
+}
+
+void Grid::finishEpoch()
+{
+  // Everything the view reads changes here at once
+  m_pixels.swap(m_backPixels);
+  m_pyramid.swap();
+
+  m_typeCounts.fill(0);
+  for ( const auto& stripe : m_stripeCounts )
+  {
+    for ( int plane = 0; plane < NeighbourPlanes::TYPE_PLANES; ++plane )
+    {
+      m_typeCounts[plane] += stripe[plane];
+    }
   }
 
-  updatePixelBuffer();
   m_epoch++;
+  m_typeSeconds = m_epochTypeSeconds;
+  m_lastUpdateSeconds = m_epochSeconds;
+  m_lastSoilSeconds = m_epochSoilSeconds;
+  resetCursor();
+}
+
+void Grid::resetCursor()
+{
+  m_stage = Stage::Leaves;
+  m_pass = 0;
+  m_sliceDone = 0;
+  m_sliceTotal = 0;
+  m_epochSeconds = 0.0;
+  m_epochSoilSeconds = 0.0;
+  m_epochTypeSeconds.fill(0.0);
+}
+
+void Grid::beginPass()
+{
+  m_pass++;
+  m_sliceDone = 0;
+  m_sliceTotal = 0;
+}
+
+void Grid::deliverMessages()
+{
+  if ( m_link.exchangeMail )
+  {
+    exchangeMail();
+  }
+
+  // Long-range writes queued during the update land on cells that are still
+  // empty after this epoch's births and deaths
+  m_mailbox.deliver(m_pool, [this]( const Message& message )
+  {
+    return applyMessage(message);
+  });
+
+  for ( const Message& message : m_mailbox.getDelivered() )
+  {
+    m_offspring.push_back(message.target);
+  }
+
+  // Founders are registered with the genome they ended up with
+  mutateOffspring();
+
+  for ( const Message& message : m_mailbox.getDelivered() )
+  {
+    m_worklists.add(CellType::Sprout, message.target);
+    if ( m_trackOrganisms )
+    {
+      m_organisms.addFounder(message.target, m_cells[message.target].genomeIndex, m_epoch);
+    }
+    m_changedCells.push_back(message.target);
+  }
+}
+
+void Grid::exchangeMail()
+{
+  // Outgoing seeds carry their genes, since slots mean nothing to another window
+  const size_t genomeSize = getMaxGenome();
+  std::vector<Message> outgoing;
+  std::vector<uint16_t> outgoingGenes;
+  for ( std::vector<Message>& mail : m_remoteMail )
+  {
+    for ( const Message& message : mail )
+    {
+      outgoing.push_back(message);
+      std::span<const uint16_t> genes = m_genomes.get(message.genomeIndex);
+      outgoingGenes.insert(outgoingGenes.end(), genes.begin(), genes.begin() + genomeSize);
+    }
+    mail.clear();
+  }
+
+  m_incomingMail.clear();
+  m_mailGenes.clear();
+  m_link.exchangeMail(outgoing, outgoingGenes, m_incomingMail, m_mailGenes);
+
+  // Delivery sorts by target and key, so the worker posted to does not matter
+  const size_t originIndex = static_cast<size_t>(m_originY) * m_width;
+  for ( size_t i = 0; i < m_incomingMail.size(); ++i )
+  {
+    Message message = m_incomingMail[i];
+    message.target = static_cast<uint32_t>(message.target - originIndex);
+    message.genomeIndex = importGenome(std::span<const uint16_t>(m_mailGenes).subspan(i * genomeSize, genomeSize));
+    m_mailbox.post(0, message);
+  }
+}
+
+void Grid::mutateOffspring()
+{
+  // Cell order keeps slot allocation reproducible. Divided children may have starved since.
+  std::sort(m_offspring.begin(), m_offspring.end());
+  std::erase_if(m_offspring, [this]( uint32_t cell ) { return !m_cells[cell].isAlive(); });
+
+  // Each offspring mutates from a stream keyed by its world position
+  m_offspringGenomes.clear();
+  m_offspringSeeds.clear();
+  const uint64_t epochSeed = Random::hash(m_seed, m_epoch, 0x4D07ull);
+  for ( uint32_t cell : m_offspring )
+  {
+    m_offspringGenomes.push_back(m_cells[cell].genomeIndex);
+    m_offspringSeeds.push_back(Random::hash(epochSeed, static_cast<uint64_t>(m_originY) * m_width + cell));
+  }
+
+  m_mutations.mutate(m_genomes, m_offspringGenomes, m_offspringSeeds);
+
+  for ( size_t i = 0; i < m_offspring.size(); ++i )
+  {
+    m_cells[m_offspring[i]].genomeIndex = m_offspringGenomes[i];
+  }
+  m_offspring.clear();
+}
+
+void Grid::collectGenomes()
+{
+  // Mark and sweep: slots no live cell or organism refers to are reused
+  m_genomeMarks.assign(m_genomes.size(), 0);
+  forEachRowStripe([this]( int rowBegin, int rowEnd, size_t )
+  {
+    markGenomeRows(rowBegin, rowEnd);
+  });
+  sweepGenomes();
+}
+
+void Grid::markGenomeRows( int rowBegin, int rowEnd )
+{
+  // Stripes can share a slot, and all of them write the same value
+  const size_t end = static_cast<size_t>(rowEnd) * m_width;
+  for ( size_t i = static_cast<size_t>(rowBegin) * m_width; i < end; ++i )
+  {
+    if ( m_cells[i].isAlive() )
+    {
+      std::atomic_ref<uint8_t>(m_genomeMarks[m_cells[i].genomeIndex]).store(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void Grid::sweepGenomes()
+{
+  if ( m_trackOrganisms )
+  {
+    m_organisms.markGenomes(m_genomeMarks);
+  }
+  std::erase_if(m_importedGenomes, [this]( const auto& entry ) { return !m_genomeMarks[entry.second]; });
+
+  m_genomes.collect(m_genomeMarks);
+}
+
+void Grid::fireEvent( const TimedEvent& event )
+{
+  const int x = static_cast<int>(event.cell % m_width);
+  const int y = static_cast<int>(event.cell / m_width);
+
+  switch ( event.event )
+  {
+    case CellEvent::Decay:
+      m_soil.deposit(x, y, Config::DEAD_CELL_ORGANIC);
+      break;
+  }
+}
+
+void Grid::updatePixelRows( int rowBegin, int rowEnd )
+{
+  // Tiles whose pixels differ from the published ones are stamped with the
+  // epoch about to be published. Stripes can share a tile row, hence the atomic store.
+  const uint64_t published = m_epoch + 1;
+
+  for ( int y = rowBegin; y < rowEnd; ++y )
+  {
+    uint64_t* tiles = &m_tileEpochs[static_cast<size_t>(y / Config::PIXEL_TILE) * m_tilesX];
+    const size_t row = static_cast<size_t>(y) * m_width;
+
+    for ( int tile = 0; tile < m_tilesX; ++tile )
+    {
+      const size_t begin = row + static_cast<size_t>(tile) * Config::PIXEL_TILE;
+      const size_t end = row + std::min(m_width, (tile + 1) * Config::PIXEL_TILE);
+
+      bool changed = false;
+      for ( size_t i = begin; i < end; ++i )
+      {
+        const uint32_t pixel = CellView::pack(m_cells[i], m_genomes, m_useHVDirections ? 2 : 1);
+        changed |= pixel != m_pixels[i];
+        m_backPixels[i] = pixel;
+      }
+
+      if ( changed )
+      {
+        std::atomic_ref<uint64_t>(tiles[tile]).store(published, std::memory_order_relaxed);
+      }
+    }
+  }
 }
 
 void Grid::updatePixelBuffer()
 {
-  const size_t size = m_cells.size();
-  for ( size_t i = 0; i < size; ++i )
+  forEachRowStripe([this]( int rowBegin, int rowEnd, size_t )
+  {
+    const size_t end = static_cast<size_t>(rowEnd) * m_width;
+    for ( size_t i = static_cast<size_t>(rowBegin) * m_width; i < end; ++i )
+    {
+      m_pixels[i] = CellView::pack(m_cells[i], m_genomes, m_useHVDirections ? 2 : 1);
+    }
+  });
+
+  if ( m_pyramid.getLevelCount() > 0 )
+  {
+    m_pyramid.build(m_pixels, m_pool);
+  }
+}
+
+void Grid::setPyramidEnabled( bool enabled )
+{
+  m_pyramidEnabled = enabled;
+  if ( m_height == 0 ) return;
+
+  m_pyramid = ViewPyramid();
+  if ( enabled && m_height == m_worldHeight )
   {
-    m_pixels[i] = m_cells[i].toRGBA();
+    m_pyramid.init(m_width, m_height, Config::PIXEL_TILE);
+    m_pyramid.build(m_pixels, m_pool);
   }
 }
 
+bool Grid::updatePyramid()
+{
+  if ( m_pyramid.getLevelCount() == 0 ) return true;
+
+  // The back copy is two epochs old, so tiles that changed in either of them are rebuilt
+  const bool done = forEachStripeSlice(m_pyramid.getTilesY(), 1, true, [this]( size_t begin, size_t end, size_t )
+  {
+    m_pyramid.updateTiles(m_backPixels, m_tileEpochs, m_epoch, static_cast<int>(begin), static_cast<int>(end));
+  });
+  if ( done )
+  {
+    m_pyramid.updateCoarse();
+  }
+  return done;
+}
+
+void Grid::rebuildPlanes()
+{
+  // Signatures read the rows above and below, so all rows are built first
+  forEachRowStripe([this]( int rowBegin, int rowEnd, size_t )
+  {
+    m_planes.buildRows(m_cells.data(), rowBegin, rowEnd);
+  });
+
+  std::vector<std::array<uint64_t, NeighbourPlanes::TYPE_PLANES>> counts(getStripeCount());
+
+  forEachRowStripe([&]( int rowBegin, int rowEnd, size_t worker )
+  {
+    m_planes.buildSignatures(rowBegin, rowEnd);
+    for ( int plane = 0; plane < NeighbourPlanes::TYPE_PLANES; ++plane )
+    {
+      counts[worker][plane] = m_planes.count(plane, rowBegin, rowEnd);
+    }
+  });
+
+  m_typeCounts.fill(0);
+  for ( const auto& stripe : counts )
+  {
+    for ( int plane = 0; plane < NeighbourPlanes::TYPE_PLANES; ++plane )
+    {
+      m_typeCounts[plane] += stripe[plane];
+    }
+  }
+}
+
+void Grid::forEachRowStripe( const RowStripeFn& fn )
+{
+  if ( !m_pool )
+  {
+    fn(0, m_height, 0);
+    return;
+  }
+
+  m_pool->parallelFor(m_height, [&]( size_t begin, size_t end, size_t worker )
+  {
+    fn(static_cast<int>(begin), static_cast<int>(end), worker);
+  });
+}
+
+bool Grid::forEachStripeSlice( size_t count, size_t step, bool parallel, const ThreadPool::StripeFn& fn )
+{
+  parallel = parallel && m_pool;
+  const size_t stripes = parallel ? m_pool->getThreadCount() : 1;
+  const size_t done = m_sliceDone;
+
+  auto slice = [&]( size_t begin, size_t end, size_t worker )
+  {
+    const size_t sliceBegin = std::min(end, begin + done);
+    const size_t sliceEnd = std::min(end, sliceBegin + step);
+    if ( sliceBegin < sliceEnd )
+    {
+      fn(sliceBegin, sliceEnd, worker);
+    }
+  };
+
+  if ( parallel )
+  {
+    m_pool->parallelFor(count, slice);
+  }
+  else
+  {
+    slice(0, count, 0);
+  }
+
+  // The first stripe is the longest
+  m_sliceTotal = (count + stripes - 1) / stripes;
+  m_sliceDone += step;
+  return m_sliceDone >= m_sliceTotal;
+}
+
+bool Grid::forEachRowSlice( const RowStripeFn& fn )
+{
+  return forEachStripeSlice(m_height, Config::UPDATE_SLICE_ROWS, true, [&]( size_t begin, size_t end, size_t worker )
+  {
+    fn(static_cast<int>(begin), static_cast<int>(end), worker);
+  });
+}
+
+void Grid::timeStage( CellType type, const std::function<void()>& stage )
+{
+  const auto start = std::chrono::steady_clock::now();
+  stage();
+  m_epochTypeSeconds[static_cast<int>(type)] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t Grid::getStripeCount() const
+{
+  return m_pool ? m_pool->getThreadCount() : 1;
+}
+
+void Grid::exportRows( int y, int rows, Cell* cells, uint16_t* genes ) const
+{
+  const size_t genomeSize = getMaxGenome();
+  const size_t begin = getIndex(0, y);
+  const size_t count = static_cast<size_t>(rows) * m_width;
+
+  std::memcpy(cells, &m_cells[begin], count * sizeof(Cell));
+
+  for ( size_t i = 0; i < count; ++i )
+  {
+    const Cell& cell = m_cells[begin + i];
+    if ( cell.isAlive() )
+    {
+      std::memcpy(genes + i * genomeSize, m_genomes.get(cell.genomeIndex).data(), genomeSize * sizeof(uint16_t));
+    }
+  }
+}
+
+void Grid::importRows( int y, int rows, const Cell* cells, const uint16_t* genes )
+{
+  const size_t genomeSize = getMaxGenome();
+  const size_t begin = getIndex(0, y);
+  const size_t count = static_cast<size_t>(rows) * m_width;
+
+  for ( size_t i = 0; i < count; ++i )
+  {
+    Cell& cell = m_cells[begin + i];
+    cell = cells[i];
+
+    if ( !cell.isAlive() ) continue;
+
+    cell.genomeIndex = importGenome(std::span<const uint16_t>(genes + i * genomeSize, genomeSize));
+  }
+
+  // Received rows, the signatures next to them, their worklist entries and
+  // the transport network are stale now
+  m_structureChanged = true;
+  m_worklists.rebuildRange(m_cells.data(), static_cast<uint32_t>(begin), static_cast<uint32_t>(begin + count));
+  m_planes.buildRows(m_cells.data(), y, y + rows);
+  m_planes.buildSignatures(std::max(0, y - 1), std::min(m_height, y + rows + 1));
+}
+
+namespace
+{
+  constexpr uint32_t WORLD_MAGIC = 0x31575847; // "GXW1"
+}
+
+bool Grid::save( std::ostream& out ) const
+{
+  if ( m_height != m_worldHeight ) return false;
+
+  BinaryIO::write(out, WORLD_MAGIC);
+  BinaryIO::write(out, m_width);
+  BinaryIO::write(out, m_height);
+  BinaryIO::write(out, static_cast<uint8_t>(m_useHVDirections));
+  BinaryIO::write(out, m_cellFactory.getMaxEnergy());
+  BinaryIO::write(out, m_cellFactory.getMaxGenome());
+  BinaryIO::write(out, m_seed);
+  BinaryIO::write(out, m_epoch);
+
+  BinaryIO::writeArray(out, m_cells.data(), m_cells.size());
+  m_genomes.write(out);
+  m_soil.write(out);
+  m_timers.write(out);
+
+  return static_cast<bool>(out);
+}
+
+bool Grid::load( std::istream& in )
+{
+  // Read into a separate grid so a bad file leaves this one untouched
+  Grid loaded;
+  loaded.setThreadPool(m_pool);
+  if ( !loaded.readState(in) ) return false;
+
+  *this = std::move(loaded);
+  return true;
+}
+
+bool Grid::readState( std::istream& in )
+{
+  uint32_t magic = 0;
+  int width = 0;
+  int height = 0;
+  uint8_t useHVDirections = 0;
+  uint16_t maxEnergy = 0;
+  uint16_t maxGenome = 0;
+  uint64_t seed = 0;
+  uint64_t epoch = 0;
+
+  if ( !BinaryIO::read(in, magic) || magic != WORLD_MAGIC ) return false;
+  if ( !BinaryIO::read(in, width) || !BinaryIO::read(in, height) || !BinaryIO::read(in, useHVDirections) ||
+       !BinaryIO::read(in, maxEnergy) || !BinaryIO::read(in, maxGenome) || !BinaryIO::read(in, seed) || !BinaryIO::read(in, epoch) )
+  {
+    return false;
+  }
+  if ( width <= 0 || height <= 0 ) return false;
+
+  // Sizes every buffer, then the saved state replaces the generated world
+  initWindow(maxEnergy, maxGenome, width, height, useHVDirections != 0, seed, 0, height);
+
+  if ( !BinaryIO::readArray(in, m_cells.data(), m_cells.size()) ) return false;
+  if ( !m_genomes.read(in) || m_genomes.getStride() != maxGenome ) return false;
+
+  // Types and genome slots are used as indices from here on
+  const bool cellsValid = std::ranges::all_of(m_cells, [this]( const Cell& cell )
+  {
+    return cell.type <= CellType::Sprout && cell.genomeIndex < m_genomes.size();
+  });
+  if ( !cellsValid ) return false;
+  if ( !m_soil.read(in) ) return false;
+  if ( !m_timers.read(in) || m_timers.getEpoch() != epoch ) return false;
+
+  m_epoch = epoch;
+  m_structureChanged = true;
+  m_worklists.rebuild(m_cells.data(), m_cells.size());
+
+  // Organism ages restart from the loaded epoch
+  if ( m_trackOrganisms )
+  {
+    m_organisms.rebuild(m_cells.data(), m_epoch);
+    m_organisms.refreshEnergy(m_cells.data(), m_pool);
+  }
+
+  // Free slots are not saved
+  collectGenomes();
+
+  updatePixelBuffer();
+  rebuildPlanes();
+  return true;
+}
+
 Cell& Grid::getCell( int x, int y )
 {
   return m_cells[getIndex(x, y)];
@@ -96,39 +1164,200 @@ const Cell& Grid::getCell( int x, int y ) const
   return m_cells[getIndex(x, y)];
 }
 
-Genome& Grid::getGenome( uint32_t index )
+std::span<uint16_t> Grid::getGenome( uint32_t index )
 {
-  return m_genomes[index];
+  return m_genomes.get(index);
 }
 
-const Genome& Grid::getGenome( uint32_t index ) const
+std::span<const uint16_t> Grid::getGenome( uint32_t index ) const
 {
-  return m_genomes[index];
+  return m_genomes.get(index);
 }
 
-uint32_t Grid::allocateGenome( Genome&& genome )
+uint32_t Grid::allocateGenome()
 {
-  uint32_t index = static_cast<uint32_t>(m_genomes.size());
-  m_genomes.push_back(std::move(genome));
-  return index;
+  return m_genomes.allocate();
 }
 
-void Grid::updateWood( Cell& cell, int x, int y )
+uint32_t Grid::importGenome( std::span<const uint16_t> genes )
 {
-  // TODO: Implement wood cell logic
+  // Genome indices are local to the sender, so received genomes are copied
+  // into local slots. Slots are never edited once written (mutation copies
+  // first), so a cell that inherits an imported slot keeps its genes, and
+  // slots are shared by content between halo cells, seeds and exchanges.
+  const uint64_t hash = GenomeStore::hashGenes(genes);
+  auto slot = m_importedGenomes.find(hash);
+  if ( slot == m_importedGenomes.end() || !std::ranges::equal(genes, m_genomes.get(slot->second)) )
+  {
+    const uint32_t copy = allocateGenome();
+    std::ranges::copy(genes, m_genomes.get(copy).begin());
+    m_genomes.rehash(copy);
+    slot = m_importedGenomes.insert_or_assign(hash, copy).first;
+  }
+  return slot->second;
 }
 
-void Grid::updateLeaf( Cell& cell, int x, int y )
+bool Grid::updateLeaves()
 {
-  // TODO: Implement leaf cell logic
+  std::span<const uint32_t> leaves = m_worklists.get(CellType::Leaf);
+  const int maxEnergy = m_cellFactory.getMaxEnergy();
+
+  return forEachStripeSlice(leaves.size(), Config::UPDATE_SLICE_CELLS, leaves.size() >= PARALLEL_LIST_LENGTH, [&]( size_t begin, size_t end, size_t )
+  {
+    for ( size_t i = begin; i < end; ++i )
+    {
+      Cell& cell = m_cells[leaves[i]];
+      cell.energy = static_cast<uint16_t>(std::min<int>(cell.energy + Config::LEAF_ENERGY, maxEnergy));
+    }
+  });
 }
 
-void Grid::updateRoot( Cell& cell, int x, int y )
+bool Grid::updateSprouts()
 {
-  // TODO: Implement root cell logic
+  std::span<const uint32_t> sprouts = m_worklists.get(CellType::Sprout);
+
+  return forEachStripeSlice(sprouts.size(), Config::UPDATE_SLICE_CELLS, sprouts.size() >= PARALLEL_LIST_LENGTH, [&]( size_t begin, size_t end, size_t worker )
+  {
+    for ( size_t i = begin; i < end; ++i )
+    {
+      const uint32_t index = sprouts[i];
+      updateSprout(m_cells[index], static_cast<int>(index % m_width), static_cast<int>(index / m_width), worker);
+    }
+  });
 }
 
-void Grid::updateSprout( Cell& cell, int x, int y )
+void Grid::updateSprout( Cell& cell, int x, int y, size_t worker )
 {
-  // TODO: Implement sprout cell logic
+  // Gene for this epoch: low 2 bits pick the action, the next values pick
+  // the child type and the turn relative to the current heading
+  std::span<const uint16_t> genes = getGenome(cell.genomeIndex);
+  const uint16_t gene = genes[cell.age % genes.size()];
+
+  const int directions = m_useHVDirections ? 4 : 8;
+  const uint8_t direction = static_cast<uint8_t>((cell.direction + gene / 12) % directions);
+  const int action = gene % 4;
+
+  // The last action either turns or, on odd child-type bits, throws a seed
+  if ( action == 3 )
+  {
+    if ( (gene / 4) % 2 )
+    {
+      disperseSeed(cell, x, y, worker);
+      return;
+    }
+    cell.direction = direction;
+    return;
+  }
+
+  const IntentKind kind = static_cast<IntentKind>(action);
+  const uint16_t cost = kind == IntentKind::Grow ? Config::GROW_COST : kind == IntentKind::Move ? Config::MOVE_COST : Config::DIVIDE_COST;
+  if ( cell.energy < cost ) return;
+
+  // The 4-neighbourhood uses every other signature bit
+  const int d = m_useHVDirections ? direction * 2 : direction;
+  if ( !((m_planes.getEmptyNeighbours(x, y) >> d) & 1) ) return;
+
+  Intent intent;
+  intent.key = IntentResolver::makeKey(m_seed, m_epoch, getWorldIndex(x, y));
+  intent.source = static_cast<uint32_t>(getIndex(x, y));
+  intent.target = static_cast<uint32_t>(getIndex(x + DX8[d], y + DY8[d]));
+  intent.kind = kind;
+  intent.childType = static_cast<CellType>(static_cast<int>(CellType::Wood) + (gene / 4) % 3);
+  intent.direction = direction;
+  m_intents.propose(worker, intent);
+}
+
+void Grid::disperseSeed( Cell& cell, int x, int y, size_t worker )
+{
+  if ( cell.energy < Config::DISPERSE_COST ) return;
+
+  // Halo cells are copies; their owner throws their seeds
+  if ( !isOwnedRow(y) ) return;
+
+  // Landing spot from the cell's own stream, far beyond the neighbourhood
+  // that intents cover. Seeds thrown out of the world, or out of a window
+  // without a link, are not sent.
+  constexpr int span = 2 * Config::DISPERSAL_RADIUS + 1;
+  const uint64_t worldIndex = getWorldIndex(x, y);
+  const uint64_t draw = Random::hash(m_seed, m_epoch, worldIndex ^ 0xD15Bull);
+  const int tx = x + static_cast<int>(draw % span) - Config::DISPERSAL_RADIUS;
+  const int ty = y + static_cast<int>((draw >> 32) % span) - Config::DISPERSAL_RADIUS;
+  if ( tx < 0 || tx >= m_width || m_originY + ty < 0 || m_originY + ty >= m_worldHeight || (tx == x && ty == y) ) return;
+  if ( !m_link.exchangeMail && !isInBounds(tx, ty) ) return;
+
+  cell.energy -= Config::DISPERSE_COST;
+
+  Message message;
+  message.key = IntentResolver::makeKey(m_seed, m_epoch, worldIndex);
+  message.genomeIndex = cell.genomeIndex;
+  message.energy = Config::SEED_ENERGY;
+  message.kind = MessageKind::Seed;
+  message.direction = static_cast<uint8_t>(draw >> 8) % (m_useHVDirections ? 4 : 8);
+
+  // Halo rows are overwritten by their owner, so it gets every seed aimed there
+  if ( isOwnedRow(ty) )
+  {
+    message.target = static_cast<uint32_t>(getIndex(tx, ty));
+    m_mailbox.post(worker, message);
+  }
+  else
+  {
+    message.target = static_cast<uint32_t>(getWorldIndex(tx, ty));
+    m_remoteMail[worker].push_back(message);
+  }
+}
+
+void Grid::applyIntent( const Intent& intent )
+{
+  // Sources are occupied and targets were empty, so a winner touches two cells no one else writes
+  Cell& source = m_cells[intent.source];
+  Cell& target = m_cells[intent.target];
+
+  switch ( intent.kind )
+  {
+    // Energy spent on growing or moving becomes the new cell's first reserve
+    case IntentKind::Grow:
+      source.energy -= Config::GROW_COST;
+      target = m_cellFactory.create(intent.childType, intent.direction);
+      target.genomeIndex = source.genomeIndex;
+      target.energy = Config::GROW_COST;
+      break;
+
+    case IntentKind::Move:
+      source.energy -= Config::MOVE_COST;
+      target = source;
+      target.direction = intent.direction;
+      source = m_cellFactory.create(CellType::Wood, intent.direction);
+      source.genomeIndex = target.genomeIndex;
+      source.energy = Config::MOVE_COST;
+      break;
+
+    case IntentKind::Divide:
+      // The child shares the parent's genome slot until mutation gives it its own
+      source.energy -= Config::DIVIDE_COST;
+      target = source;
+      target.energy = source.energy / 2;
+      target.age = 0;
+      target.direction = intent.direction;
+      source.energy -= target.energy;
+      break;
+  }
+}
+
+bool Grid::applyMessage( const Message& message )
+{
+  // Called for one target per tile at a time, so only the target is written
+  Cell& target = m_cells[message.target];
+
+  switch ( message.kind )
+  {
+    // A seed that lands on an occupied cell is lost along with its energy
+    case MessageKind::Seed:
+      if ( target.isAlive() ) return false;
+      target = m_cellFactory.create(CellType::Sprout, message.direction);
+      target.genomeIndex = message.genomeIndex;
+      target.energy = message.energy;
+      return true;
+  }
+  return false;
 }
@@ -1,42 +1,229 @@
 #pragma once
 #include "cell.h"
 #include "cell_factory.h"
+#include "cell_worklists.h"
+#include "genome_store.h"
+#include "intent_resolver.h"
+#include "mailbox.h"
+#include "mutation_engine.h"
+#include "neighbour_planes.h"
+#include "organism_registry.h"
+#include "soil_field.h"
+#include "timing_wheel.h"
+#include "transport_network.h"
+#include "view_pyramid.h"
 #include "core/config.h"
+#include "utils/mapped_memory.h"
+#include "utils/thread_pool.h"
 #include <vector>
+#include <array>
 #include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <unordered_map>
 
 class Grid
 {
   public:
   Grid() = default;
 
-  bool init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections );
+  bool init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections, uint64_t seed );
+  // Holds rows [originY, originY + height) of a world that is worldHeight rows tall
+  bool initWindow( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections, uint64_t seed, int originY, int worldHeight );
   void update();
+  // Advances the current epoch one work slice at a time until it completes
+  // or about maxSeconds have passed, and returns whether it completed. Until
+  // then pixels, counts and the epoch number show the last completed epoch.
+  bool advance( double maxSeconds );
   void updatePixelBuffer();
 
+  // Share of the current epoch done so far, 0 between epochs
+  float getEpochProgress() const;
+  inline bool isEpochInProgress() const { return m_stage != Stage::Leaves || m_sliceDone != 0; }
+
+  // Whole-world state including pending timed events; derived structures are
+  // rebuilt on load. A failed load leaves the grid as it was.
+  bool save( std::ostream& out ) const;
+  bool load( std::istream& in );
+
+  // Row stripes are split across the pool; without one everything runs inline
+  inline void setThreadPool( ThreadPool* pool ) { m_pool = pool; }
+  inline ThreadPool* getThreadPool() const { return m_pool; }
+
+  // The pyramid of coarser pixel levels is kept only for a grid that is
+  // drawn, and never for a slab window. Takes effect from the next init, or
+  // at once between epochs.
+  void setPyramidEnabled( bool enabled );
+
   inline int getWidth() const { return m_width; }
   inline int getHeight() const { return m_height; }
-  inline const std::vector<uint32_t>& getPixels() const { return m_pixels; }
+  inline int getOriginY() const { return m_originY; }
+  inline int getWorldHeight() const { return m_worldHeight; }
+  // One packed CellView per cell, as of the last completed epoch
+  inline std::span<const uint32_t> getPixels() const { return m_pixels; }
+  // Per tile of PIXEL_TILE x PIXEL_TILE pixels, row-major: the last epoch whose pixels differ from the one before
+  inline std::span<const uint64_t> getTileEpochs() const { return m_tileEpochs; }
+  inline int getTilesX() const { return m_tilesX; }
+  // Coarser levels of the pixels, empty for a slab window
+  inline std::span<const std::span<const uint32_t>> getPixelLevels() const { return m_pyramid.getLevels(); }
   inline uint64_t getEpoch() const { return m_epoch; }
+  inline uint64_t getSeed() const { return m_seed; }
+  inline uint64_t getAliveCount() const { return m_typeCounts[NeighbourPlanes::OCCUPIED]; }
+  inline uint64_t getTypeCount( CellType type ) const { return m_typeCounts[static_cast<int>(type)]; }
+  inline const NeighbourPlanes& getPlanes() const { return m_planes; }
+  inline uint16_t getMaxEnergy() const { return m_cellFactory.getMaxEnergy(); }
+  inline uint16_t getMaxGenome() const { return m_cellFactory.getMaxGenome(); }
+  inline bool usesHVDirections() const { return m_useHVDirections; }
+  inline const IntentResolver& getIntents() const { return m_intents; }
+  inline const Mailbox& getMailbox() const { return m_mailbox; }
+  inline const MutationEngine& getMutations() const { return m_mutations; }
+  inline const GenomeStore& getGenomes() const { return m_genomes; }
+
+  // Only whole worlds track organisms; a slab window cannot see plants across its edges
+  inline bool hasOrganisms() const { return m_trackOrganisms; }
+  inline const OrganismRegistry& getOrganisms() const { return m_organisms; }
+  inline const TransportNetwork& getTransport() const { return m_transport; }
+  inline const SoilField& getSoil() const { return m_soil; }
+  inline const TimingWheel& getTimers() const { return m_timers; }
+
+  // Wall time of the last update() and of its soil stage
+  inline double getLastUpdateSeconds() const { return m_lastUpdateSeconds; }
+  inline double getLastSoilSeconds() const { return m_lastSoilSeconds; }
+  // Wall time of the last epoch's rule for each type: the leaf and sprout
+  // kernels, root uptake from the soil and transport through wood
+  inline double getTypeSeconds( CellType type ) const { return m_typeSeconds[static_cast<int>(type)]; }
+  inline const CellWorklists& getWorklists() const { return m_worklists; }
+
+  // Whether the starting layout puts a sprout at this world position
+  static bool isSeededCell( uint64_t seed, uint64_t worldIndex );
+
+  // Row transfer for halo exchange. Genes are packed getMaxGenome() per cell.
+  void exportRows( int y, int rows, Cell* cells, uint16_t* genes ) const;
+  void importRows( int y, int rows, const Cell* cells, const uint16_t* genes );
+
+  // How a slab window reaches the rest of the world during an epoch. Every
+  // window of a world calls each hook once per epoch, in the same order.
+  // Set before initWindow.
+  struct WindowLink
+  {
+    int ownedBegin{ 0 }; // local rows this window updates; the others are halo
+    int ownedEnd{ 0 };
+    // Sends seeds thrown at rows owned elsewhere, with world-index targets
+    // and genes packed getMaxGenome() per message, and receives the seeds
+    // thrown at this window's owned rows the same way
+    std::function<void( std::span<const Message> outgoing, std::span<const uint16_t> outgoingGenes,
+                        std::vector<Message>& incoming, std::vector<uint16_t>& incomingGenes )> exchangeMail;
+    // Replaces the soil samples of the halo rows with their owners' after
+    // roots have drained them and before they diffuse
+    std::function<void( SoilField& soil )> exchangeSoil;
+    // Publishes the owned cells of the plants that reach a slab edge, as
+    // sorted world indices and their cells, and once every window has
+    // published fills sharedIndices and sharedCells with what all of them,
+    // this one included, published, in world order
+    std::function<void( std::span<const uint64_t> indices, std::span<const Cell> cells,
+                        std::vector<uint64_t>& sharedIndices, std::vector<Cell>& sharedCells )> shareEdges;
+  };
+  // Without a link a window owns all its rows and seeds thrown out of it are lost
+  inline void setWindowLink( WindowLink link ) { m_link = std::move(link); }
 
   Cell& getCell( int x, int y );
   const Cell& getCell( int x, int y ) const;
 
-  Genome& getGenome( uint32_t index );
-  const Genome& getGenome( uint32_t index ) const;
+  std::span<uint16_t> getGenome( uint32_t index );
+  std::span<const uint16_t> getGenome( uint32_t index ) const;
 
   private:
-  std::vector<Cell> m_cells;
-  std::vector<Genome> m_genomes;
-  std::vector<uint32_t> m_pixels;
+  // Steps of one epoch in the order advance() runs them. Sliced steps process
+  // part of every stripe per call; steps with passes run them in order, each
+  // sliced or a single unit of work.
+  enum class Stage : uint8_t
+  {
+    Leaves,       // sliced
+    Sprouts,      // sliced
+    Resolve,      // passes: resolve, winners
+    Soil,         // passes: uptake, exchange, diffusion, swap
+    Transport,    // passes: plan, build, large forests, small forests
+    Metabolism,   // sliced
+    Deaths,       // sliced
+    Finish,       // passes: timers, mail, organisms, energies, worklists, marks, sweep
+    Pixels,       // sliced
+    Pyramid,      // sliced
+    PlaneRows,    // sliced
+    Signatures,   // sliced
+    Count
+  };
+
+  // Large buffers come from MappedMemory so they can sit on huge pages and be
+  // first touched by the worker that owns each row stripe
+  MappedVector<Cell> m_cells;
+  GenomeStore m_genomes;
+  MappedVector<uint32_t> m_pixels;
+  MappedVector<uint32_t> m_backPixels; // written during the epoch, swapped with m_pixels at its end
+  std::vector<uint64_t> m_tileEpochs;
+  ViewPyramid m_pyramid;
+  bool m_pyramidEnabled{ false };
+  int m_tilesX{ 0 };
+  NeighbourPlanes m_planes;
+  IntentResolver m_intents;
+  Mailbox m_mailbox;
+  MutationEngine m_mutations;
+  std::vector<uint32_t> m_offspring;        // cells born by reproduction this epoch
+  std::vector<uint32_t> m_offspringGenomes; // their genomes, as a batch for m_mutations
+  std::vector<uint64_t> m_offspringSeeds;   // and their mutation streams
+  std::vector<uint8_t> m_genomeMarks;
+  OrganismRegistry m_organisms;
+  TransportNetwork m_transport;
+  TransportNetwork m_edgeTransport; // linked windows: plants crossing slab edges, over m_edgeCells
+  std::vector<uint64_t> m_edgeIndices;
+  std::vector<Cell> m_edgeCells;
+  SoilField m_soil;
+  TimingWheel m_timers;
+  CellWorklists m_worklists;
+  std::vector<std::vector<uint32_t>> m_deaths; // per worker, reused every epoch
+
+  ThreadPool* m_pool{ nullptr };
 
   CellFactory m_cellFactory{ Config::MAX_ENERGY, Config::MAX_GENOME, true };
 
+  WindowLink m_link;
+  std::vector<std::vector<Message>> m_remoteMail; // per worker, seeds for rows owned elsewhere
+  std::vector<Message> m_incomingMail;
+  std::vector<uint16_t> m_mailGenes;
+
+  // Slots holding genomes received through importRows, keyed by content hash
+  std::unordered_map<uint64_t, uint32_t> m_importedGenomes;
+
   int m_width{ 0 };
   int m_height{ 0 };
+  int m_originY{ 0 };
+  int m_worldHeight{ 0 };
   uint64_t m_epoch{ 0 };
+  uint64_t m_seed{ 0 };
+  // Per plane of m_planes: alive cells, then one count per CellType
+  std::array<uint64_t, NeighbourPlanes::TYPE_PLANES> m_typeCounts{};
 
   bool m_useHVDirections{ true };
+  bool m_trackOrganisms{ false };
+  bool m_structureChanged{ true }; // the whole transport network must be rebuilt
+  std::vector<uint32_t> m_changedCells; // born, died or changed type since the last transport update
+  uint64_t m_transportGeneration{ 0 }; // organism ids the transport network is keyed by
+  const Cell* m_transportCells{ nullptr }; // what this epoch's forests are built over
+
+  double m_lastUpdateSeconds{ 0.0 };
+  double m_lastSoilSeconds{ 0.0 };
+  std::array<double, CellWorklists::TYPE_COUNT> m_typeSeconds{};
+
+  // Resumable position in the current epoch
+  Stage m_stage{ Stage::Leaves };
+  uint8_t m_pass{ 0 };      // pass of the current stage
+  size_t m_sliceDone{ 0 };  // items done per stripe in the current sliced stage or pass
+  size_t m_sliceTotal{ 0 }; // items of the longest stripe, 0 outside sliced stages
+  double m_epochSeconds{ 0.0 };
+  double m_epochSoilSeconds{ 0.0 };
+  std::array<double, CellWorklists::TYPE_COUNT> m_epochTypeSeconds{};
+  std::vector<std::array<uint64_t, NeighbourPlanes::TYPE_PLANES>> m_stripeCounts;
 
   // Direction vectors
   static constexpr int DX8[] = { 0, 1, 1, 1, 0, -1, -1, -1 };
@@ -46,11 +233,57 @@ class Grid
 
   inline int getIndex( int x, int y ) const { return y * m_width + x; }
   inline bool isInBounds( int x, int y ) const { return x >= 0 && x < m_width && y >= 0 && y < m_height; }
+  inline uint64_t getWorldIndex( int x, int y ) const { return static_cast<uint64_t>(m_originY + y) * m_width + x; }
+  inline bool isOwnedRow( int y ) const { return !m_link.exchangeMail || (y >= m_link.ownedBegin && y < m_link.ownedEnd); }
+
+  // Replaces the whole state with a saved world, leaving it half-replaced on failure
+  bool readState( std::istream& in );
+
+  bool runStage( Stage stage );
+  bool resolveIntents();
+  bool updateSoil();
+  bool updateTransport();
+  void prepareTransport();
+  // Moves the energy of the plants whose owned cells, local to the first owned row, reach another slab
+  void transportEdges( std::vector<uint32_t>& owned );
+  bool handleDeaths();
+  bool finishCells();
+  void finishEpoch();
+  void resetCursor();
+  void beginPass(); // moves to the next pass of the current stage
+
+  bool updateLeaves();
+  bool updateSprouts();
+  void updateSprout( Cell& cell, int x, int y, size_t worker );
+  void disperseSeed( Cell& cell, int x, int y, size_t worker );
+  void applyIntent( const Intent& intent );
+  bool applyMessage( const Message& message );
+  void deliverMessages();
+  void exchangeMail();
+  void mutateOffspring();
+  void collectGenomes();
+  void markGenomeRows( int rowBegin, int rowEnd );
+  void sweepGenomes();
+  bool updateMetabolism();
+  void fireEvent( const TimedEvent& event );
+
+  uint32_t allocateGenome();
+  // Local slot holding genes received from another window
+  uint32_t importGenome( std::span<const uint16_t> genes );
+
+  void updatePixelRows( int rowBegin, int rowEnd );
+  bool updatePyramid();
+  void rebuildPlanes();
 
-  void updateWood( Cell& cell, int x, int y );
-  void updateLeaf( Cell& cell, int x, int y );
-  void updateRoot( Cell& cell, int x, int y );
-  void updateSprout( Cell& cell, int x, int y );
+  using RowStripeFn = std::function<void( int rowBegin, int rowEnd, size_t worker )>;
+  void forEachRowStripe( const RowStripeFn& fn );
+  size_t getStripeCount() const;
 
-  uint32_t allocateGenome( Genome&& genome );
+  // Runs fn on the next step items of every stripe of count items, resuming
+  // from m_sliceDone, and returns whether all stripes are done. Stripes are
+  // those of a whole pass, so every worker keeps the rows it owns. Without
+  // parallel everything is one stripe run inline.
+  bool forEachStripeSlice( size_t count, size_t step, bool parallel, const ThreadPool::StripeFn& fn );
+  bool forEachRowSlice( const RowStripeFn& fn );
+  void timeStage( CellType type, const std::function<void()>& stage );
 };
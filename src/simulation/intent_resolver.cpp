@@ -0,0 +1,154 @@
+#include "intent_resolver.h"
+#include "utils/random.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace
+{
+  constexpr uint64_t UNCLAIMED = std::numeric_limits<uint64_t>::max();
+}
+
+void IntentResolver::init( size_t cellCount, size_t workers )
+{
+  m_buffers.resize(workers);
+  for ( std::vector<Intent>& buffer : m_buffers )
+  {
+    buffer.clear();
+  }
+
+  m_applied.clear();
+  m_phase = Phase::Claim;
+  m_done = 0;
+
+  m_claims.resize(cellCount);
+  std::fill(m_claims.begin(), m_claims.end(), UNCLAIMED);
+}
+
+uint64_t IntentResolver::makeKey( uint64_t seed, uint64_t epoch, uint64_t worldIndex )
+{
+  const uint64_t priority = Random::hash(seed, epoch, worldIndex) >> 32;
+  return (priority << 32) | (worldIndex & 0xFFFFFFFFull);
+}
+
+void IntentResolver::forEachBuffer( ThreadPool* pool, const std::function<void( std::vector<Intent>& buffer, size_t index )>& fn )
+{
+  if ( !pool )
+  {
+    for ( size_t i = 0; i < m_buffers.size(); ++i )
+    {
+      fn(m_buffers[i], i);
+    }
+    return;
+  }
+
+  // Buffer i was filled by worker i, so it is also drained there
+  pool->parallelFor(m_buffers.size(), [&]( size_t begin, size_t end, size_t )
+  {
+    for ( size_t i = begin; i < end; ++i )
+    {
+      fn(m_buffers[i], i);
+    }
+  });
+}
+
+bool IntentResolver::resolve( ThreadPool* pool, const ApplyFn& apply, size_t maxIntents )
+{
+  if ( m_phase == Phase::Claim && m_done == 0 )
+  {
+    m_won.assign(m_buffers.size(), 0);
+    m_intents = 0;
+    for ( const std::vector<Intent>& buffer : m_buffers )
+    {
+      m_intents += buffer.size();
+    }
+  }
+
+  const size_t begin = m_done;
+  const size_t end = maxIntents > SIZE_MAX - begin ? SIZE_MAX : begin + maxIntents;
+
+  switch ( m_phase )
+  {
+    // Claim: every intent lowers its target's slot to its key
+    case Phase::Claim:
+      forEachBuffer(pool, [&]( std::vector<Intent>& buffer, size_t )
+      {
+        for ( size_t i = begin; i < std::min(end, buffer.size()); ++i )
+        {
+          const Intent& intent = buffer[i];
+          std::atomic_ref<uint64_t> claim(m_claims[intent.target]);
+          uint64_t current = claim.load(std::memory_order_relaxed);
+          while ( intent.key < current && !claim.compare_exchange_weak(current, intent.key, std::memory_order_relaxed) )
+          {
+          }
+        }
+      });
+      break;
+
+    // Apply: winners own their target and source exclusively, so no locking
+    // is needed. Each buffer keeps only its winners at the front.
+    case Phase::Apply:
+      forEachBuffer(pool, [&]( std::vector<Intent>& buffer, size_t index )
+      {
+        for ( size_t i = begin; i < std::min(end, buffer.size()); ++i )
+        {
+          const Intent& intent = buffer[i];
+          if ( m_claims[intent.target] == intent.key )
+          {
+            apply(intent);
+            buffer[m_won[index]++] = intent;
+          }
+        }
+      });
+      break;
+
+    // Release claims: every claimed target has exactly one winner, so the
+    // winners cover them all and the cost stays proportional to the intents
+    case Phase::Release:
+      forEachBuffer(pool, [&]( std::vector<Intent>& buffer, size_t )
+      {
+        for ( size_t i = begin; i < std::min(end, buffer.size()); ++i )
+        {
+          std::atomic_ref<uint64_t>(m_claims[buffer[i].target]).store(UNCLAIMED, std::memory_order_relaxed);
+        }
+      });
+      break;
+  }
+
+  size_t longest = 0;
+  for ( const std::vector<Intent>& buffer : m_buffers )
+  {
+    longest = std::max(longest, buffer.size());
+  }
+  m_done = end;
+  if ( m_done < longest ) return false;
+
+  m_done = 0;
+  if ( m_phase == Phase::Claim )
+  {
+    m_phase = Phase::Apply;
+    return false;
+  }
+  if ( m_phase == Phase::Apply )
+  {
+    for ( size_t i = 0; i < m_buffers.size(); ++i )
+    {
+      m_buffers[i].resize(m_won[i]);
+    }
+    m_phase = Phase::Release;
+    return false;
+  }
+
+  m_applied.clear();
+  for ( std::vector<Intent>& buffer : m_buffers )
+  {
+    m_applied.insert(m_applied.end(), buffer.begin(), buffer.end());
+    buffer.clear();
+  }
+
+  m_lastIntents = m_intents;
+  m_lastConflicts = m_intents - m_applied.size();
+  m_phase = Phase::Claim;
+  return true;
+}
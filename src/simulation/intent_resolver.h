@@ -0,0 +1,80 @@
+#pragma once
+#include "cell.h"
+#include "utils/mapped_memory.h"
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+enum class IntentKind : uint8_t
+{
+  Grow,   // place a new Wood/Leaf/Root in the target
+  Move,   // sprout steps into the target and leaves Wood behind
+  Divide  // a new sprout with half the energy appears in the target
+};
+
+struct Intent
+{
+  uint64_t key;       // priority in the high half, source world index in the low half; lowest wins
+  uint32_t source;    // local cell indices
+  uint32_t target;
+  IntentKind kind;
+  CellType childType;
+  uint8_t direction;
+};
+
+// Two-phase update for actions that write to another cell. During the
+// propose phase every worker appends intents to its own buffer without
+// touching shared state. resolve() then claims each target with an atomic
+// min over the intents' keys, and applies only the winner per target. Keys
+// come from (seed, epoch, source position), so the winner is independent
+// of scan order and thread count.
+class IntentResolver
+{
+  public:
+  using ApplyFn = std::function<void( const Intent& intent )>;
+
+  IntentResolver() = default;
+
+  void init( size_t cellCount, size_t workers );
+
+  inline void propose( size_t worker, const Intent& intent ) { m_buffers[worker].push_back(intent); }
+
+  // Runs claim and apply on the pool, one buffer per worker; apply is called
+  // for winners only. Each call takes the next maxIntents of every buffer
+  // through the current phase and returns whether the resolve is done; call
+  // again until it is. Proposing again before then is not allowed.
+  bool resolve( ThreadPool* pool, const ApplyFn& apply, size_t maxIntents );
+
+  // Winners of the last resolve, valid until the next one
+  inline std::span<const Intent> getApplied() const { return m_applied; }
+
+  inline size_t getLastIntentCount() const { return m_lastIntents; }
+  inline size_t getLastConflictCount() const { return m_lastConflicts; }
+
+  static uint64_t makeKey( uint64_t seed, uint64_t epoch, uint64_t worldIndex );
+
+  private:
+  std::vector<std::vector<Intent>> m_buffers;
+  MappedVector<uint64_t> m_claims; // per cell, UINT64_MAX when unclaimed
+  std::vector<Intent> m_applied;
+
+  // Resumable position of the current resolve
+  enum class Phase : uint8_t
+  {
+    Claim,
+    Apply,
+    Release
+  };
+  Phase m_phase{ Phase::Claim };
+  size_t m_done{ 0 };         // intents of every buffer through the current phase
+  std::vector<size_t> m_won;  // per buffer, winners kept at its front so far
+  size_t m_intents{ 0 };
+
+  size_t m_lastIntents{ 0 };
+  size_t m_lastConflicts{ 0 };
+
+  void forEachBuffer( ThreadPool* pool, const std::function<void( std::vector<Intent>& buffer, size_t index )>& fn );
+};
@@ -0,0 +1,98 @@
+#include "mailbox.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+
+void Mailbox::init( int width, int height, int tileSize, size_t workers )
+{
+  m_width = width;
+  m_tileSize = std::max(1, tileSize);
+  m_tilesX = (width + m_tileSize - 1) / m_tileSize;
+
+  const size_t tiles = static_cast<size_t>(m_tilesX) * ((height + m_tileSize - 1) / m_tileSize);
+  m_tileBegin.assign(tiles + 1, 0);
+  m_tileApplied.assign(tiles, 0);
+
+  m_outbound.resize(workers);
+  for ( std::vector<Message>& outbound : m_outbound )
+  {
+    outbound.clear();
+  }
+  m_sorted.clear();
+  m_delivered.clear();
+  m_lastMessages = 0;
+}
+
+void Mailbox::deliver( ThreadPool* pool, const ApplyFn& apply )
+{
+  // Counting sort into tile buckets
+  std::fill(m_tileBegin.begin(), m_tileBegin.end(), 0);
+  size_t messages = 0;
+  for ( const std::vector<Message>& outbound : m_outbound )
+  {
+    for ( const Message& message : outbound )
+    {
+      m_tileBegin[getTile(message.target) + 1]++;
+    }
+    messages += outbound.size();
+  }
+
+  m_lastMessages = messages;
+  m_delivered.clear();
+  if ( messages == 0 ) return;
+
+  for ( size_t tile = 1; tile < m_tileBegin.size(); ++tile )
+  {
+    m_tileBegin[tile] += m_tileBegin[tile - 1];
+  }
+
+  m_sorted.resize(messages);
+  std::vector<uint32_t> cursor(m_tileBegin.begin(), m_tileBegin.end() - 1);
+  for ( std::vector<Message>& outbound : m_outbound )
+  {
+    for ( const Message& message : outbound )
+    {
+      m_sorted[cursor[getTile(message.target)]++] = message;
+    }
+    outbound.clear();
+  }
+
+  // Each tile owns its targets, so tiles are applied in parallel without locks
+  const size_t tiles = m_tileApplied.size();
+  auto deliverTiles = [&]( size_t begin, size_t end, size_t )
+  {
+    for ( size_t tile = begin; tile < end; ++tile )
+    {
+      auto first = m_sorted.begin() + m_tileBegin[tile];
+      auto last = m_sorted.begin() + m_tileBegin[tile + 1];
+      std::sort(first, last, []( const Message& a, const Message& b )
+      {
+        return a.target != b.target ? a.target < b.target : a.key < b.key;
+      });
+
+      uint32_t applied = 0;
+      for ( auto message = first; message != last; ++message )
+      {
+        const bool winner = message == first || (message - 1)->target != message->target;
+        if ( winner && apply(*message) )
+        {
+          *(first + applied++) = *message;
+        }
+      }
+      m_tileApplied[tile] = applied;
+    }
+  };
+
+  if ( pool )
+  {
+    pool->parallelFor(tiles, deliverTiles);
+  }
+  else
+  {
+    deliverTiles(0, tiles, 0);
+  }
+
+  for ( size_t tile = 0; tile < tiles; ++tile )
+  {
+    m_delivered.insert(m_delivered.end(), m_sorted.begin() + m_tileBegin[tile], m_sorted.begin() + m_tileBegin[tile] + m_tileApplied[tile]);
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+enum class MessageKind : uint8_t
+{
+  Seed  // plant a sprout in the target if it is still empty
+};
+
+struct Message
+{
+  uint64_t key;          // seed-driven priority, lowest wins per target
+  uint32_t target;       // local cell index
+  uint32_t genomeIndex;
+  uint16_t energy;
+  MessageKind kind;
+  uint8_t direction;
+};
+
+// Deferred delivery for writes far from the cell that makes them. Workers
+// post to their own outbound list during the parallel update, with no
+// locks or shared state. deliver() runs at the end of the epoch: messages
+// are bucketed by the tile of their target, each tile is sorted by
+// (target, key) and handled by one worker, and only the lowest key per
+// target is applied. The outcome is therefore independent of which worker
+// posted what.
+class Mailbox
+{
+  public:
+  // Returns whether the message took effect
+  using ApplyFn = std::function<bool( const Message& message )>;
+
+  Mailbox() = default;
+
+  void init( int width, int height, int tileSize, size_t workers );
+
+  inline void post( size_t worker, const Message& message ) { m_outbound[worker].push_back(message); }
+
+  void deliver( ThreadPool* pool, const ApplyFn& apply );
+
+  // Messages that took effect in the last deliver(), in tile order
+  inline std::span<const Message> getDelivered() const { return m_delivered; }
+  inline size_t getLastMessageCount() const { return m_lastMessages; }
+
+  private:
+  std::vector<std::vector<Message>> m_outbound;
+  std::vector<Message> m_sorted;
+  std::vector<Message> m_delivered;
+  std::vector<uint32_t> m_tileBegin;   // tile -> first message in m_sorted; tile + 1 -> end
+  std::vector<uint32_t> m_tileApplied; // tile -> applied messages, compacted at the tile's front
+
+  int m_width{ 0 };
+  int m_tileSize{ 1 };
+  int m_tilesX{ 0 };
+  size_t m_lastMessages{ 0 };
+
+  inline size_t getTile( uint32_t cell ) const { return (cell / m_width) / m_tileSize * m_tilesX + (cell % m_width) / m_tileSize; }
+};
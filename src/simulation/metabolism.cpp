@@ -0,0 +1,105 @@
+#include "metabolism.h"
+#include "utils/cpu_features.h"
+#include <bit>
+#include <cstddef>
+
+static_assert(sizeof(Cell) == 16, "metabolism kernel assumes 16-byte cells");
+static_assert(offsetof(Cell, type) == 0 && offsetof(Cell, energy) == 2 && offsetof(Cell, age) == 12, "metabolism kernel assumes the Cell field layout");
+
+namespace
+{
+  void sweepScalar( Cell* cells, size_t begin, size_t end, std::vector<uint32_t>& deaths )
+  {
+    for ( size_t i = begin; i < end; ++i )
+    {
+      Cell& cell = cells[i];
+      if ( !cell.isAlive() ) continue;
+
+      const uint16_t upkeep = Metabolism::UPKEEP[static_cast<int>(cell.type)];
+      cell.energy = cell.energy > upkeep ? cell.energy - upkeep : 0;
+      cell.age++;
+
+      if ( cell.energy == 0 )
+      {
+        deaths.push_back(static_cast<uint32_t>(i));
+      }
+    }
+  }
+
+#if defined(GENXIDE_HAS_AVX2_PATH)
+
+  // Works on the cells in place, two per register. The type byte of each
+  // cell is broadcast across its 128-bit lane and used as a shuffle index
+  // into small tables, which yields the upkeep at the energy field and the
+  // alive flag at the age field without unpacking the struct.
+  __attribute__((target("avx2")))
+  void sweepAVX2( Cell* cells, size_t begin, size_t end, std::vector<uint32_t>& deaths )
+  {
+    alignas(16) uint8_t upkeepBytes[16] = {};
+    alignas(16) uint8_t aliveBytes[16] = {};
+    for ( size_t type = 1; type < Metabolism::UPKEEP.size(); ++type )
+    {
+      upkeepBytes[type] = Metabolism::UPKEEP[type];
+      aliveBytes[type] = 1;
+    }
+
+    const __m256i upkeepTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(upkeepBytes)));
+    const __m256i aliveTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(aliveBytes)));
+    const __m256i zero = _mm256_setzero_si256();
+    // Low byte of energy (offset 2) and of age (offset 12) in each cell
+    const __m256i energyByte = _mm256_setr_epi8(0, 0, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i ageByte = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 0, 0, 0);
+    // Bit 2 of the byte mask is the first cell's energy, bit 18 the second's
+    constexpr uint32_t DEATH_BITS = (1u << 2) | (1u << 18);
+
+    size_t i = begin;
+    for ( ; i + 8 <= end; i += 8 )
+    {
+      uint32_t dead = 0;
+
+      for ( int pair = 0; pair < 4; ++pair )
+      {
+        __m256i* address = reinterpret_cast<__m256i*>(cells + i + pair * 2);
+        __m256i v = _mm256_loadu_si256(address);
+
+        const __m256i types = _mm256_shuffle_epi8(v, zero);
+        const __m256i alive = _mm256_shuffle_epi8(aliveTable, types);
+
+        v = _mm256_subs_epu16(v, _mm256_and_si256(_mm256_shuffle_epi8(upkeepTable, types), energyByte));
+        v = _mm256_add_epi32(v, _mm256_and_si256(alive, ageByte));
+        _mm256_storeu_si256(address, v);
+
+        const __m256i starved = _mm256_andnot_si256(_mm256_cmpeq_epi8(alive, zero), _mm256_cmpeq_epi16(v, zero));
+        const uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(starved)) & DEATH_BITS;
+        dead |= ((bits >> 2) & 1u) << (pair * 2);
+        dead |= ((bits >> 18) & 1u) << (pair * 2 + 1);
+      }
+
+      // Compress the 8-cell mask into indices
+      while ( dead )
+      {
+        deaths.push_back(static_cast<uint32_t>(i + std::countr_zero(dead)));
+        dead &= dead - 1;
+      }
+    }
+
+    sweepScalar(cells, i, end, deaths);
+  }
+
+#endif
+}
+
+namespace Metabolism
+{
+  void sweep( Cell* cells, size_t begin, size_t end, std::vector<uint32_t>& deaths )
+  {
+#if defined(GENXIDE_HAS_AVX2_PATH)
+    if ( CpuFeatures::hasAVX2() )
+    {
+      sweepAVX2(cells, begin, end, deaths);
+      return;
+    }
+#endif
+    sweepScalar(cells, begin, end, deaths);
+  }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "cell.h"
+#include "core/config.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-epoch upkeep for every live cell, run as one sweep over the cell array
+// instead of inside the per-type rules. Upkeep is a saturating 16-bit
+// subtract, age is incremented in the same pass, and cells that reach zero
+// energy are appended to a death list in index order for a follow-up pass.
+namespace Metabolism
+{
+  // Energy lost per epoch, indexed by CellType
+  constexpr std::array<uint8_t, 5> UPKEEP = { 0, Config::WOOD_UPKEEP, Config::LEAF_UPKEEP, Config::ROOT_UPKEEP, Config::SPROUT_UPKEEP };
+
+  // Cells [begin, end); dead cell indices are appended to deaths
+  void sweep( Cell* cells, size_t begin, size_t end, std::vector<uint32_t>& deaths );
+}
@@ -0,0 +1,98 @@
+#include "mutation_engine.h"
+#include "utils/random.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+void MutationEngine::init( double pointRate, double insertionRate, double duplicationRate, uint16_t maxDuplication, uint16_t geneValues )
+{
+  m_pointRate = pointRate;
+  m_insertionRate = insertionRate;
+  m_totalRate = std::min(1.0, pointRate + insertionRate + duplicationRate);
+  m_logKeep = m_totalRate > 0.0 && m_totalRate < 1.0 ? std::log1p(-m_totalRate) : 0.0;
+  m_maxDuplication = std::clamp<uint16_t>(maxDuplication, 1, MAX_DUPLICATION);
+  m_geneValues = std::max<uint16_t>(geneValues, 1);
+}
+
+size_t MutationEngine::mutate( GenomeStore& genomes, std::span<uint32_t> batch, std::span<const uint64_t> seeds )
+{
+  m_lastMutations = 0;
+  m_lastGenomes = 0;
+  m_lastDraws = 0;
+  if ( m_totalRate <= 0.0 || batch.empty() ) return 0;
+
+  const size_t stride = genomes.getStride();
+  Random::SplitMix64 rng;
+
+  // Genes skipped before the next mutation: floor(log(u) / log(1 - p)) for u in (0, 1]
+  auto nextGap = [&]() -> size_t
+  {
+    m_lastDraws++;
+    if ( m_logKeep == 0.0 ) return 0;
+    const double u = static_cast<double>((rng() >> 11) + 1) * 0x1.0p-53;
+    const double gap = std::floor(std::log(u) / m_logKeep);
+    return gap < static_cast<double>(stride) ? static_cast<size_t>(gap) : stride;
+  };
+
+  for ( size_t entry = 0; entry < batch.size(); ++entry )
+  {
+    rng.seed(seeds[entry]);
+
+    bool copied = false;
+    for ( size_t gene = nextGap(); gene < stride; gene += 1 + nextGap() )
+    {
+      if ( !copied )
+      {
+        // Allocating can move the store, so both spans are taken afterwards
+        const uint32_t copy = genomes.allocate();
+        std::span<const uint16_t> parent = genomes.get(batch[entry]);
+        std::copy(parent.begin(), parent.end(), genomes.get(copy).begin());
+        batch[entry] = copy;
+        copied = true;
+        m_lastGenomes++;
+      }
+
+      apply(genomes.get(batch[entry]), gene, rng());
+      m_lastDraws++;
+      m_lastMutations++;
+    }
+
+    if ( copied )
+    {
+      genomes.rehash(batch[entry]);
+    }
+  }
+
+  return m_lastMutations;
+}
+
+void MutationEngine::apply( std::span<uint16_t> genes, size_t gene, uint64_t draw ) const
+{
+  // One draw per mutation: the kind from the high half, a gene value and a run length from the low half
+  const double pick = static_cast<double>(draw >> 32) * 0x1.0p-32 * m_totalRate;
+  const uint16_t value = static_cast<uint16_t>((draw & 0xFFFF) % m_geneValues);
+  const size_t count = genes.size();
+
+  if ( pick < m_pointRate )
+  {
+    genes[gene] = value;
+  }
+  else if ( pick < m_pointRate + m_insertionRate )
+  {
+    std::copy_backward(genes.begin() + gene, genes.end() - 1, genes.end());
+    genes[gene] = value;
+  }
+  else
+  {
+    const size_t length = std::min<size_t>(1 + ((draw >> 16) & 0xFFFF) % m_maxDuplication, count - gene);
+    const size_t at = gene + length;
+    if ( at >= count ) return;
+
+    std::array<uint16_t, MAX_DUPLICATION> run;
+    std::copy(genes.begin() + gene, genes.begin() + at, run.begin());
+
+    const size_t kept = std::min(length, count - at);
+    std::copy_backward(genes.begin() + at, genes.end() - kept, genes.end());
+    std::copy(run.begin(), run.begin() + kept, genes.begin() + at);
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "genome_store.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Per-gene mutation for batches of offspring. Each genome of a batch is
+// read with its own random stream, and the gap to the next mutated gene is
+// drawn from a geometric distribution, so the number of random draws
+// follows the number of offspring and mutations, not the genome length.
+// Streams are seeded per offspring, so a genome mutates the same way in
+// whatever batch it ends up, which keeps slab windows in step with a whole
+// world. A genome that receives a
+// mutation is first copied to a slot of its own (offspring share their
+// parent's until then) and edited in place there: a point mutation replaces
+// a gene, an insertion adds a random gene and a duplication repeats a short
+// run, the last two shifting the rest right and dropping what falls off the
+// end of the fixed-length genome.
+class MutationEngine
+{
+  public:
+  static constexpr uint16_t MAX_DUPLICATION = 64;
+
+  MutationEngine() = default;
+
+  // Rates are probabilities per gene; genes take values [0, geneValues)
+  void init( double pointRate, double insertionRate, double duplicationRate, uint16_t maxDuplication, uint16_t geneValues );
+
+  // Replaces the entries of batch that mutated with their new genome slots
+  // and returns the number of mutations. seeds holds one stream seed per
+  // entry; the same seed and genome always give the same result.
+  size_t mutate( GenomeStore& genomes, std::span<uint32_t> batch, std::span<const uint64_t> seeds );
+
+  inline size_t getLastMutationCount() const { return m_lastMutations; }
+  inline size_t getLastGenomeCount() const { return m_lastGenomes; }
+  inline size_t getLastDrawCount() const { return m_lastDraws; }
+
+  private:
+  double m_pointRate{ 0.0 };
+  double m_insertionRate{ 0.0 };
+  double m_totalRate{ 0.0 };
+  double m_logKeep{ 0.0 };        // log(1 - totalRate)
+  uint16_t m_maxDuplication{ 1 };
+  uint16_t m_geneValues{ 1 };
+
+  size_t m_lastMutations{ 0 };
+  size_t m_lastGenomes{ 0 };
+  size_t m_lastDraws{ 0 };
+
+  void apply( std::span<uint16_t> genes, size_t gene, uint64_t draw ) const;
+};
@@ -0,0 +1,217 @@
+#include "neighbour_planes.h"
+#include "utils/cpu_features.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+namespace
+{
+  constexpr int DX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+  constexpr int DY[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+
+  // Spreads the 8 bits of a byte into the low bit of 8 bytes
+  constexpr std::array<uint64_t, 256> EXPAND = []()
+  {
+    std::array<uint64_t, 256> table{};
+    for ( int value = 0; value < 256; ++value )
+    {
+      for ( int bit = 0; bit < 8; ++bit )
+      {
+        if ( value & (1 << bit) ) table[value] |= uint64_t(1) << (bit * 8);
+      }
+    }
+    return table;
+  }();
+}
+
+void NeighbourPlanes::init( int width, int height )
+{
+  m_width = width;
+  m_height = height;
+  m_words = (static_cast<size_t>(width) + 63) / 64;
+  m_rowStride = m_words + 2;
+  m_signatureStride = m_words * 64;
+
+  m_bits.resize(PLANE_COUNT * (static_cast<size_t>(height) + 2) * m_rowStride);
+  m_signatures.resize(static_cast<size_t>(height) * m_signatureStride);
+
+  // Guard rows and words are never written by buildRows, so clear them up front;
+  // interior words are first written by the stripe that owns them
+  for ( int plane = 0; plane < PLANE_COUNT; ++plane )
+  {
+    std::fill_n(getRow(plane, -1) - 1, m_rowStride, 0);
+    std::fill_n(getRow(plane, height) - 1, m_rowStride, 0);
+    for ( int y = 0; y < height; ++y )
+    {
+      getRow(plane, y)[-1] = 0;
+      getRow(plane, y)[m_words] = 0;
+    }
+  }
+}
+
+void NeighbourPlanes::buildRows( const Cell* cells, int rowBegin, int rowEnd )
+{
+  for ( int y = rowBegin; y < rowEnd; ++y )
+  {
+    const Cell* row = cells + static_cast<size_t>(y) * m_width;
+
+    for ( size_t word = 0; word < m_words; ++word )
+    {
+      const int xBegin = static_cast<int>(word * 64);
+      const int xEnd = std::min(m_width, xBegin + 64);
+
+      uint64_t types[TYPE_PLANES] = {};
+      for ( int x = xBegin; x < xEnd; ++x )
+      {
+        types[static_cast<int>(row[x].type)] |= uint64_t(1) << (x - xBegin);
+      }
+
+      const uint64_t valid = (xEnd - xBegin == 64) ? ~uint64_t(0) : (uint64_t(1) << (xEnd - xBegin)) - 1;
+
+      // Slot 0 collected the empty cells
+      getRow(FREE, y)[word] = types[0];
+      getRow(OCCUPIED, y)[word] = ~types[0] & valid;
+      for ( int plane = 1; plane < TYPE_PLANES; ++plane )
+      {
+        getRow(plane, y)[word] = types[plane];
+      }
+    }
+  }
+}
+
+void NeighbourPlanes::computeDirectionMasks( int plane, int y, size_t word, uint64_t masks[8] ) const
+{
+  for ( int d = 0; d < 8; ++d )
+  {
+    const uint64_t* source = getRow(plane, y + DY[d]);
+
+    if ( DX[d] == 0 )
+    {
+      masks[d] = source[word];
+    }
+    else if ( DX[d] > 0 )
+    {
+      masks[d] = (source[word] >> 1) | (source[word + 1] << 63);
+    }
+    else
+    {
+      masks[d] = (source[word] << 1) | (source[static_cast<ptrdiff_t>(word) - 1] >> 63);
+    }
+  }
+}
+
+void NeighbourPlanes::buildSignatures( int rowBegin, int rowEnd )
+{
+  if ( CpuFeatures::hasAVX2() )
+  {
+    buildSignaturesAVX2(rowBegin, rowEnd);
+  }
+  else
+  {
+    buildSignaturesScalar(rowBegin, rowEnd);
+  }
+}
+
+void NeighbourPlanes::buildSignaturesScalar( int rowBegin, int rowEnd )
+{
+  for ( int y = rowBegin; y < rowEnd; ++y )
+  {
+    uint8_t* out = m_signatures.data() + static_cast<size_t>(y) * m_signatureStride;
+
+    for ( size_t word = 0; word < m_words; ++word )
+    {
+      uint64_t masks[8];
+      computeDirectionMasks(FREE, y, word, masks);
+
+      // Transpose 8 direction words into 64 signature bytes, 8 at a time
+      for ( int group = 0; group < 8; ++group )
+      {
+        uint64_t bytes = 0;
+        for ( int d = 0; d < 8; ++d )
+        {
+          bytes |= EXPAND[(masks[d] >> (group * 8)) & 0xFF] << d;
+        }
+        std::memcpy(out + word * 64 + group * 8, &bytes, sizeof(bytes));
+      }
+    }
+  }
+}
+
+#if defined(GENXIDE_HAS_AVX2_PATH)
+
+__attribute__((target("avx2")))
+void NeighbourPlanes::buildSignaturesAVX2( int rowBegin, int rowEnd )
+{
+  // Byte i of a 32-bit chunk goes to output bytes [8i, 8i + 8)
+  const __m256i spread = _mm256_setr_epi8(
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+  const __m256i select = _mm256_set1_epi64x(0x8040201008040201ll);
+
+  for ( int y = rowBegin; y < rowEnd; ++y )
+  {
+    uint8_t* out = m_signatures.data() + static_cast<size_t>(y) * m_signatureStride;
+
+    for ( size_t word = 0; word < m_words; ++word )
+    {
+      uint64_t masks[8];
+      computeDirectionMasks(FREE, y, word, masks);
+
+      for ( int half = 0; half < 2; ++half )
+      {
+        __m256i signature = _mm256_setzero_si256();
+
+        for ( int d = 0; d < 8; ++d )
+        {
+          const uint32_t bits = static_cast<uint32_t>(masks[d] >> (half * 32));
+          __m256i lanes = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(bits)), spread);
+          lanes = _mm256_cmpeq_epi8(_mm256_and_si256(lanes, select), select);
+          signature = _mm256_or_si256(signature, _mm256_and_si256(lanes, _mm256_set1_epi8(static_cast<char>(1 << d))));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + word * 64 + half * 32), signature);
+      }
+    }
+  }
+}
+
+#else
+
+void NeighbourPlanes::buildSignaturesAVX2( int rowBegin, int rowEnd )
+{
+  buildSignaturesScalar(rowBegin, rowEnd);
+}
+
+#endif
+
+uint64_t NeighbourPlanes::count( int plane, int rowBegin, int rowEnd ) const
+{
+  uint64_t total = 0;
+  for ( int y = rowBegin; y < rowEnd; ++y )
+  {
+    const uint64_t* row = getRow(plane, y);
+    for ( size_t word = 0; word < m_words; ++word )
+    {
+      total += std::popcount(row[word]);
+    }
+  }
+  return total;
+}
+
+uint8_t NeighbourPlanes::getNeighbours( int plane, int x, int y ) const
+{
+  uint8_t result = 0;
+  for ( int d = 0; d < 8; ++d )
+  {
+    const int nx = x + DX[d];
+    if ( nx < 0 || nx >= m_width ) continue;
+
+    // Guard rows make y -1 and y == height read as empty
+    if ( (getRow(plane, y + DY[d])[nx >> 6] >> (nx & 63)) & 1 )
+    {
+      result |= 1 << d;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "cell.h"
+#include "utils/mapped_memory.h"
+#include <cstddef>
+#include <cstdint>
+
+// One bit per cell occupancy and per-type bitplanes, rebuilt once per epoch,
+// plus a per-cell signature byte whose bit d is set when the neighbour in
+// direction d is inside the grid and empty. Directions follow Grid::DX8/DY8
+// (bit 0 = +y, then clockwise), so the 4-neighbourhood is bits 0, 2, 4, 6.
+// Kernels answer neighbourhood questions with one byte load instead of eight
+// scattered cell loads, and population counts become popcount sweeps.
+class NeighbourPlanes
+{
+  public:
+  // Plane 0 is occupancy, planes 1..4 follow CellType
+  static constexpr int OCCUPIED = 0;
+  static constexpr int TYPE_PLANES = 5;
+  static constexpr uint8_t HV_MASK = 0x55;
+
+  NeighbourPlanes() = default;
+
+  void init( int width, int height );
+
+  // Rows must be built before signatures of their neighbouring rows are
+  void buildRows( const Cell* cells, int rowBegin, int rowEnd );
+  void buildSignatures( int rowBegin, int rowEnd );
+
+  uint64_t count( int plane, int rowBegin, int rowEnd ) const;
+
+  inline bool test( int plane, int x, int y ) const { return (getRow(plane, y)[x >> 6] >> (x & 63)) & 1; }
+  inline uint8_t getEmptyNeighbours( int x, int y ) const { return m_signatures[static_cast<size_t>(y) * m_signatureStride + x]; }
+
+  // Same bit layout as the signature, for any plane: bit d set when the neighbour in direction d is in that plane
+  uint8_t getNeighbours( int plane, int x, int y ) const;
+
+  private:
+  // [plane][row + 1][word + 1], with zero guard rows and words around each plane
+  MappedVector<uint64_t> m_bits;
+  MappedVector<uint8_t> m_signatures;
+
+  int m_width{ 0 };
+  int m_height{ 0 };
+  size_t m_words{ 0 };
+  size_t m_rowStride{ 0 };
+  size_t m_signatureStride{ 0 };
+
+  // Internal plane of in-bounds empty cells, the source of the signatures
+  static constexpr int FREE = TYPE_PLANES;
+  static constexpr int PLANE_COUNT = TYPE_PLANES + 1;
+
+  inline const uint64_t* getRow( int plane, int y ) const { return m_bits.data() + (static_cast<size_t>(plane) * (m_height + 2) + y + 1) * m_rowStride + 1; }
+  inline uint64_t* getRow( int plane, int y ) { return m_bits.data() + (static_cast<size_t>(plane) * (m_height + 2) + y + 1) * m_rowStride + 1; }
+
+  void computeDirectionMasks( int plane, int y, size_t word, uint64_t masks[8] ) const;
+  void buildSignaturesScalar( int rowBegin, int rowEnd );
+  void buildSignaturesAVX2( int rowBegin, int rowEnd );
+};
@@ -0,0 +1,399 @@
+#include "organism_registry.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+  // Same order as Grid::DX8/DY8; the 4-neighbourhood is every other entry
+  constexpr int DX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+  constexpr int DY[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+}
+
+void OrganismRegistry::init( int width, int height, bool useHVDirections )
+{
+  m_width = width;
+  m_height = height;
+  m_directions = useHVDirections ? 4 : 8;
+
+  const size_t cellCount = static_cast<size_t>(width) * height;
+  m_labels.resize(cellCount);
+  m_visited.resize(cellCount);
+  std::fill(m_labels.begin(), m_labels.end(), NONE);
+  std::fill(m_visited.begin(), m_visited.end(), 0);
+
+  m_organisms.clear();
+  m_removed.clear();
+  m_liveCount = 0;
+  m_stamp = 0;
+  m_generation++;
+}
+
+void OrganismRegistry::rebuild( const Cell* cells, uint64_t epoch )
+{
+  m_organisms.clear();
+  m_removed.clear();
+  m_liveCount = 0;
+
+  // Labels of cells not visited yet must not be read as current ones
+  std::fill(m_labels.begin(), m_labels.end(), NONE);
+
+  uint32_t neighbours[8];
+  for ( uint32_t cell = 0; cell < m_labels.size(); ++cell )
+  {
+    if ( !cells[cell].isAlive() ) continue;
+
+    // Neighbours already labelled belong to the same organism
+    const int count = getNeighbours(cell, neighbours);
+    for ( int i = 0; i < count; ++i )
+    {
+      const uint32_t label = m_labels[neighbours[i]];
+      if ( label == NONE ) continue;
+
+      if ( m_labels[cell] == NONE )
+      {
+        m_labels[cell] = find(label);
+        m_organisms[m_labels[cell]].size++;
+      }
+      else
+      {
+        unite(m_labels[cell], label);
+      }
+    }
+
+    if ( m_labels[cell] == NONE )
+    {
+      m_labels[cell] = create(cells[cell].genomeIndex, epoch);
+      m_organisms[m_labels[cell]].size = 1;
+    }
+  }
+
+  compact();
+}
+
+void OrganismRegistry::addCell( uint32_t cell, uint32_t sourceCell )
+{
+  const uint32_t root = find(m_labels[sourceCell]);
+  m_labels[cell] = root;
+  m_organisms[root].size++;
+
+  // Growing into a gap can touch other organisms, which merge with this one
+  uint32_t neighbours[8];
+  const int count = getNeighbours(cell, neighbours);
+  for ( int i = 0; i < count; ++i )
+  {
+    const uint32_t label = m_labels[neighbours[i]];
+    if ( label != NONE )
+    {
+      unite(root, label);
+    }
+  }
+}
+
+void OrganismRegistry::addFounder( uint32_t cell, uint32_t genomeIndex, uint64_t epoch )
+{
+  const uint32_t root = create(genomeIndex, epoch);
+  m_labels[cell] = root;
+  m_organisms[root].size = 1;
+
+  // Landing next to a plant makes the founder part of it
+  uint32_t neighbours[8];
+  const int count = getNeighbours(cell, neighbours);
+  for ( int i = 0; i < count; ++i )
+  {
+    const uint32_t label = m_labels[neighbours[i]];
+    if ( label != NONE )
+    {
+      unite(root, label);
+    }
+  }
+}
+
+void OrganismRegistry::removeCell( uint32_t cell )
+{
+  const uint32_t root = find(m_labels[cell]);
+  if ( --m_organisms[root].size == 0 )
+  {
+    m_liveCount--;
+  }
+
+  m_labels[cell] = NONE;
+  m_removed.push_back(cell);
+}
+
+void OrganismRegistry::endEpoch( const Cell* cells )
+{
+  if ( m_removed.empty() ) return;
+
+  // Live neighbours of the dead cells, grouped by organism. Only organisms
+  // that lost a cell touching two or more of their own cells can have split.
+  std::vector<std::pair<uint32_t, uint32_t>> seeds;
+  uint32_t neighbours[8];
+  for ( uint32_t cell : m_removed )
+  {
+    const int count = getNeighbours(cell, neighbours);
+    for ( int i = 0; i < count; ++i )
+    {
+      const uint32_t label = m_labels[neighbours[i]];
+      if ( label != NONE )
+      {
+        seeds.emplace_back(find(label), neighbours[i]);
+      }
+    }
+  }
+  m_removed.clear();
+
+  std::sort(seeds.begin(), seeds.end());
+  seeds.erase(std::unique(seeds.begin(), seeds.end()), seeds.end());
+
+  std::vector<uint32_t> group;
+  for ( size_t begin = 0; begin < seeds.size(); )
+  {
+    const uint32_t root = seeds[begin].first;
+    size_t end = begin;
+    group.clear();
+    while ( end < seeds.size() && seeds[end].first == root )
+    {
+      group.push_back(seeds[end++].second);
+    }
+
+    if ( group.size() > 1 )
+    {
+      splitOrganism(root, group, cells);
+    }
+    begin = end;
+  }
+
+  // Merged and emptied ids are never reused, so renumber once most are stale
+  if ( m_organisms.size() > 2 * m_liveCount + 1024 )
+  {
+    compact();
+  }
+}
+
+void OrganismRegistry::splitOrganism( uint32_t root, std::span<const uint32_t> seeds, const Cell* cells )
+{
+  if ( ++m_stamp == 0 )
+  {
+    std::fill(m_visited.begin(), m_visited.end(), 0);
+    m_stamp = 1;
+  }
+
+  // Flood from one seed at a time until it has reached every remaining seed;
+  // whatever is left is the piece that keeps the id, and is never explored
+  size_t remaining = seeds.size();
+  std::vector<uint32_t> piece;
+  uint32_t neighbours[8];
+
+  for ( uint32_t seed : seeds )
+  {
+    if ( m_visited[seed] == m_stamp ) continue;
+
+    piece.clear();
+    piece.push_back(seed);
+    m_visited[seed] = m_stamp;
+    remaining--;
+
+    for ( size_t head = 0; head < piece.size() && remaining > 0; ++head )
+    {
+      const int count = getNeighbours(piece[head], neighbours);
+      for ( int i = 0; i < count; ++i )
+      {
+        const uint32_t next = neighbours[i];
+        if ( m_labels[next] == NONE || m_visited[next] == m_stamp || find(m_labels[next]) != root ) continue;
+
+        m_visited[next] = m_stamp;
+        piece.push_back(next);
+        if ( std::binary_search(seeds.begin(), seeds.end(), next) )
+        {
+          remaining--;
+        }
+      }
+    }
+
+    if ( remaining == 0 ) break;
+
+    // The flood ran out before reaching the other seeds, so this piece is detached
+    const uint32_t organism = create(cells[seed].genomeIndex, m_organisms[root].birthEpoch);
+    m_organisms[organism].size = static_cast<uint32_t>(piece.size());
+    m_organisms[root].size -= static_cast<uint32_t>(piece.size());
+    for ( uint32_t cell : piece )
+    {
+      m_labels[cell] = organism;
+    }
+  }
+}
+
+void OrganismRegistry::refreshEnergy( const Cell* cells, ThreadPool* pool )
+{
+  beginEnergy(pool ? pool->getThreadCount() : 1);
+
+  if ( pool )
+  {
+    pool->parallelFor(m_labels.size(), [&]( size_t begin, size_t end, size_t worker )
+    {
+      sumEnergy(cells, begin, end, worker);
+    });
+  }
+  else
+  {
+    sumEnergy(cells, 0, m_labels.size(), 0);
+  }
+
+  endEnergy();
+}
+
+void OrganismRegistry::beginEnergy( size_t workers )
+{
+  m_energyScratch.resize(workers);
+  for ( std::vector<uint64_t>& scratch : m_energyScratch )
+  {
+    scratch.assign(m_organisms.size(), 0);
+  }
+}
+
+void OrganismRegistry::sumEnergy( const Cell* cells, size_t begin, size_t end, size_t worker )
+{
+  std::vector<uint64_t>& scratch = m_energyScratch[worker];
+  for ( size_t cell = begin; cell < end; ++cell )
+  {
+    if ( m_labels[cell] != NONE )
+    {
+      scratch[findConst(m_labels[cell])] += cells[cell].energy;
+    }
+  }
+}
+
+void OrganismRegistry::endEnergy()
+{
+  for ( uint32_t organism = 0; organism < m_organisms.size(); ++organism )
+  {
+    uint64_t energy = 0;
+    for ( const std::vector<uint64_t>& scratch : m_energyScratch )
+    {
+      energy += scratch[organism];
+    }
+    m_organisms[organism].energy = energy;
+  }
+}
+
+void OrganismRegistry::markGenomes( std::span<uint8_t> used ) const
+{
+  for ( uint32_t organism = 0; organism < m_organisms.size(); ++organism )
+  {
+    const Organism& entry = m_organisms[organism];
+    if ( entry.parent == organism && entry.size > 0 && entry.genomeIndex < used.size() )
+    {
+      used[entry.genomeIndex] = 1;
+    }
+  }
+}
+
+uint32_t OrganismRegistry::getOrganism( uint32_t cell ) const
+{
+  return m_labels[cell] == NONE ? NONE : findConst(m_labels[cell]);
+}
+
+bool OrganismRegistry::isLive( uint32_t organism ) const
+{
+  return organism < m_organisms.size() && m_organisms[organism].parent == organism && m_organisms[organism].size > 0;
+}
+
+uint32_t OrganismRegistry::create( uint32_t genomeIndex, uint64_t birthEpoch )
+{
+  const uint32_t organism = static_cast<uint32_t>(m_organisms.size());
+  m_organisms.push_back({ organism, 0, 0, birthEpoch, genomeIndex });
+  m_liveCount++;
+  return organism;
+}
+
+uint32_t OrganismRegistry::find( uint32_t organism )
+{
+  // Path halving
+  while ( m_organisms[organism].parent != organism )
+  {
+    m_organisms[organism].parent = m_organisms[m_organisms[organism].parent].parent;
+    organism = m_organisms[organism].parent;
+  }
+  return organism;
+}
+
+uint32_t OrganismRegistry::findConst( uint32_t organism ) const
+{
+  while ( m_organisms[organism].parent != organism )
+  {
+    organism = m_organisms[organism].parent;
+  }
+  return organism;
+}
+
+uint32_t OrganismRegistry::unite( uint32_t a, uint32_t b )
+{
+  a = find(a);
+  b = find(b);
+  if ( a == b ) return a;
+
+  // Union by size; the merged organism keeps the older founder's age and genome
+  if ( m_organisms[a].size < m_organisms[b].size ) std::swap(a, b);
+
+  Organism& into = m_organisms[a];
+  const Organism& from = m_organisms[b];
+  into.size += from.size;
+  into.energy += from.energy;
+  if ( from.birthEpoch < into.birthEpoch )
+  {
+    into.birthEpoch = from.birthEpoch;
+    into.genomeIndex = from.genomeIndex;
+  }
+
+  m_organisms[b].parent = a;
+  m_liveCount--;
+  return a;
+}
+
+int OrganismRegistry::getNeighbours( uint32_t cell, uint32_t out[8] ) const
+{
+  const int x = static_cast<int>(cell % m_width);
+  const int y = static_cast<int>(cell / m_width);
+  const int step = 8 / m_directions;
+
+  int count = 0;
+  for ( int d = 0; d < 8; d += step )
+  {
+    const int nx = x + DX[d];
+    const int ny = y + DY[d];
+    if ( nx < 0 || nx >= m_width || ny < 0 || ny >= m_height ) continue;
+
+    out[count++] = static_cast<uint32_t>(ny * m_width + nx);
+  }
+  return count;
+}
+
+void OrganismRegistry::compact()
+{
+  // Live roots get dense ids in id order and every label points straight at its root
+  std::vector<uint32_t> remap(m_organisms.size(), NONE);
+  std::vector<Organism> organisms;
+
+  for ( uint32_t organism = 0; organism < m_organisms.size(); ++organism )
+  {
+    const Organism& entry = m_organisms[organism];
+    if ( entry.parent != organism || entry.size == 0 ) continue;
+
+    remap[organism] = static_cast<uint32_t>(organisms.size());
+    organisms.push_back(entry);
+    organisms.back().parent = remap[organism];
+  }
+
+  for ( uint32_t& label : m_labels )
+  {
+    if ( label != NONE )
+    {
+      label = remap[findConst(label)];
+    }
+  }
+
+  m_organisms = std::move(organisms);
+  m_liveCount = m_organisms.size();
+  m_generation++;
+}
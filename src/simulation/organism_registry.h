@@ -0,0 +1,97 @@
+#pragma once
+#include "cell.h"
+#include "utils/mapped_memory.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// An organism is a connected group of live cells. Every live cell carries a
+// label that resolves to its organism through a union-find forest over
+// organism ids. Births join the source's organism and union with any other
+// organism they touch. Deaths are queued and checked for splits once per
+// epoch, exploring all but one of the pieces an organism may have fallen
+// into. Size, energy, age and genome of an organism are then O(1) lookups.
+class OrganismRegistry
+{
+  public:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  OrganismRegistry() = default;
+
+  void init( int width, int height, bool useHVDirections );
+
+  // Labels every live cell from scratch
+  void rebuild( const Cell* cells, uint64_t epoch );
+
+  // cell has just come alive next to sourceCell
+  void addCell( uint32_t cell, uint32_t sourceCell );
+  // cell has come alive away from any parent and starts a new organism
+  void addFounder( uint32_t cell, uint32_t genomeIndex, uint64_t epoch );
+  // cell has just died; its organism is checked for splits in endEpoch
+  void removeCell( uint32_t cell );
+
+  void endEpoch( const Cell* cells );
+
+  // Sums cell energy per organism; cells must match the current labels
+  void refreshEnergy( const Cell* cells, ThreadPool* pool );
+  // The same in pieces: beginEnergy(), sumEnergy() over every cell in any
+  // split with worker below workers, then endEnergy()
+  void beginEnergy( size_t workers );
+  void sumEnergy( const Cell* cells, size_t begin, size_t end, size_t worker );
+  void endEnergy();
+
+  // NONE for empty cells
+  uint32_t getOrganism( uint32_t cell ) const;
+  // Whether organism is a root with live cells
+  bool isLive( uint32_t organism ) const;
+  // Changes whenever ids are renumbered; ids from another generation are meaningless
+  inline uint64_t getGeneration() const { return m_generation; }
+  // Organism ids are below this
+  inline size_t getIdCount() const { return m_organisms.size(); }
+
+  inline size_t getOrganismCount() const { return m_liveCount; }
+  inline uint32_t getSize( uint32_t organism ) const { return m_organisms[organism].size; }
+  inline uint64_t getEnergy( uint32_t organism ) const { return m_organisms[organism].energy; }
+  inline uint64_t getAge( uint32_t organism, uint64_t epoch ) const { return epoch - m_organisms[organism].birthEpoch; }
+  inline uint32_t getGenomeIndex( uint32_t organism ) const { return m_organisms[organism].genomeIndex; }
+
+  // Flags the founder genome of every live organism in used
+  void markGenomes( std::span<uint8_t> used ) const;
+
+  private:
+  struct Organism
+  {
+    uint32_t parent;       // itself for roots
+    uint32_t size;
+    uint64_t energy;
+    uint64_t birthEpoch;   // oldest founder among merged organisms
+    uint32_t genomeIndex;  // genome of that founder
+  };
+
+  std::vector<Organism> m_organisms;
+  MappedVector<uint32_t> m_labels;     // per cell, NONE when empty
+  MappedVector<uint32_t> m_visited;    // per cell, stamp of the last split search
+  std::vector<uint32_t> m_removed;     // cells that died this epoch
+  std::vector<std::vector<uint64_t>> m_energyScratch;
+
+  int m_width{ 0 };
+  int m_height{ 0 };
+  int m_directions{ 4 };
+  size_t m_liveCount{ 0 };
+  uint32_t m_stamp{ 0 };
+  uint64_t m_generation{ 0 };
+
+  uint32_t create( uint32_t genomeIndex, uint64_t birthEpoch );
+  uint32_t find( uint32_t organism );
+  uint32_t findConst( uint32_t organism ) const;
+  uint32_t unite( uint32_t a, uint32_t b );
+
+  // Writes the in-bounds neighbours of cell to out and returns how many there are
+  int getNeighbours( uint32_t cell, uint32_t out[8] ) const;
+
+  void splitOrganism( uint32_t root, std::span<const uint32_t> seeds, const Cell* cells );
+  void compact();
+};
@@ -1,21 +1,39 @@
 #include "simulation.h"
+#include "utils/random.h"
+#include <fstream>
+#include <iostream>
 
-bool Simulation::init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections )
+bool Simulation::init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections, uint64_t seed, int processes, int threads )
 {
   m_maxEnergy = maxEnergy;
   m_maxGenome = maxGenome;
   m_width = width;
   m_height = height;
   m_useHVDirections = useHVDirections;
+  m_seed = seed;
 
-  return m_grid.init(maxEnergy, maxGenome, width, height, useHVDirections);
+  if ( processes > 1 )
+  {
+    return m_partition.init(maxEnergy, maxGenome, width, height, useHVDirections, seed, processes);
+  }
+
+  m_pool = std::make_unique<ThreadPool>(threads);
+  m_grid.setThreadPool(m_pool.get());
+
+  return m_grid.init(maxEnergy, maxGenome, width, height, useHVDirections, seed);
 }
 
 void Simulation::update()
 {
-  if ( !m_paused )
+  if ( m_paused ) return;
+
+  if ( isPartitioned() )
   {
-    m_grid.update();
+    m_partition.update();
+  }
+  else
+  {
+    m_grid.advance(m_updateBudget);
   }
 }
 
@@ -31,6 +49,76 @@ void Simulation::resume()
 
 void Simulation::reset()
 {
-  m_grid.init(m_maxEnergy, m_maxGenome, m_width, m_height, m_useHVDirections);
+  // Each reset starts a new world, derived from the previous seed so runs stay reproducible
+  m_seed = Random::mix(m_seed);
+
+  if ( isPartitioned() )
+  {
+    m_partition.reset(m_seed);
+  }
+  else
+  {
+    m_grid.init(m_maxEnergy, m_maxGenome, m_width, m_height, m_useHVDirections, m_seed);
+  }
+  m_generation++;
   m_paused = false;
 }
+
+bool Simulation::saveWorld( const char* path )
+{
+  if ( isPartitioned() )
+  {
+    std::cerr << "Saving is not supported with multiple processes" << std::endl;
+    return false;
+  }
+
+  // Files hold whole epochs
+  if ( m_grid.isEpochInProgress() )
+  {
+    m_grid.update();
+  }
+
+  std::ofstream out(path, std::ios::binary);
+  if ( !out || !m_grid.save(out) )
+  {
+    std::cerr << "Failed to save world: " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool Simulation::loadWorld( const char* path )
+{
+  if ( isPartitioned() )
+  {
+    std::cerr << "Loading is not supported with multiple processes" << std::endl;
+    return false;
+  }
+
+  // Loaded into a separate grid so a world of another size can be refused
+  // while the current one keeps running
+  std::ifstream in(path, std::ios::binary);
+  Grid loaded;
+  loaded.setThreadPool(m_pool.get());
+  if ( !in || !loaded.load(in) )
+  {
+    std::cerr << "Failed to load world: " << path << std::endl;
+    return false;
+  }
+
+  // The renderer's texture is sized for the current world
+  if ( loaded.getWidth() != m_width || loaded.getHeight() != m_height )
+  {
+    std::cerr << "World size does not match: " << path << std::endl;
+    return false;
+  }
+
+  // Later resets keep the loaded world's limits
+  m_grid = std::move(loaded);
+  m_seed = m_grid.getSeed();
+  m_maxEnergy = m_grid.getMaxEnergy();
+  m_maxGenome = m_grid.getMaxGenome();
+  m_useHVDirections = m_grid.usesHVDirections();
+  m_generation++;
+  return true;
+}
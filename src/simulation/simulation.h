@@ -1,28 +1,70 @@
 #pragma once
 #include "grid.h"
+#include "slab_partition.h"
+#include "utils/thread_pool.h"
+#include <limits>
+#include <memory>
+#include <span>
 
 class Simulation
 {
   public:
   Simulation() = default;
 
-  bool init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections );
+  // processes > 1 splits the world into slabs owned by worker processes,
+  // otherwise the grid is updated by a pool of threads (0 = one per hardware thread)
+  bool init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections, uint64_t seed, int processes, int threads );
+  // Runs at most about the update budget of simulation work per call, so an
+  // epoch of a large world can span several calls. Multi-process worlds
+  // always advance whole epochs.
   void update();
+  inline void setUpdateBudget( double seconds ) { m_updateBudget = seconds; }
+  // Off unless the pixels are drawn; see Grid::setPyramidEnabled
+  inline void setPyramidEnabled( bool enabled ) { m_grid.setPyramidEnabled(enabled); }
   void pause();
   void resume();
   void reset();
 
+  // Single-process worlds only; an epoch in progress is finished first
+  bool saveWorld( const char* path );
+  bool loadWorld( const char* path );
+
   inline bool isPaused() const { return m_paused; }
   inline Grid& getGrid() { return m_grid; }
   inline const Grid& getGrid() const { return m_grid; }
 
+  // World views that work in both single- and multi-process mode
+  inline bool isPartitioned() const { return m_partition.isActive(); }
+  inline int getProcessCount() const { return isPartitioned() ? m_partition.getProcessCount() : 1; }
+  inline size_t getThreadCount() const { return m_pool ? m_pool->getThreadCount() : 1; }
+  inline int getWidth() const { return m_width; }
+  inline int getHeight() const { return m_height; }
+  inline uint64_t getSeed() const { return m_seed; }
+  inline std::span<const uint32_t> getPixels() const { return isPartitioned() ? std::span<const uint32_t>(m_partition.getPixels()) : m_grid.getPixels(); }
+  inline uint64_t getEpoch() const { return isPartitioned() ? m_partition.getEpoch() : m_grid.getEpoch(); }
+  inline float getEpochProgress() const { return isPartitioned() ? 0.0f : m_grid.getEpochProgress(); }
+  // Changed-pixel tiles (see Grid::getTileEpochs); empty when partitioned, where every epoch changes everything
+  inline std::span<const uint64_t> getTileEpochs() const { return isPartitioned() ? std::span<const uint64_t>() : m_grid.getTileEpochs(); }
+  inline int getTilesX() const { return isPartitioned() ? 0 : m_grid.getTilesX(); }
+  // Coarser copies of the pixels for zoomed-out views (see ViewPyramid); empty when partitioned
+  inline std::span<const std::span<const uint32_t>> getPixelLevels() const { return isPartitioned() ? std::span<const std::span<const uint32_t>>() : m_grid.getPixelLevels(); }
+  // Bumped whenever the world is replaced, which invalidates every pixel
+  inline uint64_t getWorldGeneration() const { return m_generation; }
+  inline uint64_t getAliveCount() const { return isPartitioned() ? m_partition.getAliveCount() : m_grid.getAliveCount(); }
+  inline uint64_t getTypeCount( CellType type ) const { return isPartitioned() ? m_partition.getTypeCount(type) : m_grid.getTypeCount(type); }
+
   private:
+  std::unique_ptr<ThreadPool> m_pool;
   Grid m_grid;
+  SlabPartition m_partition;
   bool m_paused{ false };
+  uint64_t m_generation{ 0 };
+  double m_updateBudget{ std::numeric_limits<double>::infinity() };
 
   uint16_t m_maxEnergy;
   uint16_t m_maxGenome;
   int m_width;
   int m_height;
   bool m_useHVDirections;
+  uint64_t m_seed{ 0 };
 };
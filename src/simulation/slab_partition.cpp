@@ -0,0 +1,537 @@
+#include "slab_partition.h"
+#include "grid.h"
+#include "core/config.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Shared segment layout:
+//   SlabControl | SlabShared[processes] | exchange rows | soil edges | mail | edge plants | world pixels
+// Exchange rows hold, per slab, [parity][edge] copies of its outermost owned
+// rows. Two parities let a slab write epoch e+1 while a slower neighbour is
+// still reading epoch e, so one barrier per epoch is enough for them. Soil
+// edges hold, per slab, [edge] copies of its outermost owned soil sample
+// rows, mail the seeds it threw at rows owned by other slabs this epoch, and
+// edge plants the sorted world indices and cells of its owned cells that
+// belong to plants reaching another slab, for the transport stage.
+// Each is written before a barrier of its own and read before the next
+// barrier, so one copy is enough.
+struct SlabControl
+{
+  pthread_barrier_t barrier;
+  int32_t command;
+  int32_t processes;
+  uint64_t seed;
+};
+
+struct SlabShared
+{
+  sem_t go;
+  sem_t done;
+  uint64_t epoch;
+  uint64_t counts[NeighbourPlanes::TYPE_PLANES]; // owned rows only, alive first
+};
+
+namespace
+{
+  constexpr int HALO = Config::SLAB_HALO_ROWS;
+  constexpr int SOIL_HALO = HALO / Config::SOIL_SCALE; // sample rows in a halo
+
+  // A halo holds whole soil samples, including the row a diffusion step reads past the slab
+  static_assert(HALO % Config::SOIL_SCALE == 0 && SOIL_HALO >= 1,
+                "SLAB_HALO_ROWS must be a multiple of SOIL_SCALE covering at least one sample row");
+
+  size_t alignUp( size_t value )
+  {
+    return (value + 63) & ~static_cast<size_t>(63);
+  }
+
+  void waitSemaphore( sem_t* semaphore )
+  {
+    while ( sem_wait(semaphore) != 0 && errno == EINTR )
+    {
+    }
+  }
+}
+
+SlabPartition::~SlabPartition()
+{
+  destroy();
+}
+
+bool SlabPartition::init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections, uint64_t seed, int processes )
+{
+  // Slab edges are rounded down to whole soil samples
+  if ( processes < 2 || height / processes / Config::SOIL_SCALE * Config::SOIL_SCALE < HALO )
+  {
+    std::cerr << "Cannot split " << height << " rows into " << processes << " slabs of at least " << HALO << " rows" << std::endl;
+    return false;
+  }
+
+  m_maxEnergy = maxEnergy;
+  m_maxGenome = maxGenome;
+  m_width = width;
+  m_height = height;
+  m_useHVDirections = useHVDirections;
+  m_soilWidth = (width + Config::SOIL_SCALE - 1) / Config::SOIL_SCALE;
+  m_epoch = 0;
+
+  // Edges on whole soil samples keep every sample, and the roots draining it, in one slab
+  m_slabBegins.resize(processes + 1);
+  for ( int i = 0; i < processes; ++i )
+  {
+    m_slabBegins[i] = static_cast<int>(static_cast<int64_t>(height) * i / processes) / Config::SOIL_SCALE * Config::SOIL_SCALE;
+  }
+  m_slabBegins[processes] = height;
+
+  // A single plant may fill a whole slab
+  int slabRows = 0;
+  for ( int i = 0; i < processes; ++i )
+  {
+    slabRows = std::max(slabRows, m_slabBegins[i + 1] - m_slabBegins[i]);
+  }
+  m_edgeCapacity = static_cast<size_t>(slabRows) * width;
+
+  // Only sprouts within the dispersal radius of a slab's edges can reach
+  // another slab, and each throws at most one seed per epoch
+  m_mailCapacity = static_cast<size_t>(std::min(height, 2 * Config::DISPERSAL_RADIUS)) * width;
+
+  const size_t edgeCells = static_cast<size_t>(HALO) * width;
+  const size_t exchangePerSlab = 4 * (alignUp(edgeCells * sizeof(Cell)) + alignUp(edgeCells * maxGenome * sizeof(uint16_t)));
+  const size_t soilPerSlab = 2 * alignUp(static_cast<size_t>(SOIL_HALO) * m_soilWidth * sizeof(float));
+  const size_t mailPerSlab = alignUp(sizeof(uint64_t)) + alignUp(m_mailCapacity * sizeof(Message)) + alignUp(m_mailCapacity * maxGenome * sizeof(uint16_t));
+  const size_t edgePerSlab = alignUp(sizeof(uint64_t)) + alignUp(m_edgeCapacity * sizeof(uint64_t)) + alignUp(m_edgeCapacity * sizeof(Cell));
+  m_sharedSize = alignUp(sizeof(SlabControl))
+    + alignUp(sizeof(SlabShared) * processes)
+    + exchangePerSlab * processes
+    + soilPerSlab * processes
+    + mailPerSlab * processes
+    + edgePerSlab * processes
+    + static_cast<size_t>(width) * height * sizeof(uint32_t);
+
+  const std::string name = "/genxide-" + std::to_string(getpid());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if ( fd < 0 )
+  {
+    std::cerr << "shm_open failed: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  // The name is only needed until the mapping exists; workers inherit it through fork
+  shm_unlink(name.c_str());
+
+  if ( ftruncate(fd, static_cast<off_t>(m_sharedSize)) != 0 )
+  {
+    std::cerr << "ftruncate failed: " << std::strerror(errno) << std::endl;
+    close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, m_sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if ( mapping == MAP_FAILED )
+  {
+    std::cerr << "mmap failed: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  m_shared = static_cast<uint8_t*>(mapping);
+
+  SlabControl* control = reinterpret_cast<SlabControl*>(m_shared);
+  control->processes = processes;
+  control->seed = seed;
+  control->command = static_cast<int32_t>(Command::Step);
+
+  pthread_barrierattr_t barrierAttr;
+  pthread_barrierattr_init(&barrierAttr);
+  pthread_barrierattr_setpshared(&barrierAttr, PTHREAD_PROCESS_SHARED);
+  pthread_barrier_init(&control->barrier, &barrierAttr, processes);
+  pthread_barrierattr_destroy(&barrierAttr);
+
+  for ( int i = 0; i < processes; ++i )
+  {
+    SlabShared* slab = getSlab(i);
+    sem_init(&slab->go, 1, 0);
+    sem_init(&slab->done, 1, 0);
+    slab->epoch = 0;
+  }
+
+  m_pixels.assign(static_cast<size_t>(width) * height, 0);
+
+  std::cout.flush();
+  std::cerr.flush();
+
+  for ( int i = 0; i < processes; ++i )
+  {
+    const pid_t pid = fork();
+
+    if ( pid == 0 )
+    {
+      runWorker(i);
+      _exit(0);
+    }
+
+    if ( pid < 0 )
+    {
+      std::cerr << "fork failed: " << std::strerror(errno) << std::endl;
+      // Workers already started are waiting on the barrier with a full count; stop them all
+      for ( int started : m_workers )
+      {
+        kill(started, SIGKILL);
+        waitpid(started, nullptr, 0);
+      }
+      m_workers.clear();
+      destroy();
+      return false;
+    }
+
+    m_workers.push_back(pid);
+  }
+
+  // Workers report once their initial slab is ready
+  collect();
+  return true;
+}
+
+void SlabPartition::update()
+{
+  broadcast(Command::Step);
+  collect();
+}
+
+void SlabPartition::reset( uint64_t seed )
+{
+  reinterpret_cast<SlabControl*>(m_shared)->seed = seed;
+  broadcast(Command::Reset);
+  collect();
+}
+
+void SlabPartition::destroy()
+{
+  if ( !m_workers.empty() )
+  {
+    broadcast(Command::Quit);
+    for ( int pid : m_workers )
+    {
+      waitpid(pid, nullptr, 0);
+    }
+  }
+
+  if ( m_shared )
+  {
+    SlabControl* control = reinterpret_cast<SlabControl*>(m_shared);
+    for ( int i = 0; i < control->processes; ++i )
+    {
+      sem_destroy(&getSlab(i)->go);
+      sem_destroy(&getSlab(i)->done);
+    }
+    pthread_barrier_destroy(&control->barrier);
+
+    munmap(m_shared, m_sharedSize);
+    m_shared = nullptr;
+  }
+
+  m_workers.clear();
+}
+
+SlabShared* SlabPartition::getSlab( int index ) const
+{
+  return reinterpret_cast<SlabShared*>(m_shared + alignUp(sizeof(SlabControl))) + index;
+}
+
+Cell* SlabPartition::getExchangeCells( int slab, int parity, int edge ) const
+{
+  const int processes = reinterpret_cast<SlabControl*>(m_shared)->processes;
+  const size_t edgeCells = static_cast<size_t>(HALO) * m_width;
+  const size_t cellBytes = alignUp(edgeCells * sizeof(Cell));
+  const size_t geneBytes = alignUp(edgeCells * m_maxGenome * sizeof(uint16_t));
+
+  const size_t base = alignUp(sizeof(SlabControl)) + alignUp(sizeof(SlabShared) * processes);
+  const size_t block = static_cast<size_t>(slab) * 4 + parity * 2 + edge;
+
+  return reinterpret_cast<Cell*>(m_shared + base + block * (cellBytes + geneBytes));
+}
+
+uint16_t* SlabPartition::getExchangeGenes( int slab, int parity, int edge ) const
+{
+  const size_t edgeCells = static_cast<size_t>(HALO) * m_width;
+  uint8_t* cells = reinterpret_cast<uint8_t*>(getExchangeCells(slab, parity, edge));
+  return reinterpret_cast<uint16_t*>(cells + alignUp(edgeCells * sizeof(Cell)));
+}
+
+float* SlabPartition::getSoilEdge( int slab, int edge ) const
+{
+  const int processes = reinterpret_cast<SlabControl*>(m_shared)->processes;
+  const size_t edgeCells = static_cast<size_t>(HALO) * m_width;
+  const size_t exchangePerSlab = 4 * (alignUp(edgeCells * sizeof(Cell)) + alignUp(edgeCells * m_maxGenome * sizeof(uint16_t)));
+  const size_t edgeBytes = alignUp(static_cast<size_t>(SOIL_HALO) * m_soilWidth * sizeof(float));
+
+  const size_t base = alignUp(sizeof(SlabControl)) + alignUp(sizeof(SlabShared) * processes) + exchangePerSlab * processes;
+  return reinterpret_cast<float*>(m_shared + base + (static_cast<size_t>(slab) * 2 + edge) * edgeBytes);
+}
+
+uint64_t* SlabPartition::getMailCount( int slab ) const
+{
+  const int processes = reinterpret_cast<SlabControl*>(m_shared)->processes;
+  const size_t soilPerSlab = 2 * alignUp(static_cast<size_t>(SOIL_HALO) * m_soilWidth * sizeof(float));
+  const size_t mailPerSlab = alignUp(sizeof(uint64_t)) + alignUp(m_mailCapacity * sizeof(Message)) + alignUp(m_mailCapacity * m_maxGenome * sizeof(uint16_t));
+
+  uint8_t* base = reinterpret_cast<uint8_t*>(getSoilEdge(0, 0)) + soilPerSlab * processes;
+  return reinterpret_cast<uint64_t*>(base + static_cast<size_t>(slab) * mailPerSlab);
+}
+
+Message* SlabPartition::getMail( int slab ) const
+{
+  return reinterpret_cast<Message*>(reinterpret_cast<uint8_t*>(getMailCount(slab)) + alignUp(sizeof(uint64_t)));
+}
+
+uint16_t* SlabPartition::getMailGenes( int slab ) const
+{
+  return reinterpret_cast<uint16_t*>(reinterpret_cast<uint8_t*>(getMail(slab)) + alignUp(m_mailCapacity * sizeof(Message)));
+}
+
+uint64_t* SlabPartition::getEdgeCount( int slab ) const
+{
+  const int processes = reinterpret_cast<SlabControl*>(m_shared)->processes;
+  const size_t mailPerSlab = alignUp(sizeof(uint64_t)) + alignUp(m_mailCapacity * sizeof(Message)) + alignUp(m_mailCapacity * m_maxGenome * sizeof(uint16_t));
+  const size_t edgePerSlab = alignUp(sizeof(uint64_t)) + alignUp(m_edgeCapacity * sizeof(uint64_t)) + alignUp(m_edgeCapacity * sizeof(Cell));
+
+  uint8_t* base = reinterpret_cast<uint8_t*>(getMailCount(0)) + mailPerSlab * processes;
+  return reinterpret_cast<uint64_t*>(base + static_cast<size_t>(slab) * edgePerSlab);
+}
+
+uint64_t* SlabPartition::getEdgeIndices( int slab ) const
+{
+  return reinterpret_cast<uint64_t*>(reinterpret_cast<uint8_t*>(getEdgeCount(slab)) + alignUp(sizeof(uint64_t)));
+}
+
+Cell* SlabPartition::getEdgeCells( int slab ) const
+{
+  return reinterpret_cast<Cell*>(reinterpret_cast<uint8_t*>(getEdgeIndices(slab)) + alignUp(m_edgeCapacity * sizeof(uint64_t)));
+}
+
+uint32_t* SlabPartition::getSharedPixels() const
+{
+  const size_t pixelBytes = static_cast<size_t>(m_width) * m_height * sizeof(uint32_t);
+  return reinterpret_cast<uint32_t*>(m_shared + m_sharedSize - pixelBytes);
+}
+
+void SlabPartition::getSlabRows( int slab, int& begin, int& end ) const
+{
+  begin = m_slabBegins[slab];
+  end = m_slabBegins[slab + 1];
+}
+
+void SlabPartition::broadcast( Command command )
+{
+  reinterpret_cast<SlabControl*>(m_shared)->command = static_cast<int32_t>(command);
+  for ( size_t i = 0; i < m_workers.size(); ++i )
+  {
+    sem_post(&getSlab(static_cast<int>(i))->go);
+  }
+}
+
+void SlabPartition::collect()
+{
+  m_typeCounts.fill(0);
+  for ( size_t i = 0; i < m_workers.size(); ++i )
+  {
+    SlabShared* slab = getSlab(static_cast<int>(i));
+    waitSemaphore(&slab->done);
+    for ( int plane = 0; plane < NeighbourPlanes::TYPE_PLANES; ++plane )
+    {
+      m_typeCounts[plane] += slab->counts[plane];
+    }
+  }
+
+  m_epoch = getSlab(0)->epoch;
+  std::memcpy(m_pixels.data(), getSharedPixels(), m_pixels.size() * sizeof(uint32_t));
+}
+
+void SlabPartition::runWorker( int slabIndex )
+{
+  SlabControl* control = reinterpret_cast<SlabControl*>(m_shared);
+  SlabShared* slab = getSlab(slabIndex);
+  const int processes = control->processes;
+
+  int ownedBegin, ownedEnd;
+  getSlabRows(slabIndex, ownedBegin, ownedEnd);
+
+  const int windowBegin = std::max(0, ownedBegin - HALO);
+  const int windowEnd = std::min(m_height, ownedEnd + HALO);
+
+  // Owned rows in local coordinates
+  const int localBegin = ownedBegin - windowBegin;
+  const int localEnd = ownedEnd - windowBegin;
+
+  Grid grid;
+
+  auto publish = [&]()
+  {
+    std::span<const uint32_t> pixels = grid.getPixels();
+    const size_t offset = static_cast<size_t>(localBegin) * m_width;
+    const size_t count = static_cast<size_t>(localEnd - localBegin) * m_width;
+
+    std::memcpy(getSharedPixels() + static_cast<size_t>(ownedBegin) * m_width, pixels.data() + offset, count * sizeof(uint32_t));
+
+    for ( int plane = 0; plane < NeighbourPlanes::TYPE_PLANES; ++plane )
+    {
+      slab->counts[plane] = grid.getPlanes().count(plane, localBegin, localEnd);
+    }
+
+    slab->epoch = grid.getEpoch();
+    sem_post(&slab->done);
+  };
+
+  // Seeds thrown across slab edges go through the mail blocks: every slab
+  // posts its outgoing seeds, waits for the others, then takes the seeds
+  // aimed at its own rows from all of them
+  Grid::WindowLink link;
+  link.ownedBegin = localBegin;
+  link.ownedEnd = localEnd;
+  link.exchangeMail = [&]( std::span<const Message> outgoing, std::span<const uint16_t> outgoingGenes,
+                           std::vector<Message>& incoming, std::vector<uint16_t>& incomingGenes )
+  {
+    *getMailCount(slabIndex) = outgoing.size();
+    std::memcpy(getMail(slabIndex), outgoing.data(), outgoing.size_bytes());
+    std::memcpy(getMailGenes(slabIndex), outgoingGenes.data(), outgoingGenes.size_bytes());
+
+    pthread_barrier_wait(&control->barrier);
+
+    const uint64_t ownedFirst = static_cast<uint64_t>(ownedBegin) * m_width;
+    const uint64_t ownedLast = static_cast<uint64_t>(ownedEnd) * m_width;
+    for ( int other = 0; other < processes; ++other )
+    {
+      if ( other == slabIndex ) continue;
+
+      const Message* mail = getMail(other);
+      const uint16_t* genes = getMailGenes(other);
+      for ( uint64_t i = 0; i < *getMailCount(other); ++i )
+      {
+        if ( mail[i].target < ownedFirst || mail[i].target >= ownedLast ) continue;
+
+        incoming.push_back(mail[i]);
+        incomingGenes.insert(incomingGenes.end(), genes + i * m_maxGenome, genes + (i + 1) * m_maxGenome);
+      }
+    }
+  };
+  // Halo soil samples come from the neighbours' outermost owned samples
+  link.exchangeSoil = [&]( SoilField& soil )
+  {
+    const int soilBegin = localBegin / Config::SOIL_SCALE;
+    const int soilEnd = localEnd / Config::SOIL_SCALE;
+    soil.exportRows(soilBegin, SOIL_HALO, getSoilEdge(slabIndex, 0));
+    soil.exportRows(soilEnd - SOIL_HALO, SOIL_HALO, getSoilEdge(slabIndex, 1));
+
+    pthread_barrier_wait(&control->barrier);
+
+    if ( slabIndex > 0 )
+    {
+      soil.importRows(soilBegin - SOIL_HALO, SOIL_HALO, getSoilEdge(slabIndex - 1, 1));
+    }
+    if ( slabIndex < processes - 1 )
+    {
+      soil.importRows(soilEnd, SOIL_HALO, getSoilEdge(slabIndex + 1, 0));
+    }
+  };
+
+  // Transport follows plants across slab edges: every slab publishes its
+  // cells of the plants reaching its edges, and each rebuilds the plants
+  // holding its own cells from what all of them published
+  link.shareEdges = [&]( std::span<const uint64_t> indices, std::span<const Cell> cells,
+                         std::vector<uint64_t>& sharedIndices, std::vector<Cell>& sharedCells )
+  {
+    *getEdgeCount(slabIndex) = indices.size();
+    std::memcpy(getEdgeIndices(slabIndex), indices.data(), indices.size_bytes());
+    std::memcpy(getEdgeCells(slabIndex), cells.data(), cells.size_bytes());
+
+    pthread_barrier_wait(&control->barrier);
+
+    // Slabs are in row order, so their lists follow each other in world order
+    sharedIndices.clear();
+    sharedCells.clear();
+    for ( int other = 0; other < processes; ++other )
+    {
+      const uint64_t count = *getEdgeCount(other);
+      sharedIndices.insert(sharedIndices.end(), getEdgeIndices(other), getEdgeIndices(other) + count);
+      sharedCells.insert(sharedCells.end(), getEdgeCells(other), getEdgeCells(other) + count);
+    }
+  };
+  grid.setWindowLink(link);
+
+  grid.initWindow(m_maxEnergy, m_maxGenome, m_width, windowEnd - windowBegin, m_useHVDirections, control->seed, windowBegin, m_height);
+  publish();
+
+  while ( true )
+  {
+    waitSemaphore(&slab->go);
+
+    const Command command = static_cast<Command>(control->command);
+    if ( command == Command::Quit ) break;
+
+    if ( command == Command::Reset )
+    {
+      grid.initWindow(m_maxEnergy, m_maxGenome, m_width, windowEnd - windowBegin, m_useHVDirections, control->seed, windowBegin, m_height);
+      publish();
+      continue;
+    }
+
+    grid.update();
+
+    const int parity = static_cast<int>(grid.getEpoch() & 1);
+    grid.exportRows(localBegin, HALO, getExchangeCells(slabIndex, parity, 0), getExchangeGenes(slabIndex, parity, 0));
+    grid.exportRows(localEnd - HALO, HALO, getExchangeCells(slabIndex, parity, 1), getExchangeGenes(slabIndex, parity, 1));
+
+    pthread_barrier_wait(&control->barrier);
+
+    // Neighbour above fills the top halo with its bottom rows, neighbour below the bottom halo
+    if ( slabIndex > 0 )
+    {
+      grid.importRows(0, HALO, getExchangeCells(slabIndex - 1, parity, 1), getExchangeGenes(slabIndex - 1, parity, 1));
+    }
+    if ( slabIndex < processes - 1 )
+    {
+      grid.importRows(localEnd, HALO, getExchangeCells(slabIndex + 1, parity, 0), getExchangeGenes(slabIndex + 1, parity, 0));
+    }
+
+    publish();
+  }
+}
+
+#else
+
+SlabPartition::~SlabPartition()
+{
+}
+
+bool SlabPartition::init( uint16_t, uint16_t, int, int, bool, uint64_t, int )
+{
+  std::cerr << "Multi-process mode is only available on Linux" << std::endl;
+  return false;
+}
+
+void SlabPartition::update()
+{
+}
+
+void SlabPartition::reset( uint64_t )
+{
+}
+
+void SlabPartition::destroy()
+{
+}
+
+#endif
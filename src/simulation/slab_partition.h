@@ -0,0 +1,86 @@
+#pragma once
+#include "cell.h"
+#include "mailbox.h"
+#include "neighbour_planes.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SlabShared;
+
+// Splits the world into horizontal slabs, each owned and updated by a forked
+// worker process holding only its rows plus a halo of Config::SLAB_HALO_ROWS.
+// Slab edges fall on soil sample rows. Every epoch the slabs exchange, through
+// POSIX shared memory, the soil samples of their halos before diffusion, the
+// cells of the plants reaching their edges for transport, the seeds thrown
+// across their edges, and finally their halo cells. Cell rules are
+// counter-seeded by world position, so results match a single-process Grid
+// run with the same seed (the partition_checksums test checks this). The coordinator (the calling
+// process) assembles pixels and stats for the UI. Linux only.
+class SlabPartition
+{
+  public:
+  SlabPartition() = default;
+  ~SlabPartition();
+
+  SlabPartition( const SlabPartition& ) = delete;
+  SlabPartition& operator=( const SlabPartition& ) = delete;
+
+  bool init( uint16_t maxEnergy, uint16_t maxGenome, int width, int height, bool useHVDirections, uint64_t seed, int processes );
+  void update();
+  void reset( uint64_t seed );
+  void destroy();
+
+  inline bool isActive() const { return !m_workers.empty(); }
+  inline int getProcessCount() const { return static_cast<int>(m_workers.size()); }
+  inline const std::vector<uint32_t>& getPixels() const { return m_pixels; }
+  inline uint64_t getEpoch() const { return m_epoch; }
+  inline uint64_t getAliveCount() const { return m_typeCounts[NeighbourPlanes::OCCUPIED]; }
+  inline uint64_t getTypeCount( CellType type ) const { return m_typeCounts[static_cast<int>(type)]; }
+
+  private:
+  enum class Command : int32_t
+  {
+    Step,
+    Reset,
+    Quit
+  };
+
+  std::vector<int> m_workers; // process ids
+  std::vector<uint32_t> m_pixels;
+
+  uint8_t* m_shared{ nullptr };
+  size_t m_sharedSize{ 0 };
+  size_t m_mailCapacity{ 0 }; // seeds one slab can throw at other slabs in an epoch
+  size_t m_edgeCapacity{ 0 }; // edge plant cells one slab can publish, all of its largest slab's
+  std::vector<int> m_slabBegins; // first row of each slab, then the world height
+
+  uint16_t m_maxEnergy{ 0 };
+  uint16_t m_maxGenome{ 0 };
+  int m_width{ 0 };
+  int m_height{ 0 };
+  int m_soilWidth{ 0 };
+  bool m_useHVDirections{ true };
+
+  uint64_t m_epoch{ 0 };
+  std::array<uint64_t, NeighbourPlanes::TYPE_PLANES> m_typeCounts{};
+
+  SlabShared* getSlab( int index ) const;
+  Cell* getExchangeCells( int slab, int parity, int edge ) const;
+  uint16_t* getExchangeGenes( int slab, int parity, int edge ) const;
+  uint64_t* getMailCount( int slab ) const;
+  Message* getMail( int slab ) const;
+  uint16_t* getMailGenes( int slab ) const;
+  float* getSoilEdge( int slab, int edge ) const;
+  uint64_t* getEdgeCount( int slab ) const;
+  uint64_t* getEdgeIndices( int slab ) const;
+  Cell* getEdgeCells( int slab ) const;
+  uint32_t* getSharedPixels() const;
+
+  void getSlabRows( int slab, int& begin, int& end ) const;
+  void broadcast( Command command );
+  void collect();
+
+  void runWorker( int slab );
+};
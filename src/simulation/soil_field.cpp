@@ -0,0 +1,251 @@
+#include "soil_field.h"
+#include "utils/binary_io.h"
+#include "utils/cpu_features.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+
+namespace
+{
+  // Samples per column block: three rows of 1024 floats stay in L1
+  constexpr int BLOCK_WIDTH = 1024;
+
+  // out = c + rate * (up + down + left + right - 4c), in the same operation
+  // order on both paths so results do not depend on the CPU
+  void diffuseSpanScalar( float rate, const float* center, const float* up, const float* down, float* out, int count )
+  {
+    for ( int x = 0; x < count; ++x )
+    {
+      const float sum = (up[x] + down[x]) + (center[x - 1] + center[x + 1]);
+      out[x] = center[x] + rate * (sum - 4.0f * center[x]);
+    }
+  }
+
+#if defined(GENXIDE_HAS_AVX2_PATH)
+
+  __attribute__((target("avx2")))
+  void diffuseSpanAVX2( float rate, const float* center, const float* up, const float* down, float* out, int count )
+  {
+    const __m256 rates = _mm256_set1_ps(rate);
+    const __m256 four = _mm256_set1_ps(4.0f);
+
+    int x = 0;
+    for ( ; x + 8 <= count; x += 8 )
+    {
+      const __m256 c = _mm256_loadu_ps(center + x);
+      const __m256 vertical = _mm256_add_ps(_mm256_loadu_ps(up + x), _mm256_loadu_ps(down + x));
+      const __m256 horizontal = _mm256_add_ps(_mm256_loadu_ps(center + x - 1), _mm256_loadu_ps(center + x + 1));
+      const __m256 laplacian = _mm256_sub_ps(_mm256_add_ps(vertical, horizontal), _mm256_mul_ps(four, c));
+      _mm256_storeu_ps(out + x, _mm256_add_ps(c, _mm256_mul_ps(rates, laplacian)));
+    }
+
+    diffuseSpanScalar(rate, center + x, up + x, down + x, out + x, count - x);
+  }
+
+#endif
+
+  void diffuseSpan( float rate, const float* center, const float* up, const float* down, float* out, int count )
+  {
+#if defined(GENXIDE_HAS_AVX2_PATH)
+    if ( CpuFeatures::hasAVX2() )
+    {
+      diffuseSpanAVX2(rate, center, up, down, out, count);
+      return;
+    }
+#endif
+    diffuseSpanScalar(rate, center, up, down, out, count);
+  }
+}
+
+void SoilField::init( int cellWidth, int cellHeight, int scale, float initial, ThreadPool* pool )
+{
+  m_cellWidth = cellWidth;
+  m_cellHeight = cellHeight;
+  m_scale = std::max(1, scale);
+  m_width = (cellWidth + m_scale - 1) / m_scale;
+  m_height = (cellHeight + m_scale - 1) / m_scale;
+  m_stride = static_cast<size_t>(m_width) + 2;
+
+  const size_t samples = m_stride * (static_cast<size_t>(m_height) + 2);
+  m_current.resize(samples);
+  m_next.resize(samples);
+
+  // Rows are first touched by the stripe that diffuses them
+  forEachRowStripe(pool, [&]( int rowBegin, int rowEnd )
+  {
+    const size_t begin = getSample(-1, rowBegin);
+    const size_t end = getSample(-1, rowEnd);
+    std::fill(m_current.begin() + begin, m_current.begin() + end, initial);
+    std::fill(m_next.begin() + begin, m_next.begin() + end, initial);
+  });
+  std::fill_n(m_next.begin(), m_stride, initial);
+  std::fill_n(m_next.begin() + getSample(-1, m_height), m_stride, initial);
+
+  fillGuards();
+}
+
+void SoilField::absorb( Cell* cells, uint16_t rootDrain, uint16_t maxEnergy, ThreadPool* pool )
+{
+  forEachRowStripe(pool, [&]( int rowBegin, int rowEnd )
+  {
+    absorbRows(cells, rootDrain, maxEnergy, rowBegin, rowEnd);
+  });
+}
+
+void SoilField::diffuse( float rate, ThreadPool* pool )
+{
+  beginDiffuse();
+  forEachRowStripe(pool, [&]( int rowBegin, int rowEnd )
+  {
+    diffuseRows(rate, rowBegin, rowEnd);
+  });
+  endDiffuse();
+}
+
+void SoilField::absorbRows( Cell* cells, uint16_t rootDrain, uint16_t maxEnergy, int rowBegin, int rowEnd )
+{
+  // A sample owns its block of cells, so rows of samples never share a root
+  for ( int sy = rowBegin; sy < rowEnd; ++sy )
+  {
+    const int yBegin = sy * m_scale;
+    const int yEnd = std::min(m_cellHeight, yBegin + m_scale);
+
+    for ( int sx = 0; sx < m_width; ++sx )
+    {
+      const int xBegin = sx * m_scale;
+      const int xEnd = std::min(m_cellWidth, xBegin + m_scale);
+
+      int roots = 0;
+      for ( int y = yBegin; y < yEnd; ++y )
+      {
+        for ( int x = xBegin; x < xEnd; ++x )
+        {
+          roots += cells[static_cast<size_t>(y) * m_cellWidth + x].type == CellType::Root;
+        }
+      }
+      if ( roots == 0 ) continue;
+
+      float& sample = m_current[getSample(sx, sy)];
+      const uint16_t share = static_cast<uint16_t>(std::min<float>(rootDrain, sample / roots));
+      if ( share == 0 ) continue;
+
+      int taken = 0;
+      for ( int y = yBegin; y < yEnd; ++y )
+      {
+        for ( int x = xBegin; x < xEnd; ++x )
+        {
+          Cell& cell = cells[static_cast<size_t>(y) * m_cellWidth + x];
+          if ( cell.type != CellType::Root ) continue;
+
+          const uint16_t gain = std::min<uint16_t>(share, maxEnergy - cell.energy);
+          cell.energy += gain;
+          taken += gain;
+        }
+      }
+      sample -= static_cast<float>(taken);
+    }
+  }
+}
+
+void SoilField::beginDiffuse()
+{
+  fillGuards();
+}
+
+void SoilField::diffuseRows( float rate, int rowBegin, int rowEnd )
+{
+  for ( int xBegin = 0; xBegin < m_width; xBegin += BLOCK_WIDTH )
+  {
+    const int count = std::min(m_width - xBegin, BLOCK_WIDTH);
+    for ( int y = rowBegin; y < rowEnd; ++y )
+    {
+      const float* center = &m_current[getSample(xBegin, y)];
+      diffuseSpan(rate, center, center - m_stride, center + m_stride, &m_next[getSample(xBegin, y)], count);
+    }
+  }
+}
+
+void SoilField::endDiffuse()
+{
+  m_current.swap(m_next);
+}
+
+double SoilField::getTotal() const
+{
+  double total = 0.0;
+  for ( int y = 0; y < m_height; ++y )
+  {
+    const float* row = &m_current[getSample(0, y)];
+    for ( int x = 0; x < m_width; ++x )
+    {
+      total += row[x];
+    }
+  }
+  return total;
+}
+
+void SoilField::exportRows( int y, int rows, float* out ) const
+{
+  for ( int row = 0; row < rows; ++row )
+  {
+    std::copy_n(&m_current[getSample(0, y + row)], m_width, out + static_cast<size_t>(row) * m_width);
+  }
+}
+
+void SoilField::importRows( int y, int rows, const float* in )
+{
+  for ( int row = 0; row < rows; ++row )
+  {
+    std::copy_n(in + static_cast<size_t>(row) * m_width, m_width, &m_current[getSample(0, y + row)]);
+  }
+}
+
+void SoilField::write( std::ostream& out ) const
+{
+  BinaryIO::write(out, m_width);
+  BinaryIO::write(out, m_height);
+  for ( int y = 0; y < m_height; ++y )
+  {
+    BinaryIO::writeArray(out, &m_current[getSample(0, y)], m_width);
+  }
+}
+
+bool SoilField::read( std::istream& in )
+{
+  int width = 0;
+  int height = 0;
+  if ( !BinaryIO::read(in, width) || !BinaryIO::read(in, height) ) return false;
+  if ( width != m_width || height != m_height ) return false;
+
+  for ( int y = 0; y < m_height; ++y )
+  {
+    if ( !BinaryIO::readArray(in, &m_current[getSample(0, y)], m_width) ) return false;
+  }
+  return true;
+}
+
+void SoilField::fillGuards()
+{
+  // Mirrored edges give zero flux across the border
+  for ( int y = 0; y < m_height; ++y )
+  {
+    float* row = &m_current[getSample(0, y)];
+    row[-1] = row[0];
+    row[m_width] = row[m_width - 1];
+  }
+  std::copy_n(&m_current[getSample(-1, 0)], m_stride, &m_current[getSample(-1, -1)]);
+  std::copy_n(&m_current[getSample(-1, m_height - 1)], m_stride, &m_current[getSample(-1, m_height)]);
+}
+
+void SoilField::forEachRowStripe( ThreadPool* pool, const RowFn& fn )
+{
+  if ( !pool )
+  {
+    fn(0, m_height);
+    return;
+  }
+
+  pool->parallelFor(m_height, [&]( size_t begin, size_t end, size_t )
+  {
+    fn(static_cast<int>(begin), static_cast<int>(end));
+  });
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "cell.h"
+#include "utils/mapped_memory.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+
+class ThreadPool;
+
+// Organic matter in the soil, one sample per scale x scale block of cells.
+// Dead cells deposit into it, roots drain it, and it spreads with a 5-point
+// diffusion stencil from one buffer into the other. Both buffers carry a
+// guard ring that mirrors the edge, so the border loses nothing and the
+// stencil needs no bounds checks. Rows are split across the pool and each
+// stripe is swept in column blocks that keep three rows in L1.
+class SoilField
+{
+  public:
+  SoilField() = default;
+
+  void init( int cellWidth, int cellHeight, int scale, float initial, ThreadPool* pool );
+
+  // Every root takes up to rootDrain from its sample, split evenly when the
+  // sample cannot feed all of them
+  void absorb( Cell* cells, uint16_t rootDrain, uint16_t maxEnergy, ThreadPool* pool );
+  void diffuse( float rate, ThreadPool* pool );
+
+  // The same work in pieces for time-sliced epochs. absorbRows() takes
+  // sample rows; a diffusion step is beginDiffuse(), diffuseRows() over
+  // every sample row in any split and order, then endDiffuse().
+  void absorbRows( Cell* cells, uint16_t rootDrain, uint16_t maxEnergy, int rowBegin, int rowEnd );
+  void beginDiffuse();
+  void diffuseRows( float rate, int rowBegin, int rowEnd );
+  void endDiffuse();
+
+  // Not thread-safe; deposit in cell order to keep float sums reproducible
+  inline void deposit( int x, int y, float amount ) { m_current[getSample(x / m_scale, y / m_scale)] += amount; }
+
+  inline float get( int x, int y ) const { return m_current[getSample(x / m_scale, y / m_scale)]; }
+  inline int getScale() const { return m_scale; }
+  inline int getWidth() const { return m_width; }
+  inline int getHeight() const { return m_height; }
+  double getTotal() const;
+
+  // Sample rows for halo exchange, getWidth() samples per row
+  void exportRows( int y, int rows, float* out ) const;
+  void importRows( int y, int rows, const float* in );
+
+  // read() expects a field of the same size
+  void write( std::ostream& out ) const;
+  bool read( std::istream& in );
+
+  private:
+  MappedVector<float> m_current;
+  MappedVector<float> m_next;
+
+  int m_cellWidth{ 0 };
+  int m_cellHeight{ 0 };
+  int m_scale{ 1 };
+  int m_width{ 0 };
+  int m_height{ 0 };
+  size_t m_stride{ 0 };
+
+  inline size_t getSample( int x, int y ) const { return (static_cast<size_t>(y) + 1) * m_stride + x + 1; }
+
+  void fillGuards();
+
+  using RowFn = std::function<void( int rowBegin, int rowEnd )>;
+  void forEachRowStripe( ThreadPool* pool, const RowFn& fn );
+};
@@ -0,0 +1,150 @@
+#include "timing_wheel.h"
+#include "utils/binary_io.h"
+#include <algorithm>
+#include <bit>
+
+void TimingWheel::init( uint64_t epoch )
+{
+  for ( auto& level : m_slots )
+  {
+    for ( std::vector<TimedEvent>& slot : level )
+    {
+      slot.clear();
+    }
+  }
+  m_overflow.clear();
+  m_firing.clear();
+  m_firingNext = 0;
+  m_epoch = epoch;
+  m_size = 0;
+}
+
+void TimingWheel::schedule( uint64_t epoch, uint32_t cell, CellEvent event )
+{
+  place({ std::max(epoch, m_epoch), cell, event });
+  m_size++;
+}
+
+void TimingWheel::place( const TimedEvent& event )
+{
+  // The highest bit where the event's epoch differs from now picks the level
+  const uint64_t diff = event.epoch ^ m_epoch;
+  const int level = diff == 0 ? 0 : (std::bit_width(diff) - 1) / SLOT_BITS;
+
+  if ( level >= LEVELS )
+  {
+    m_overflow.push_back(event);
+    return;
+  }
+
+  m_slots[level][(event.epoch >> (level * SLOT_BITS)) & (SLOTS - 1)].push_back(event);
+}
+
+void TimingWheel::cascade( std::vector<TimedEvent>& slot )
+{
+  m_firing.swap(slot);
+  for ( const TimedEvent& event : m_firing )
+  {
+    place(event);
+  }
+  m_firing.clear();
+}
+
+void TimingWheel::advance( const FireFn& fire )
+{
+  advance(fire, SIZE_MAX);
+}
+
+bool TimingWheel::advance( const FireFn& fire, size_t maxEvents )
+{
+  // Level 0 slots hold exactly one epoch; keep draining in case handlers reschedule into it
+  std::vector<TimedEvent>& slot = m_slots[0][m_epoch & (SLOTS - 1)];
+  for ( size_t fired = 0; fired < maxEvents; ++fired )
+  {
+    if ( m_firingNext == m_firing.size() )
+    {
+      m_firing.clear();
+      m_firingNext = 0;
+      if ( slot.empty() )
+      {
+        turn();
+        return true;
+      }
+      m_firing.swap(slot);
+      m_size -= m_firing.size();
+    }
+    fire(m_firing[m_firingNext++]);
+  }
+
+  return false;
+}
+
+void TimingWheel::turn()
+{
+  m_epoch++;
+
+  // Crossing into a new slot of a higher level moves its events down,
+  // starting from the highest level that turned
+  int turned = 0;
+  while ( turned < LEVELS && (m_epoch & ((uint64_t(1) << ((turned + 1) * SLOT_BITS)) - 1)) == 0 )
+  {
+    turned++;
+  }
+
+  if ( turned == LEVELS )
+  {
+    std::vector<TimedEvent> overflow;
+    overflow.swap(m_overflow);
+    for ( const TimedEvent& event : overflow )
+    {
+      place(event);
+    }
+    turned = LEVELS - 1;
+  }
+
+  for ( int level = turned; level >= 1; --level )
+  {
+    cascade(m_slots[level][(m_epoch >> (level * SLOT_BITS)) & (SLOTS - 1)]);
+  }
+}
+
+void TimingWheel::write( std::ostream& out ) const
+{
+  BinaryIO::write(out, m_epoch);
+  BinaryIO::write(out, static_cast<uint64_t>(m_size));
+
+  auto writeEvents = [&]( const std::vector<TimedEvent>& events )
+  {
+    for ( const TimedEvent& event : events )
+    {
+      BinaryIO::write(out, event.epoch);
+      BinaryIO::write(out, event.cell);
+      BinaryIO::write(out, event.event);
+    }
+  };
+
+  for ( const auto& level : m_slots )
+  {
+    for ( const std::vector<TimedEvent>& slot : level )
+    {
+      writeEvents(slot);
+    }
+  }
+  writeEvents(m_overflow);
+}
+
+bool TimingWheel::read( std::istream& in )
+{
+  uint64_t epoch = 0;
+  uint64_t count = 0;
+  if ( !BinaryIO::read(in, epoch) || !BinaryIO::read(in, count) ) return false;
+
+  init(epoch);
+  for ( uint64_t i = 0; i < count; ++i )
+  {
+    TimedEvent event{};
+    if ( !BinaryIO::read(in, event.epoch) || !BinaryIO::read(in, event.cell) || !BinaryIO::read(in, event.event) ) return false;
+    schedule(event.epoch, event.cell, event.event);
+  }
+  return true;
+}
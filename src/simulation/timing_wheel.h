@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+enum class CellEvent : uint8_t
+{
+  Decay   // a corpse at the cell finishes rotting into the soil
+};
+
+struct TimedEvent
+{
+  uint64_t epoch;   // epoch the event fires in
+  uint32_t cell;    // local cell index
+  CellEvent event;
+};
+
+// Hierarchical timing wheel for delayed per-cell events, so cells need no
+// timer fields and no epoch scans the whole grid for due timers. Level L
+// has 256 slots, each covering 256^L epochs; an event sits in the lowest
+// level whose slot range separates its epoch from the current one, and is
+// moved down a level when the wheel turns into its slot. Scheduling and
+// firing are O(1) and each event is moved at most once per level, so the
+// work per epoch is proportional to the events due. Epochs more than 2^32
+// ahead wait in an overflow list.
+class TimingWheel
+{
+  public:
+  using FireFn = std::function<void( const TimedEvent& event )>;
+
+  TimingWheel() = default;
+
+  // Clears all events; the next advance() fires epoch
+  void init( uint64_t epoch );
+
+  // Epochs already passed fire on the next advance()
+  void schedule( uint64_t epoch, uint32_t cell, CellEvent event );
+
+  // Fires the events of the current epoch, then moves to the next one.
+  // Handlers may schedule for the current epoch; those fire in the same call.
+  void advance( const FireFn& fire );
+  // Fires at most maxEvents of them and returns whether the epoch is done
+  // and the wheel has moved on; call again until it is
+  bool advance( const FireFn& fire, size_t maxEvents );
+
+  inline uint64_t getEpoch() const { return m_epoch; }
+  inline size_t size() const { return m_size; }
+
+  void write( std::ostream& out ) const;
+  bool read( std::istream& in );
+
+  private:
+  static constexpr int LEVELS = 4;
+  static constexpr int SLOT_BITS = 8;
+  static constexpr uint64_t SLOTS = uint64_t(1) << SLOT_BITS;
+
+  std::array<std::array<std::vector<TimedEvent>, SLOTS>, LEVELS> m_slots;
+  std::vector<TimedEvent> m_overflow;
+  std::vector<TimedEvent> m_firing;
+  size_t m_firingNext{ 0 }; // events of m_firing already fired
+
+  uint64_t m_epoch{ 0 };
+  size_t m_size{ 0 };
+
+  void place( const TimedEvent& event );
+  void cascade( std::vector<TimedEvent>& slot );
+  void turn();
+};
@@ -0,0 +1,328 @@
+#include "transport_network.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+
+namespace
+{
+  constexpr int DX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+  constexpr int DY[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+
+  // Levels smaller than this are reduced inline; waking the pool costs more
+  constexpr size_t PARALLEL_LEVEL_NODES = 4096;
+
+  inline bool isRelay( CellType type )
+  {
+    return type == CellType::Wood || type == CellType::Sprout;
+  }
+}
+
+void TransportNetwork::init( int width, int height, bool useHVDirections )
+{
+  m_width = width;
+  m_height = height;
+  m_step = useHVDirections ? 2 : 1;
+  m_marks.assign(static_cast<size_t>(width) * height, 0);
+  m_neighbours.clear();
+  m_stamp = 0;
+  clear();
+}
+
+void TransportNetwork::initGraph( std::vector<uint32_t> neighbours, bool useHVDirections )
+{
+  m_width = 0;
+  m_height = 0;
+  m_step = useHVDirections ? 2 : 1;
+  m_neighbours = std::move(neighbours);
+  m_marks.assign(m_neighbours.size() / 8, 0);
+  m_stamp = 0;
+  clear();
+}
+
+void TransportNetwork::clear()
+{
+  m_components.clear();
+  m_pendingRuns.clear();
+  m_large.clear();
+  m_small.clear();
+}
+
+void TransportNetwork::removeIf( const std::function<bool( uint32_t key )>& stale )
+{
+  std::erase_if(m_components, [&]( const Component& component ) { return stale(component.key); });
+}
+
+void TransportNetwork::prepare( std::span<const Sprout> sprouts )
+{
+  // Components are disjoint, so one stamp serves every search
+  m_pendingStamp = nextStamp();
+  m_pendingFirst = m_components.size();
+  m_pendingRuns.clear();
+  m_pendingCells.resize(sprouts.size());
+  for ( size_t i = 0; i < sprouts.size(); ++i )
+  {
+    if ( i == 0 || sprouts[i].key != sprouts[i - 1].key )
+    {
+      m_pendingRuns.push_back(i);
+      m_components.emplace_back().key = sprouts[i].key;
+    }
+    m_pendingCells[i] = sprouts[i].cell;
+  }
+  m_pendingRuns.push_back(sprouts.size());
+}
+
+void TransportNetwork::prepareTouching( const Cell* cells, size_t cellBegin, size_t cellEnd, const TakeFn& take )
+{
+  // Finding the components takes one serial pass; each flood marks its
+  // component so later cells of it are skipped
+  const uint32_t floodStamp = nextStamp();
+  std::vector<Sprout> sprouts;
+  std::vector<uint32_t> found;
+  uint32_t key = 0;
+
+  for ( size_t cell = cellBegin; cell < cellEnd; ++cell )
+  {
+    if ( !cells[cell].isAlive() || m_marks[cell] == floodStamp ) continue;
+
+    found.clear();
+    flood(static_cast<uint32_t>(cell), cells, floodStamp, found);
+    if ( take && !take(m_queue) ) continue;
+
+    std::sort(found.begin(), found.end());
+    for ( uint32_t sprout : found )
+    {
+      sprouts.push_back({ key, sprout });
+    }
+    key++;
+  }
+
+  // Keys only group the sprouts here
+  prepare(sprouts);
+  for ( size_t index = m_pendingFirst; index < m_components.size(); ++index )
+  {
+    m_components[index].key = NO_KEY;
+  }
+}
+
+void TransportNetwork::buildPending( const Cell* cells, size_t begin, size_t end )
+{
+  for ( size_t run = begin; run < end; ++run )
+  {
+    const std::span<const uint32_t> sproutCells(m_pendingCells.data() + m_pendingRuns[run], m_pendingRuns[run + 1] - m_pendingRuns[run]);
+    buildForest(m_components[m_pendingFirst + run], sproutCells, cells, m_pendingStamp);
+  }
+}
+
+void TransportNetwork::planRun( const Cell* cells, Cell* out, size_t outBegin, size_t outEnd, uint16_t maxEnergy, uint16_t reserve, ThreadPool* pool )
+{
+  m_runCells = cells;
+  m_runOut = out;
+  m_outBegin = outBegin;
+  m_outEnd = outEnd;
+  m_maxEnergy = maxEnergy;
+  m_reserve = reserve;
+
+  // Large forests are reduced one at a time with their levels split across
+  // the pool, the rest one forest per task
+  m_large.clear();
+  m_small.clear();
+  for ( size_t index = 0; index < m_components.size(); ++index )
+  {
+    if ( pool && m_components[index].nodeCells.size() >= PARALLEL_LEVEL_NODES * pool->getThreadCount() )
+    {
+      m_large.push_back(index);
+    }
+    else
+    {
+      m_small.push_back(index);
+    }
+  }
+}
+
+void TransportNetwork::runLarge( size_t index, ThreadPool* pool )
+{
+  reduce(m_components[m_large[index]], pool);
+}
+
+void TransportNetwork::runSmall( size_t begin, size_t end )
+{
+  for ( size_t i = begin; i < end; ++i )
+  {
+    reduce(m_components[m_small[i]], nullptr);
+  }
+}
+
+size_t TransportNetwork::getNodeCount() const
+{
+  size_t nodes = 0;
+  for ( const Component& component : m_components )
+  {
+    nodes += component.nodeCells.size();
+  }
+  return nodes;
+}
+
+size_t TransportNetwork::getLevelCount() const
+{
+  size_t levels = 0;
+  for ( const Component& component : m_components )
+  {
+    levels = std::max(levels, component.levelBegin.empty() ? 0 : component.levelBegin.size() - 1);
+  }
+  return levels;
+}
+
+uint32_t TransportNetwork::nextStamp()
+{
+  if ( ++m_stamp == 0 )
+  {
+    std::fill(m_marks.begin(), m_marks.end(), 0);
+    m_stamp = 1;
+  }
+  return m_stamp;
+}
+
+void TransportNetwork::flood( uint32_t cell, const Cell* cells, uint32_t stamp, std::vector<uint32_t>& sprouts )
+{
+  m_queue.clear();
+  m_queue.push_back(cell);
+  m_marks[cell] = stamp;
+
+  for ( size_t head = 0; head < m_queue.size(); ++head )
+  {
+    if ( cells[m_queue[head]].type == CellType::Sprout )
+    {
+      sprouts.push_back(m_queue[head]);
+    }
+
+    forEachNeighbour(m_queue[head], [&]( uint32_t next )
+    {
+      if ( m_marks[next] == stamp || !cells[next].isAlive() ) return;
+      m_marks[next] = stamp;
+      m_queue.push_back(next);
+    });
+  }
+}
+
+void TransportNetwork::buildForest( Component& component, std::span<const uint32_t> sprouts, const Cell* cells, uint32_t stamp )
+{
+  // Level 0: every sprout is a sink
+  component.nodeCells.assign(sprouts.begin(), sprouts.end());
+  component.childBegin.clear();
+  component.levelBegin.clear();
+  for ( uint32_t cell : sprouts )
+  {
+    m_marks[cell] = stamp;
+  }
+
+  // Children are appended while their parent is expanded, so they end up
+  // next to each other and right after the previous node's children
+  for ( size_t begin = 0; begin < component.nodeCells.size(); )
+  {
+    const size_t end = component.nodeCells.size();
+    component.levelBegin.push_back(static_cast<uint32_t>(begin));
+
+    for ( size_t node = begin; node < end; ++node )
+    {
+      component.childBegin.push_back(static_cast<uint32_t>(component.nodeCells.size()));
+
+      const uint32_t cell = component.nodeCells[node];
+      if ( !isRelay(cells[cell].type) ) continue;
+
+      forEachNeighbour(cell, [&]( uint32_t next )
+      {
+        if ( m_marks[next] == stamp || !cells[next].isAlive() ) return;
+        m_marks[next] = stamp;
+        component.nodeCells.push_back(next);
+      });
+    }
+
+    begin = end;
+  }
+
+  component.levelBegin.push_back(static_cast<uint32_t>(component.nodeCells.size()));
+  component.childBegin.push_back(static_cast<uint32_t>(component.nodeCells.size()));
+  component.flow.resize(component.nodeCells.size());
+}
+
+void TransportNetwork::reduce( Component& component, ThreadPool* pool )
+{
+  const Cell* cells = m_runCells;
+  Cell* out = m_runOut;
+  const size_t outBegin = m_outBegin;
+  const size_t outEnd = m_outEnd;
+
+  for ( size_t level = component.levelBegin.empty() ? 0 : component.levelBegin.size() - 1; level-- > 0; )
+  {
+    const bool sinks = level == 0;
+
+    auto reduceNodes = [&]( size_t begin, size_t end, size_t )
+    {
+      for ( size_t node = begin; node < end; ++node )
+      {
+        const uint32_t cell = component.nodeCells[node];
+
+        uint32_t total = cells[cell].energy;
+        for ( uint32_t child = component.childBegin[node]; child < component.childBegin[node + 1]; ++child )
+        {
+          total += component.flow[child];
+        }
+
+        uint16_t energy;
+        if ( sinks )
+        {
+          energy = static_cast<uint16_t>(std::min<uint32_t>(total, m_maxEnergy));
+        }
+        else
+        {
+          const uint32_t keep = std::min<uint32_t>(total, m_reserve);
+          component.flow[node] = total - keep;
+          energy = static_cast<uint16_t>(keep);
+        }
+
+        if ( cell >= outBegin && cell < outEnd )
+        {
+          out[cell - outBegin].energy = energy;
+        }
+      }
+    };
+
+    const size_t begin = component.levelBegin[level];
+    const size_t count = component.levelBegin[level + 1] - begin;
+
+    if ( pool && count >= PARALLEL_LEVEL_NODES )
+    {
+      pool->parallelFor(count, [&]( size_t stripeBegin, size_t stripeEnd, size_t worker )
+      {
+        reduceNodes(begin + stripeBegin, begin + stripeEnd, worker);
+      });
+    }
+    else
+    {
+      reduceNodes(begin, begin + count, 0);
+    }
+  }
+}
+
+template <typename Fn>
+void TransportNetwork::forEachNeighbour( uint32_t cell, Fn&& fn ) const
+{
+  if ( !m_neighbours.empty() )
+  {
+    const uint32_t* next = &m_neighbours[static_cast<size_t>(cell) * 8];
+    for ( int d = 0; d < 8; d += m_step )
+    {
+      if ( next[d] != NO_CELL ) fn(next[d]);
+    }
+    return;
+  }
+
+  const int x = static_cast<int>(cell % m_width);
+  const int y = static_cast<int>(cell / m_width);
+  for ( int d = 0; d < 8; d += m_step )
+  {
+    const int nx = x + DX[d];
+    const int ny = y + DY[d];
+    if ( nx < 0 || nx >= m_width || ny < 0 || ny >= m_height ) continue;
+    fn(static_cast<uint32_t>(ny * m_width + nx));
+  }
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "cell.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// Energy transport from leaves and roots to sprouts, one forest per
+// component of connected live cells. A forest is built by a breadth-first
+// search from the component's sprouts in cell order through Wood (and
+// Sprout) cells, so each reachable cell gets a parent one step closer to a
+// sprout. A search never leaves its component, so the forests are the same
+// as one search over the whole grid. Nodes are numbered in search order,
+// which makes every level and the children of every node contiguous ranges.
+// A run then reduces each forest from the deepest level up: each node keeps
+// a reserve and passes the rest to its parent, so energy reaches the sprouts
+// within a single epoch.
+//
+// Components carry a key (the organism they belong to), are built and
+// dropped individually, and are built and reduced in parallel, one
+// component per task; the few large enough to fill the pool on their own
+// are reduced level by level with each level split across the pool.
+class TransportNetwork
+{
+  public:
+  static constexpr uint32_t NO_KEY = UINT32_MAX;
+  static constexpr uint32_t NO_CELL = UINT32_MAX;
+
+  struct Sprout
+  {
+    uint32_t key;
+    uint32_t cell;
+  };
+
+  TransportNetwork() = default;
+
+  // width x height cells, a whole world or the owned rows of a slab window
+  void init( int width, int height, bool useHVDirections );
+  // Cells that are not a grid: neighbours[cell * 8 + d] is the cell one step
+  // in direction d (see Grid::DX8), or NO_CELL. Cells must be numbered in
+  // world order for the forests to match those of a grid.
+  void initGraph( std::vector<uint32_t> neighbours, bool useHVDirections );
+  void clear();
+
+  // Drops the components whose key stale() rejects
+  void removeIf( const std::function<bool( uint32_t key )>& stale );
+
+  // Building takes two parts so it can be spread over time slices: a
+  // prepare call queues components, then buildPending() builds the queued
+  // ones in any split and order until getPendingCount() are built. Every
+  // queued component must be built before the next prepare or run.
+  //
+  // Queues one component per key from all of its sprouts, sorted by key and
+  // then cell. Keys must name distinct components that are not built yet;
+  // components without sprouts move no energy and are left out.
+  void prepare( std::span<const Sprout> sprouts );
+  // Queues every component with a live cell in [cellBegin, cellEnd), keyed
+  // NO_KEY. When given, take() sees the cells of each component first and
+  // leaves it out by returning false.
+  using TakeFn = std::function<bool( std::span<const uint32_t> component )>;
+  void prepareTouching( const Cell* cells, size_t cellBegin, size_t cellEnd, const TakeFn& take = nullptr );
+  inline size_t getPendingCount() const { return m_pendingRuns.empty() ? 0 : m_pendingRuns.size() - 1; }
+  void buildPending( const Cell* cells, size_t begin, size_t end );
+
+  // Moves energy along every forest. Energies are read from cells; the new
+  // energy of each cell in [outBegin, outEnd) is written to out[cell - outBegin].
+  // out may alias cells, and both must stay valid until the run is over.
+  // planRun() sorts the forests into large ones, each reduced by
+  // runLarge() with its levels split across the pool, and small ones,
+  // reduced by runSmall() in any split and order.
+  void planRun( const Cell* cells, Cell* out, size_t outBegin, size_t outEnd, uint16_t maxEnergy, uint16_t reserve, ThreadPool* pool );
+  inline size_t getLargeCount() const { return m_large.size(); }
+  inline size_t getSmallCount() const { return m_small.size(); }
+  void runLarge( size_t index, ThreadPool* pool );
+  void runSmall( size_t begin, size_t end );
+
+  inline size_t getComponentCount() const { return m_components.size(); }
+  size_t getNodeCount() const;
+  size_t getLevelCount() const; // of the deepest forest
+
+  private:
+  struct Component
+  {
+    uint32_t key{ NO_KEY };
+    std::vector<uint32_t> nodeCells;  // node -> cell index, in search order
+    std::vector<uint32_t> childBegin; // node -> first child node; node + 1 -> end
+    std::vector<uint32_t> levelBegin; // level -> first node; level + 1 -> end
+    std::vector<uint32_t> flow;       // energy passed up by each node in the current run
+  };
+
+  std::vector<Component> m_components;
+  std::vector<uint32_t> m_marks; // per cell, stamp of the last flood or search that reached it
+  std::vector<uint32_t> m_queue; // flood queue
+  std::vector<uint32_t> m_neighbours; // graph cells only, 8 per cell
+  uint32_t m_stamp{ 0 };
+
+  // Queued components: m_components from m_pendingFirst on, built from the
+  // sprout cells between consecutive m_pendingRuns
+  size_t m_pendingFirst{ 0 };
+  uint32_t m_pendingStamp{ 0 };
+  std::vector<size_t> m_pendingRuns;
+  std::vector<uint32_t> m_pendingCells;
+
+  // Current run
+  const Cell* m_runCells{ nullptr };
+  Cell* m_runOut{ nullptr };
+  size_t m_outBegin{ 0 };
+  size_t m_outEnd{ 0 };
+  uint16_t m_maxEnergy{ 0 };
+  uint16_t m_reserve{ 0 };
+  std::vector<size_t> m_large; // component indices
+  std::vector<size_t> m_small;
+
+  int m_width{ 0 };
+  int m_height{ 0 };
+  int m_step{ 2 };
+
+  uint32_t nextStamp();
+  // Appends the sprouts of the component holding cell to sprouts
+  void flood( uint32_t cell, const Cell* cells, uint32_t stamp, std::vector<uint32_t>& sprouts );
+  void buildForest( Component& component, std::span<const uint32_t> sprouts, const Cell* cells, uint32_t stamp );
+  void reduce( Component& component, ThreadPool* pool );
+
+  template <typename Fn>
+  void forEachNeighbour( uint32_t cell, Fn&& fn ) const;
+};
@@ -0,0 +1,121 @@
+#include "view_pyramid.h"
+#include "cell_view.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <bit>
+
+void ViewPyramid::init( int width, int height, int tileSize )
+{
+  m_tileSize = tileSize;
+  m_tileLevels = std::countr_zero(static_cast<unsigned>(tileSize));
+  m_tilesX = (width + tileSize - 1) / tileSize;
+  m_tilesY = (height + tileSize - 1) / tileSize;
+
+  m_widths.assign(1, width);
+  m_heights.assign(1, height);
+  while ( m_widths.back() > 1 || m_heights.back() > 1 )
+  {
+    m_widths.push_back((m_widths.back() + 1) / 2);
+    m_heights.push_back((m_heights.back() + 1) / 2);
+  }
+
+  m_front.resize(m_widths.size() - 1);
+  m_back.resize(m_widths.size() - 1);
+  for ( size_t level = 1; level < m_widths.size(); ++level )
+  {
+    const size_t size = static_cast<size_t>(m_widths[level]) * m_heights[level];
+    m_front[level - 1].assign(size, 0);
+    m_back[level - 1].assign(size, 0);
+  }
+  publish();
+}
+
+void ViewPyramid::build( std::span<const uint32_t> pixels, ThreadPool* pool )
+{
+  auto rows = [&]( size_t begin, size_t end, size_t )
+  {
+    for ( size_t tileY = begin; tileY < end; ++tileY )
+    {
+      for ( int tileX = 0; tileX < m_tilesX; ++tileX )
+      {
+        mergeTile(m_back, pixels, tileX, static_cast<int>(tileY));
+      }
+    }
+  };
+  if ( pool ) pool->parallelFor(m_tilesY, rows);
+  else rows(0, m_tilesY, 0);
+
+  updateCoarse();
+  m_front = m_back;
+  publish();
+}
+
+void ViewPyramid::updateTiles( std::span<const uint32_t> pixels, std::span<const uint64_t> tileEpochs, uint64_t since, int tileRowBegin, int tileRowEnd )
+{
+  for ( int tileY = tileRowBegin; tileY < tileRowEnd; ++tileY )
+  {
+    for ( int tileX = 0; tileX < m_tilesX; ++tileX )
+    {
+      if ( tileEpochs[static_cast<size_t>(tileY) * m_tilesX + tileX] >= since )
+      {
+        mergeTile(m_back, pixels, tileX, tileY);
+      }
+    }
+  }
+}
+
+void ViewPyramid::updateCoarse()
+{
+  for ( int level = m_tileLevels + 1; level < getLevelCount(); ++level )
+  {
+    mergeBlocks(m_back, {}, level, 0, 0, m_widths[level], m_heights[level]);
+  }
+}
+
+void ViewPyramid::swap()
+{
+  m_front.swap(m_back);
+  publish();
+}
+
+void ViewPyramid::mergeBlocks( std::vector<std::vector<uint32_t>>& levels, std::span<const uint32_t> pixels, int level, int x0, int y0, int x1, int y1 )
+{
+  // A block on the far edge has only the children that exist; repeating
+  // them keeps their proportions
+  const std::span<const uint32_t> below = level == 1 ? pixels : std::span<const uint32_t>(levels[level - 2]);
+  const int belowWidth = m_widths[level - 1];
+  const int belowHeight = m_heights[level - 1];
+  std::vector<uint32_t>& out = levels[level - 1];
+
+  for ( int y = y0; y < y1; ++y )
+  {
+    const int top = 2 * y;
+    const int bottom = std::min(top + 1, belowHeight - 1);
+    for ( int x = x0; x < x1; ++x )
+    {
+      const int left = 2 * x;
+      const int right = std::min(left + 1, belowWidth - 1);
+      out[static_cast<size_t>(y) * m_widths[level] + x] = CellView::merge(
+        below[static_cast<size_t>(top) * belowWidth + left],
+        below[static_cast<size_t>(top) * belowWidth + right],
+        below[static_cast<size_t>(bottom) * belowWidth + left],
+        below[static_cast<size_t>(bottom) * belowWidth + right]);
+    }
+  }
+}
+
+void ViewPyramid::mergeTile( std::vector<std::vector<uint32_t>>& levels, std::span<const uint32_t> pixels, int tileX, int tileY )
+{
+  for ( int level = 1; level <= m_tileLevels && level < getLevelCount(); ++level )
+  {
+    const int size = m_tileSize >> level;
+    const int x0 = tileX * size;
+    const int y0 = tileY * size;
+    mergeBlocks(levels, pixels, level, x0, y0, std::min(x0 + size, m_widths[level]), std::min(y0 + size, m_heights[level]));
+  }
+}
+
+void ViewPyramid::publish()
+{
+  m_frontViews.assign(m_front.begin(), m_front.end());
+}
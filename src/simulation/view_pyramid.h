@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// Coarser copies of the pixel views for zoomed-out rendering. Level l holds
+// one view per 2^l x 2^l block of cells, merged from the four blocks below
+// it (see CellView::merge); level 0 is the pixels themselves. Like the
+// pixels the pyramid is double-buffered: the grid rebuilds the back copy of
+// the pixel tiles that changed, tile by tile across the pool, and swaps it
+// in with the pixels. Levels up to the tile size lie within a tile; the few
+// coarser ones are merged whole once the tiles are done.
+class ViewPyramid
+{
+  public:
+  ViewPyramid() = default;
+
+  // tileSize must be a power of two; levels stop when a level is one block
+  void init( int width, int height, int tileSize );
+
+  // Both copies, from scratch
+  void build( std::span<const uint32_t> pixels, ThreadPool* pool );
+  // Back copy: tiles of tile rows [tileRowBegin, tileRowEnd) with an epoch of
+  // at least since, then coarse levels once all rows are done
+  void updateTiles( std::span<const uint32_t> pixels, std::span<const uint64_t> tileEpochs, uint64_t since, int tileRowBegin, int tileRowEnd );
+  void updateCoarse();
+  void swap();
+
+  // Front copy of level >= 1; empty before init
+  inline std::span<const std::span<const uint32_t>> getLevels() const { return m_frontViews; }
+  inline int getLevelCount() const { return static_cast<int>(m_widths.size()); }
+  inline int getLevelWidth( int level ) const { return m_widths[level]; }
+  inline int getLevelHeight( int level ) const { return m_heights[level]; }
+  inline int getTilesY() const { return m_tilesY; }
+
+  private:
+  std::vector<std::vector<uint32_t>> m_front; // levels 1.., index level - 1
+  std::vector<std::vector<uint32_t>> m_back;
+  std::vector<std::span<const uint32_t>> m_frontViews;
+  std::vector<int> m_widths;  // level 0..
+  std::vector<int> m_heights;
+  int m_tileSize{ 0 };
+  int m_tileLevels{ 0 };
+  int m_tilesX{ 0 };
+  int m_tilesY{ 0 };
+
+  void mergeBlocks( std::vector<std::vector<uint32_t>>& levels, std::span<const uint32_t> pixels, int level, int x0, int y0, int x1, int y1 );
+  void mergeTile( std::vector<std::vector<uint32_t>>& levels, std::span<const uint32_t> pixels, int tileX, int tileY );
+  void publish();
+};
@@ -1,9 +1,13 @@
 #include "interface.h"
 #include "../simulation/simulation.h"
-#include "../rendering/camera2d.h"
+#include "../rendering/renderer.h"
+#include "../core/config.h"
+#include "../utils/cpu_features.h"
 #include <imgui.h>
+#include <algorithm>
 #include <backends/imgui_impl_sdl2.h>
 #include <backends/imgui_impl_opengl3.h>
+#include <backends/imgui_impl_sdlrenderer2.h>
 
 Interface::~Interface()
 {
@@ -26,9 +30,27 @@ bool Interface::init( SDL_Window* window, SDL_GLContext glContext )
   return true;
 }
 
+bool Interface::init( SDL_Window* window, SDL_Renderer* sdlRenderer )
+{
+  IMGUI_CHECKVERSION();
+  ImGui::CreateContext();
+
+  ImGui::StyleColorsClassic();
+
+  ImGui_ImplSDL2_InitForSDLRenderer(window, sdlRenderer);
+  ImGui_ImplSDLRenderer2_Init(sdlRenderer);
+  m_sdlRenderer = sdlRenderer;
+
+  return true;
+}
+
 void Interface::destroy()
 {
-  ImGui_ImplOpenGL3_Shutdown();
+  // Called again from the destructor after Application::shutdown()
+  if ( !ImGui::GetCurrentContext() ) return;
+
+  if ( m_sdlRenderer ) ImGui_ImplSDLRenderer2_Shutdown();
+  else ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplSDL2_Shutdown();
   ImGui::DestroyContext();
 }
@@ -40,7 +62,8 @@ void Interface::processEvent( const SDL_Event& event )
 
 void Interface::newFrame()
 {
-  ImGui_ImplOpenGL3_NewFrame();
+  if ( m_sdlRenderer ) ImGui_ImplSDLRenderer2_NewFrame();
+  else ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplSDL2_NewFrame();
   ImGui::NewFrame();
 
@@ -49,9 +72,9 @@ void Interface::newFrame()
   m_wantCaptureKeyboard = io.WantCaptureKeyboard;
 }
 
-void Interface::render( Simulation& simulation, Camera2D& camera )
+void Interface::render( Simulation& simulation, Renderer& renderer )
 {
-  const Grid& grid = simulation.getGrid();
+  const Camera2D& camera = renderer.getCamera();
 
   ImGui::Begin("GenXIDE");
 
@@ -60,8 +83,46 @@ void Interface::render( Simulation& simulation, Camera2D& camera )
 
   // Grid info
   ImGui::Separator();
-  ImGui::Text("Grid: %d x %d", grid.getWidth(), grid.getHeight());
-  ImGui::Text("Epoch: %llu", static_cast<unsigned long long>(grid.getEpoch()));
+  ImGui::Text("Grid: %d x %d", simulation.getWidth(), simulation.getHeight());
+  ImGui::Text("Epoch: %llu", static_cast<unsigned long long>(simulation.getEpoch()));
+  if ( !simulation.isPartitioned() )
+  {
+    // Progress of the epoch being computed behind the one on screen
+    ImGui::ProgressBar(simulation.getEpochProgress(), ImVec2(-1.0f, 0.0f), "next epoch");
+  }
+  ImGui::Text("Alive cells: %llu", static_cast<unsigned long long>(simulation.getAliveCount()));
+  ImGui::Text("Wood %llu  Leaf %llu  Root %llu  Sprout %llu",
+    static_cast<unsigned long long>(simulation.getTypeCount(CellType::Wood)),
+    static_cast<unsigned long long>(simulation.getTypeCount(CellType::Leaf)),
+    static_cast<unsigned long long>(simulation.getTypeCount(CellType::Root)),
+    static_cast<unsigned long long>(simulation.getTypeCount(CellType::Sprout)));
+  if ( simulation.isPartitioned() )
+  {
+    ImGui::Text("Processes: %d", simulation.getProcessCount());
+  }
+  else
+  {
+    const IntentResolver& intents = simulation.getGrid().getIntents();
+    ImGui::Text("Intents: %zu (%zu lost to conflicts)", intents.getLastIntentCount(), intents.getLastConflictCount());
+    const Mailbox& mailbox = simulation.getGrid().getMailbox();
+    ImGui::Text("Seeds: %zu landed of %zu thrown", mailbox.getDelivered().size(), mailbox.getLastMessageCount());
+    const MutationEngine& mutations = simulation.getGrid().getMutations();
+    const GenomeStore& genomes = simulation.getGrid().getGenomes();
+    ImGui::Text("Mutations: %zu in %zu genomes (%zu draws)", mutations.getLastMutationCount(), mutations.getLastGenomeCount(), mutations.getLastDrawCount());
+    ImGui::Text("Genome slots: %zu (%zu free)", genomes.size(), genomes.getFreeCount());
+    if ( simulation.getGrid().hasOrganisms() )
+    {
+      ImGui::Text("Organisms: %zu", simulation.getGrid().getOrganisms().getOrganismCount());
+    }
+    const TransportNetwork& transport = simulation.getGrid().getTransport();
+    ImGui::Text("Transport: %zu cells in %zu forests, up to %zu levels", transport.getNodeCount(), transport.getComponentCount(), transport.getLevelCount());
+    const Grid& grid = simulation.getGrid();
+    ImGui::Text("Soil: %.0f organic, %.3f of %.3f ms per epoch", grid.getSoil().getTotal(), grid.getLastSoilSeconds() * 1000.0, grid.getLastUpdateSeconds() * 1000.0);
+    ImGui::Text("Pending events: %zu", grid.getTimers().size());
+    ImGui::Text("Rule ms  Wood %.3f  Leaf %.3f  Root %.3f  Sprout %.3f",
+      grid.getTypeSeconds(CellType::Wood) * 1000.0, grid.getTypeSeconds(CellType::Leaf) * 1000.0,
+      grid.getTypeSeconds(CellType::Root) * 1000.0, grid.getTypeSeconds(CellType::Sprout) * 1000.0);
+  }
 
   // Simulation controls
   ImGui::Separator();
@@ -86,6 +147,51 @@ void Interface::render( Simulation& simulation, Camera2D& camera )
     simulation.reset();
   }
 
+  if ( !simulation.isPartitioned() )
+  {
+    if ( ImGui::Button("Save World") )
+    {
+      simulation.saveWorld(Config::WORLD_FILE);
+    }
+    ImGui::SameLine();
+    if ( ImGui::Button("Load World") )
+    {
+      simulation.loadWorld(Config::WORLD_FILE);
+    }
+  }
+
+  renderMemoryPlacement(simulation);
+
+  // Colouring, done in the shader or in the software rasterizer's tables
+  ImGui::Separator();
+  const char* viewModes[] = { "Cell types", "Genomes", "Energy", "Age" };
+  int viewMode = static_cast<int>(renderer.getViewMode());
+  if ( ImGui::Combo("View", &viewMode, viewModes, IM_ARRAYSIZE(viewModes)) )
+  {
+    renderer.setViewMode(static_cast<Renderer::ViewMode>(viewMode));
+  }
+  if ( renderer.getHighlight() >= 0 )
+  {
+    ImGui::Text("Highlighted genome: %04x", renderer.getHighlight());
+    ImGui::SameLine();
+    if ( ImGui::Button("Clear") )
+    {
+      renderer.setHighlight(-1);
+    }
+  }
+  else
+  {
+    ImGui::TextDisabled("Right-click a cell to highlight its genome");
+  }
+  if ( renderer.isSoftware() )
+  {
+    renderSoftwareStats(renderer);
+  }
+  else
+  {
+    renderUploads(renderer);
+  }
+
   // Camera info
   ImGui::Separator();
   ImGui::Text("Camera Position: (%.1f, %.1f)", camera.getX(), camera.getY());
@@ -104,5 +210,102 @@ void Interface::render( Simulation& simulation, Camera2D& camera )
   // }
 
   ImGui::Render();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  if ( m_sdlRenderer ) ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), m_sdlRenderer);
+  else ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+}
+
+void Interface::renderUploads( Renderer& renderer )
+{
+  // OpenGL only: the overlay, shader reloads and texture uploads
+  bool overlay = renderer.isOverlayEnabled();
+  if ( ImGui::Checkbox("Cell detail", &overlay) )
+  {
+    renderer.setOverlay(overlay);
+  }
+  if ( overlay )
+  {
+    ImGui::SameLine();
+    if ( renderer.getOverlayCells() > 0 ) ImGui::Text("%zu cells", renderer.getOverlayCells());
+    else ImGui::TextDisabled("zoom in to show");
+  }
+  if ( renderer.getShaderReloads() > 0 )
+  {
+    ImGui::Text(renderer.hasShaderErrors() ? "Shader reload %d failed, see the log" : "Shaders reloaded %d times", renderer.getShaderReloads());
+  }
+
+  // Grid texture uploads
+  ImGui::Separator();
+  ImGui::Text("Upload: %.3f ms on the main thread", renderer.getUploadSeconds() * 1000.0);
+  ImGui::Text("Uploaded: %.1f KiB in %zu rects this frame", renderer.getUploadBytes() / 1024.0, renderer.getUploadRects());
+  if ( renderer.getLevel() > 0 )
+  {
+    ImGui::Text("Zoomed out: one texel per %dx%d cells", 1 << renderer.getLevel(), 1 << renderer.getLevel());
+  }
+  if ( renderer.isPaged() )
+  {
+    const PageTable& pages = renderer.getPages();
+    ImGui::Text("Pages: %zu of %d slots resident, %zu in view missing", pages.getLoaded().size() + pages.getPending().size(),
+      pages.getSlotCount(), pages.getMissingCount());
+  }
+}
+
+void Interface::renderSoftwareStats( const Renderer& renderer )
+{
+  // Drawn on the CPU, one band of rows per thread
+  const SoftwareRasterizer& rasterizer = renderer.getRasterizer();
+  ImGui::Separator();
+  ImGui::Text("Software: %.3f ms per frame on %zu threads%s", rasterizer.getDrawSeconds() * 1000.0, rasterizer.getThreadCount(),
+    CpuFeatures::hasAVX2() ? ", AVX2 gathers" : "");
+  if ( renderer.getLevel() > 0 )
+  {
+    ImGui::Text("Zoomed out: one view per %dx%d cells", 1 << renderer.getLevel(), 1 << renderer.getLevel());
+  }
+}
+
+void Interface::renderMemoryPlacement( const Simulation& simulation )
+{
+  const MappedMemory::Settings& settings = MappedMemory::getSettings();
+
+  ImGui::Separator();
+  ImGui::Text("Threads: %zu", simulation.getThreadCount());
+  ImGui::Text("Huge pages: %s%s", MappedMemory::toString(settings.hugePages), settings.lock ? ", mlocked" : "");
+
+  if ( ImGui::Button("Inspect Placement") )
+  {
+    m_placement = MappedMemory::inspect();
+    m_hasPlacement = true;
+  }
+
+  if ( !m_hasPlacement ) return;
+
+  const double mib = 1.0 / (1024.0 * 1024.0);
+  const size_t mapped = m_placement.mappedBytes;
+  const size_t huge = std::min(m_placement.hugeBytes, mapped);
+
+  if ( simulation.isPartitioned() )
+  {
+    ImGui::TextDisabled("Coordinator process only");
+  }
+
+  ImGui::Text("Mapped: %.1f MiB in %zu regions", mapped * mib, m_placement.regionCount);
+  ImGui::Text("Huge-page backed: %.1f MiB (%.0f%%)", huge * mib, mapped ? 100.0 * huge / mapped : 0.0);
+  ImGui::Text("Locked: %.1f MiB", m_placement.lockedBytes * mib);
+
+  // Translations needed to cover the grid buffers once, the TLB pressure of a full sweep
+  if ( m_placement.hugePageSize > 0 )
+  {
+    const size_t entries = (mapped - huge) / 4096 + huge / m_placement.hugePageSize;
+    ImGui::Text("Page translations per sweep: %zu", entries);
+  }
+
+  uint64_t sampled = 0;
+  for ( uint64_t pages : m_placement.pagesPerNode )
+  {
+    sampled += pages;
+  }
+
+  for ( size_t node = 0; node < m_placement.pagesPerNode.size(); ++node )
+  {
+    ImGui::Text("NUMA node %zu: %.0f%% of sampled pages", node, sampled ? 100.0 * m_placement.pagesPerNode[node] / sampled : 0.0);
+  }
 }
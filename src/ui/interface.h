@@ -1,9 +1,10 @@
 #pragma once
 #include <SDL.h>
 #include <glad/glad.h>
+#include "../utils/mapped_memory.h"
 
 class Simulation;
-class Camera2D;
+class Renderer;
 
 class Interface
 {
@@ -12,11 +13,13 @@ class Interface
   ~Interface();
 
   bool init( SDL_Window* window, SDL_GLContext glContext );
+  // Drawn through the window's software SDL_Renderer instead of OpenGL
+  bool init( SDL_Window* window, SDL_Renderer* sdlRenderer );
   void destroy();
 
   void processEvent( const SDL_Event& event );
   void newFrame();
-  void render( Simulation& simulation, Camera2D& camera );
+  void render( Simulation& simulation, Renderer& renderer );
 
   inline bool wantCaptureMouse() const { return m_wantCaptureMouse; }
   inline bool wantCaptureKeyboard() const { return m_wantCaptureKeyboard; }
@@ -25,4 +28,13 @@ class Interface
   bool m_wantCaptureMouse{ false };
   bool m_wantCaptureKeyboard{ false };
   bool m_showDemoWindow{ false };
+  SDL_Renderer* m_sdlRenderer{ nullptr };
+
+  // Last result of MappedMemory::inspect(), refreshed on request since it reads /proc
+  MappedMemory::Placement m_placement;
+  bool m_hasPlacement{ false };
+
+  void renderUploads( Renderer& renderer );
+  void renderSoftwareStats( const Renderer& renderer );
+  void renderMemoryPlacement( const Simulation& simulation );
 };
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+// Raw native-endian reads and writes of trivially copyable values, for
+// world files that are read back on the same kind of machine
+namespace BinaryIO
+{
+  template <typename T>
+  inline void write( std::ostream& out, const T& value )
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  inline bool read( std::istream& in, T& value )
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+  }
+
+  template <typename T>
+  inline void writeArray( std::ostream& out, const T* values, size_t count )
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(T)));
+  }
+
+  template <typename T>
+  inline bool readArray( std::istream& in, T* values, size_t count )
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(count * sizeof(T))));
+  }
+}
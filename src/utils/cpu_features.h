@@ -0,0 +1,20 @@
+#pragma once
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GENXIDE_HAS_AVX2_PATH 1
+#endif
+
+namespace CpuFeatures
+{
+  // Kernels with an AVX2 path are compiled with a target attribute and picked at runtime
+  inline bool hasAVX2()
+  {
+#if defined(GENXIDE_HAS_AVX2_PATH)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+  }
+}
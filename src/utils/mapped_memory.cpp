@@ -0,0 +1,287 @@
+#include "mapped_memory.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace MappedMemory
+{
+  namespace
+  {
+    struct Region
+    {
+      size_t bytes;    // mapped length
+      bool hugetlb;    // explicit huge pages
+      bool advised;    // MADV_HUGEPAGE applied
+      bool locked;
+    };
+
+    Settings s_settings;
+    std::mutex s_mutex;
+    std::map<uintptr_t, Region> s_regions;
+
+    // Anything smaller than this is not worth a huge page
+    constexpr size_t HUGE_THRESHOLD = size_t(2) << 20;
+    constexpr size_t MAX_NODE_SAMPLES = 4096;
+
+    size_t readHugePageSize()
+    {
+      std::ifstream meminfo("/proc/meminfo");
+      std::string key;
+      size_t value;
+
+      while ( meminfo >> key >> value )
+      {
+        if ( key == "Hugepagesize:" ) return value * 1024;
+        meminfo.ignore(256, '\n');
+      }
+
+      return HUGE_THRESHOLD;
+    }
+
+    size_t getHugePageSize()
+    {
+      static const size_t size = readHugePageSize();
+      return size;
+    }
+
+    size_t roundUp( size_t value, size_t alignment )
+    {
+      return (value + alignment - 1) / alignment * alignment;
+    }
+  }
+
+  void configure( const Settings& settings )
+  {
+    s_settings = settings;
+  }
+
+  const Settings& getSettings()
+  {
+    return s_settings;
+  }
+
+  const char* toString( HugePages mode )
+  {
+    switch ( mode )
+    {
+      case HugePages::Off: return "off";
+      case HugePages::Transparent: return "transparent";
+      case HugePages::Explicit: return "explicit";
+    }
+    return "?";
+  }
+
+#if defined(__linux__)
+
+  void* allocate( size_t bytes )
+  {
+    if ( bytes == 0 ) bytes = 1;
+
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t hugeSize = getHugePageSize();
+    const bool wantHuge = s_settings.hugePages != HugePages::Off && bytes >= HUGE_THRESHOLD;
+
+    Region region{ roundUp(bytes, pageSize), false, false, false };
+    void* pointer = MAP_FAILED;
+
+    if ( wantHuge && s_settings.hugePages == HugePages::Explicit )
+    {
+      const size_t length = roundUp(bytes, hugeSize);
+      pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if ( pointer != MAP_FAILED )
+      {
+        region.bytes = length;
+        region.hugetlb = true;
+      }
+    }
+
+    if ( pointer == MAP_FAILED && wantHuge )
+    {
+      // Over-map and trim so the region starts on a huge page boundary, which
+      // transparent huge pages need to back it fully
+      const size_t length = roundUp(bytes, hugeSize);
+      void* raw = mmap(nullptr, length + hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if ( raw != MAP_FAILED )
+      {
+        const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+        const uintptr_t aligned = roundUp(start, hugeSize);
+        if ( aligned > start ) munmap(raw, aligned - start);
+        const size_t tail = (start + length + hugeSize) - (aligned + length);
+        if ( tail > 0 ) munmap(reinterpret_cast<void*>(aligned + length), tail);
+
+        pointer = reinterpret_cast<void*>(aligned);
+        region.bytes = length;
+        region.advised = madvise(pointer, length, MADV_HUGEPAGE) == 0;
+      }
+    }
+
+    if ( pointer == MAP_FAILED )
+    {
+      pointer = mmap(nullptr, region.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if ( pointer == MAP_FAILED ) return nullptr;
+    }
+
+    if ( s_settings.lock )
+    {
+      region.locked = mlock(pointer, region.bytes) == 0;
+      if ( !region.locked )
+      {
+        static bool warned = false;
+        if ( !warned )
+        {
+          std::cerr << "mlock failed (" << std::strerror(errno) << "), grid memory stays pageable" << std::endl;
+          warned = true;
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_regions[reinterpret_cast<uintptr_t>(pointer)] = region;
+    return pointer;
+  }
+
+  void release( void* pointer, size_t )
+  {
+    if ( !pointer ) return;
+
+    Region region;
+    {
+      std::lock_guard<std::mutex> lock(s_mutex);
+      auto it = s_regions.find(reinterpret_cast<uintptr_t>(pointer));
+      if ( it == s_regions.end() ) return;
+      region = it->second;
+      s_regions.erase(it);
+    }
+
+    if ( region.locked ) munlock(pointer, region.bytes);
+    munmap(pointer, region.bytes);
+  }
+
+  Placement inspect()
+  {
+    Placement placement;
+    placement.hugePageSize = getHugePageSize();
+
+    std::map<uintptr_t, Region> regions;
+    {
+      std::lock_guard<std::mutex> lock(s_mutex);
+      regions = s_regions;
+    }
+
+    placement.regionCount = regions.size();
+    for ( const auto& [start, region] : regions )
+    {
+      placement.mappedBytes += region.bytes;
+      if ( region.hugetlb ) placement.hugeBytes += region.bytes;
+      if ( region.locked ) placement.lockedBytes += region.bytes;
+    }
+
+    // Transparent huge pages actually in use, from the kernel's view of our regions
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inRegion = false;
+
+    while ( std::getline(smaps, line) )
+    {
+      const size_t dash = line.find('-');
+      if ( dash != std::string::npos && dash > 0 && std::isxdigit(static_cast<unsigned char>(line[0])) && line.find(' ') > dash )
+      {
+        const uintptr_t start = std::strtoull(line.substr(0, dash).c_str(), nullptr, 16);
+        auto it = regions.upper_bound(start);
+        inRegion = it != regions.begin() && start < std::prev(it)->first + std::prev(it)->second.bytes && !std::prev(it)->second.hugetlb;
+        continue;
+      }
+
+      if ( inRegion && line.rfind("AnonHugePages:", 0) == 0 )
+      {
+        std::istringstream fields(line.substr(14));
+        size_t kilobytes = 0;
+        fields >> kilobytes;
+        placement.hugeBytes += kilobytes * 1024;
+      }
+    }
+
+    // Sample pages evenly across all regions and ask the kernel for their NUMA node
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t totalPages = placement.mappedBytes / pageSize;
+    const size_t step = std::max<size_t>(1, totalPages / MAX_NODE_SAMPLES);
+
+    std::vector<void*> pages;
+    for ( const auto& [start, region] : regions )
+    {
+      for ( size_t offset = 0; offset < region.bytes; offset += step * pageSize )
+      {
+        pages.push_back(reinterpret_cast<void*>(start + offset));
+      }
+    }
+
+    std::vector<int> status(pages.size(), -1);
+    if ( !pages.empty() && syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) == 0 )
+    {
+      for ( int node : status )
+      {
+        // Negative entries are pages nobody has touched yet
+        if ( node < 0 ) continue;
+        if ( static_cast<size_t>(node) >= placement.pagesPerNode.size() )
+        {
+          placement.pagesPerNode.resize(node + 1, 0);
+        }
+        placement.pagesPerNode[node]++;
+      }
+    }
+
+    return placement;
+  }
+
+#else
+
+  void* allocate( size_t bytes )
+  {
+    void* pointer = ::operator new(bytes ? bytes : 1, std::align_val_t(64), std::nothrow);
+    if ( pointer )
+    {
+      std::lock_guard<std::mutex> lock(s_mutex);
+      s_regions[reinterpret_cast<uintptr_t>(pointer)] = Region{ bytes, false, false, false };
+    }
+    return pointer;
+  }
+
+  void release( void* pointer, size_t )
+  {
+    if ( !pointer ) return;
+    {
+      std::lock_guard<std::mutex> lock(s_mutex);
+      s_regions.erase(reinterpret_cast<uintptr_t>(pointer));
+    }
+    ::operator delete(pointer, std::align_val_t(64));
+  }
+
+  Placement inspect()
+  {
+    Placement placement;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    placement.regionCount = s_regions.size();
+    for ( const auto& [start, region] : s_regions )
+    {
+      placement.mappedBytes += region.bytes;
+    }
+    return placement;
+  }
+
+#endif
+}
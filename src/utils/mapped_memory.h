@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Page-granular allocations for the large grid buffers. Memory comes straight
+// from mmap so it can be backed by huge pages and locked, and pages stay
+// untouched until first written, letting each worker thread fault in (and so
+// place on its own NUMA node) the stripe it owns.
+namespace MappedMemory
+{
+  enum class HugePages : uint8_t
+  {
+    Off,         // regular pages
+    Transparent, // madvise(MADV_HUGEPAGE)
+    Explicit     // MAP_HUGETLB from hugetlbfs, falls back to Transparent
+  };
+
+  struct Settings
+  {
+    HugePages hugePages{ HugePages::Transparent };
+    bool lock{ false };
+  };
+
+  struct Placement
+  {
+    size_t mappedBytes{ 0 };
+    size_t hugeBytes{ 0 };     // backed by huge pages, transparent or explicit
+    size_t lockedBytes{ 0 };
+    size_t regionCount{ 0 };
+    size_t hugePageSize{ 0 };
+    std::vector<uint64_t> pagesPerNode; // sampled, index = NUMA node
+  };
+
+  void configure( const Settings& settings );
+  const Settings& getSettings();
+
+  void* allocate( size_t bytes );
+  void release( void* pointer, size_t bytes );
+
+  // Walks the live regions; reads /proc and queries page nodes, so call on demand
+  Placement inspect();
+
+  const char* toString( HugePages mode );
+}
+
+// std allocator over MappedMemory. Default construction is skipped so that
+// resize() leaves pages untouched until their owner writes them. Elements
+// added that way read as zero on a fresh mapping but hold stale values when
+// reusing capacity, so owners always initialise them explicitly.
+template<typename T>
+struct MappedAllocator
+{
+  static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+
+  using value_type = T;
+
+  MappedAllocator() = default;
+  template<typename U> MappedAllocator( const MappedAllocator<U>& ) {}
+
+  T* allocate( size_t count )
+  {
+    void* pointer = MappedMemory::allocate(count * sizeof(T));
+    if ( !pointer ) throw std::bad_alloc();
+    return static_cast<T*>(pointer);
+  }
+
+  void deallocate( T* pointer, size_t count )
+  {
+    MappedMemory::release(pointer, count * sizeof(T));
+  }
+
+  template<typename U> void construct( U* ) {}
+  template<typename U, typename... Args> void construct( U* pointer, Args&&... args ) { ::new(static_cast<void*>(pointer)) U(std::forward<Args>(args)...); }
+
+  template<typename U> bool operator==( const MappedAllocator<U>& ) const { return true; }
+  template<typename U> bool operator!=( const MappedAllocator<U>& ) const { return false; }
+};
+
+template<typename T>
+using MappedVector = std::vector<T, MappedAllocator<T>>;
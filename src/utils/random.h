@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+
+// Counter-based randomness. Values derived from (seed, coordinates) are the
+// same no matter which thread or process computes them, which keeps runs
+// reproducible under any partitioning of the grid.
+namespace Random
+{
+  inline uint64_t mix( uint64_t x )
+  {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  inline uint64_t hash( uint64_t a, uint64_t b )
+  {
+    return mix(a ^ mix(b));
+  }
+
+  inline uint64_t hash( uint64_t a, uint64_t b, uint64_t c )
+  {
+    return mix(hash(a, b) ^ mix(c));
+  }
+
+  // SplitMix64, usable with the <random> distributions
+  class SplitMix64
+  {
+    public:
+    using result_type = uint64_t;
+
+    SplitMix64() = default;
+    explicit SplitMix64( uint64_t seed ) : m_state(seed) {}
+
+    inline void seed( uint64_t seed ) { m_state = seed; }
+    inline result_type operator()() { return mix(m_state++); }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    private:
+    uint64_t m_state{ 0 };
+  };
+}
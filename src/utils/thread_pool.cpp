@@ -0,0 +1,110 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool( size_t threadCount )
+{
+  if ( threadCount == 0 )
+  {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  m_threadCount = threadCount;
+  m_threads.reserve(threadCount - 1);
+
+  for ( size_t worker = 1; worker < threadCount; ++worker )
+  {
+    m_threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+
+  for ( std::thread& thread : m_threads )
+  {
+    thread.join();
+  }
+}
+
+void ThreadPool::stripeRange( size_t count, size_t stripes, size_t stripe, size_t& begin, size_t& end )
+{
+  const size_t base = count / stripes;
+  const size_t extra = count % stripes;
+
+  begin = stripe * base + std::min(stripe, extra);
+  end = begin + base + (stripe < extra ? 1 : 0);
+}
+
+void ThreadPool::parallelFor( size_t count, const StripeFn& fn )
+{
+  if ( count == 0 ) return;
+
+  if ( m_threads.empty() )
+  {
+    fn(0, count, 0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = &fn;
+    m_jobCount = count;
+    m_pending = m_threads.size();
+    m_generation++;
+  }
+  m_wake.notify_all();
+
+  // The calling thread takes stripe 0
+  size_t begin, end;
+  stripeRange(count, m_threadCount, 0, begin, end);
+  if ( begin < end )
+  {
+    fn(begin, end, 0);
+  }
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return m_pending == 0; });
+  m_job = nullptr;
+}
+
+void ThreadPool::workerLoop( size_t worker )
+{
+  uint64_t seenGeneration = 0;
+
+  while ( true )
+  {
+    const StripeFn* job;
+    size_t count;
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+
+      if ( m_stopping ) return;
+
+      seenGeneration = m_generation;
+      job = m_job;
+      count = m_jobCount;
+    }
+
+    size_t begin, end;
+    stripeRange(count, m_threadCount, worker, begin, end);
+    if ( begin < end )
+    {
+      (*job)(begin, end, worker);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if ( --m_pending == 0 )
+      {
+        m_done.notify_one();
+      }
+    }
+  }
+}
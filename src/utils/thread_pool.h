@@ -0,0 +1,45 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool that splits work into one contiguous stripe per worker.
+// Stripe i is always executed by worker i (worker 0 is the calling thread),
+// so data first touched by a stripe stays with the thread that owns it.
+class ThreadPool
+{
+  public:
+  using StripeFn = std::function<void( size_t begin, size_t end, size_t worker )>;
+
+  explicit ThreadPool( size_t threadCount = 0 );
+  ~ThreadPool();
+
+  ThreadPool( const ThreadPool& ) = delete;
+  ThreadPool& operator=( const ThreadPool& ) = delete;
+
+  void parallelFor( size_t count, const StripeFn& fn );
+
+  inline size_t getThreadCount() const { return m_threadCount; }
+
+  static void stripeRange( size_t count, size_t stripes, size_t stripe, size_t& begin, size_t& end );
+
+  private:
+  std::vector<std::thread> m_threads;
+  size_t m_threadCount{ 1 };
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+
+  const StripeFn* m_job{ nullptr };
+  size_t m_jobCount{ 0 };
+  uint64_t m_generation{ 0 };
+  size_t m_pending{ 0 };
+  bool m_stopping{ false };
+
+  void workerLoop( size_t worker );
+};
@@ -0,0 +1,222 @@
+#include "simulation/grid.h"
+#include "simulation/intent_resolver.h"
+#include "simulation/mailbox.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+// A world must evolve the same whatever the thread count and however its
+// epochs are sliced: conflicting intents go to the lowest key and mail is
+// delivered in tile order, never in the order workers finish. Races need
+// more than one core to show up in whole worlds, so the resolver and the
+// mailbox are also fed the same conflicts split and shuffled in different
+// ways and checked against the rule itself.
+namespace
+{
+  constexpr int WIDTH = 160;
+  constexpr int HEIGHT = 128;
+  constexpr int EPOCHS = 150;
+  constexpr uint64_t SEED = 99;
+
+  struct Run
+  {
+    const char* name;
+    size_t threads; // 0 runs inline without a pool
+    bool sliced;    // one work slice per advance() call
+  };
+
+  // FNV-1a over every cell and its genes
+  uint64_t hashWorld( const Grid& grid )
+  {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto add = [&]( uint64_t value )
+    {
+      hash = (hash ^ value) * 0x100000001B3ull;
+    };
+    for ( int y = 0; y < HEIGHT; ++y )
+    {
+      for ( int x = 0; x < WIDTH; ++x )
+      {
+        const Cell& cell = grid.getCell(x, y);
+        add(static_cast<uint64_t>(cell.type));
+        add(cell.energy);
+        add(cell.age);
+        add(cell.direction);
+        if ( !cell.isAlive() ) continue;
+        for ( uint16_t gene : grid.getGenome(cell.genomeIndex) )
+        {
+          add(gene);
+        }
+      }
+    }
+    return hash;
+  }
+
+  constexpr uint32_t TARGETS = 600;
+  constexpr int CONFLICTS = 5000;
+
+  // Distinct keys aimed at few targets, and the lowest key per target
+  std::vector<std::pair<uint64_t, uint32_t>> makeConflicts( std::unordered_map<uint32_t, uint64_t>& lowest )
+  {
+    std::mt19937_64 random(SEED);
+    std::vector<std::pair<uint64_t, uint32_t>> conflicts;
+    for ( int i = 0; i < CONFLICTS; ++i )
+    {
+      const uint64_t key = (random() & ~0xFFFFull) | static_cast<uint64_t>(i);
+      const uint32_t target = static_cast<uint32_t>(random() % TARGETS);
+      conflicts.push_back({ key, target });
+      const auto found = lowest.find(target);
+      if ( found == lowest.end() || key < found->second ) lowest[target] = key;
+    }
+    return conflicts;
+  }
+
+  bool checkResolver()
+  {
+    std::unordered_map<uint32_t, uint64_t> lowest;
+    std::vector<std::pair<uint64_t, uint32_t>> conflicts = makeConflicts(lowest);
+
+    // Workers, pool threads and intents per resolve() call
+    const size_t variants[][3] = { { 1, 0, SIZE_MAX }, { 4, 4, SIZE_MAX }, { 3, 3, 7 }, { 5, 0, 1 } };
+    std::mt19937_64 shuffle(SEED + 1);
+    for ( const auto& variant : variants )
+    {
+      std::shuffle(conflicts.begin(), conflicts.end(), shuffle);
+      std::unique_ptr<ThreadPool> pool = variant[1] > 0 ? std::make_unique<ThreadPool>(variant[1]) : nullptr;
+
+      IntentResolver resolver;
+      resolver.init(TARGETS, variant[0]);
+      for ( size_t i = 0; i < conflicts.size(); ++i )
+      {
+        resolver.propose(i % variant[0], { conflicts[i].first, 0, conflicts[i].second, IntentKind::Grow, CellType::Wood, 0 });
+      }
+
+      std::mutex mutex;
+      std::unordered_map<uint32_t, uint64_t> winners;
+      bool twice = false;
+      while ( !resolver.resolve(pool.get(), [&]( const Intent& intent )
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        twice = twice || !winners.emplace(intent.target, intent.key).second;
+      }, variant[2]) )
+      {
+      }
+
+      if ( twice || winners != lowest )
+      {
+        std::cerr << "Resolver with " << variant[0] << " buffers and slices of " << variant[2] << " did not apply the lowest key per target" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool checkMailbox()
+  {
+    std::unordered_map<uint32_t, uint64_t> lowest;
+    std::vector<std::pair<uint64_t, uint32_t>> conflicts = makeConflicts(lowest);
+
+    // Workers and pool threads; the delivery order must not change either
+    const size_t variants[][2] = { { 1, 0 }, { 4, 4 }, { 3, 3 } };
+    std::vector<uint64_t> expectedOrder;
+    std::mt19937_64 shuffle(SEED + 2);
+    for ( const auto& variant : variants )
+    {
+      std::shuffle(conflicts.begin(), conflicts.end(), shuffle);
+      std::unique_ptr<ThreadPool> pool = variant[1] > 0 ? std::make_unique<ThreadPool>(variant[1]) : nullptr;
+
+      Mailbox mailbox;
+      mailbox.init(30, TARGETS / 30, 8, variant[0]);
+      for ( size_t i = 0; i < conflicts.size(); ++i )
+      {
+        mailbox.post(i % variant[0], { conflicts[i].first, conflicts[i].second, 0, 0, MessageKind::Seed, 0 });
+      }
+      mailbox.deliver(pool.get(), []( const Message& ) { return true; });
+
+      std::unordered_map<uint32_t, uint64_t> winners;
+      std::vector<uint64_t> order;
+      for ( const Message& message : mailbox.getDelivered() )
+      {
+        winners[message.target] = message.key;
+        order.push_back(message.key);
+      }
+      if ( expectedOrder.empty() )
+      {
+        expectedOrder = order;
+      }
+
+      if ( winners != lowest || order != expectedOrder )
+      {
+        std::cerr << "Mailbox with " << variant[0] << " workers did not deliver the lowest key per target in tile order" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  if ( !checkResolver() || !checkMailbox() ) return 1;
+
+  const Run runs[] = {
+    { "1 thread", 0, false },
+    { "4 threads", 4, false },
+    { "1 thread, sliced", 0, true },
+    { "3 threads, sliced", 3, true },
+  };
+  constexpr int RUNS = sizeof(runs) / sizeof(runs[0]);
+
+  std::unique_ptr<ThreadPool> pools[RUNS];
+  Grid grids[RUNS];
+  for ( int i = 0; i < RUNS; ++i )
+  {
+    if ( runs[i].threads > 0 )
+    {
+      pools[i] = std::make_unique<ThreadPool>(runs[i].threads);
+      grids[i].setThreadPool(pools[i].get());
+    }
+    grids[i].init(Config::MAX_ENERGY, Config::MAX_GENOME, WIDTH, HEIGHT, Config::USE_HV_DIRECTIONS, SEED);
+  }
+
+  for ( int epoch = 1; epoch <= EPOCHS; ++epoch )
+  {
+    uint64_t expected = 0;
+    for ( int i = 0; i < RUNS; ++i )
+    {
+      if ( runs[i].sliced )
+      {
+        while ( !grids[i].advance(0.0) )
+        {
+        }
+      }
+      else
+      {
+        grids[i].update();
+      }
+
+      const uint64_t hash = hashWorld(grids[i]);
+      if ( i == 0 )
+      {
+        expected = hash;
+      }
+      else if ( hash != expected )
+      {
+        std::cerr << runs[i].name << " differs from " << runs[0].name << " at epoch " << epoch << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  if ( grids[0].getAliveCount() == 0 )
+  {
+    std::cerr << "The world died out by epoch " << EPOCHS << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include "simulation/ensemble.h"
+#include "simulation/grid.h"
+#include "utils/random.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+// Every replicate of an ensemble must evolve exactly like a Grid with the
+// replicate's seed, whatever the thread count, and stay alive like one
+namespace
+{
+  constexpr int WIDTH = 96;
+  constexpr int HEIGHT = 64;
+  constexpr int REPLICATES = 5;
+  constexpr int EPOCHS = 150;
+  constexpr uint64_t SEED = 1234;
+
+  bool sameCells( const Grid& replicate, const Grid& scalar )
+  {
+    for ( int y = 0; y < HEIGHT; ++y )
+    {
+      for ( int x = 0; x < WIDTH; ++x )
+      {
+        const Cell& a = replicate.getCell(x, y);
+        const Cell& b = scalar.getCell(x, y);
+        if ( a.type != b.type || a.energy != b.energy || a.age != b.age || a.direction != b.direction ) return false;
+        if ( a.isAlive() && !std::ranges::equal(replicate.getGenome(a.genomeIndex), scalar.getGenome(b.genomeIndex)) ) return false;
+      }
+    }
+    return true;
+  }
+
+  bool checkEnsemble( size_t threads )
+  {
+    Ensemble ensemble;
+    if ( !ensemble.init(REPLICATES, WIDTH, HEIGHT, threads, SEED) )
+    {
+      std::cerr << "Ensemble init failed on " << threads << " threads" << std::endl;
+      return false;
+    }
+
+    Grid scalars[REPLICATES];
+    for ( int i = 0; i < REPLICATES; ++i )
+    {
+      scalars[i].init(Config::MAX_ENERGY, Config::MAX_GENOME, WIDTH, HEIGHT, Config::USE_HV_DIRECTIONS, Random::hash(SEED, i));
+    }
+
+    for ( int epoch = 1; epoch <= EPOCHS; ++epoch )
+    {
+      ensemble.update();
+      for ( int i = 0; i < REPLICATES; ++i )
+      {
+        scalars[i].update();
+        if ( !sameCells(ensemble.getWorld(i), scalars[i]) )
+        {
+          std::cerr << "Replicate " << i << " on " << threads << " threads differs from its Grid at epoch " << epoch << std::endl;
+          return false;
+        }
+      }
+    }
+
+    for ( int i = 0; i < REPLICATES; ++i )
+    {
+      if ( ensemble.getWorld(i).getAliveCount() == 0 )
+      {
+        std::cerr << "Replicate " << i << " died out by epoch " << EPOCHS << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  bool ok = true;
+  for ( size_t threads : { 1, 3 } )
+  {
+    ok = checkEnsemble(threads) && ok;
+  }
+  return ok ? 0 : 1;
+}
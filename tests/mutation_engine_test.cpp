@@ -0,0 +1,190 @@
+#include "core/config.h"
+#include "simulation/mutation_engine.h"
+#include "utils/random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <string>
+#include <vector>
+
+// Genes must mutate at the configured rates, an offspring must mutate the
+// same way in any batch and at any position in it, and the random draws must
+// follow the offspring and mutations rather than the genome length
+namespace
+{
+  constexpr uint16_t STRIDE = Config::MAX_GENOME;
+  constexpr size_t PARENTS = 64;
+
+  struct Rates
+  {
+    const char* name;
+    double point;
+    double insertion;
+    double duplication;
+  };
+
+  // Parent i holds genes i, i + 1, ... so every gene of a parent differs from its neighbours
+  void initParents( GenomeStore& genomes )
+  {
+    genomes.init(STRIDE, PARENTS);
+    for ( uint32_t parent = 0; parent < PARENTS; ++parent )
+    {
+      std::span<uint16_t> genes = genomes.get(parent);
+      for ( size_t gene = 0; gene < STRIDE; ++gene )
+      {
+        genes[gene] = static_cast<uint16_t>((parent + gene) % STRIDE);
+      }
+      genomes.rehash(parent);
+    }
+  }
+
+  bool drawsFollowMutations( const MutationEngine& engine, size_t entries, const char* what )
+  {
+    // One draw starts each offspring's stream, then each mutation takes its own and the next gap's
+    const size_t expected = entries + 2 * engine.getLastMutationCount();
+    if ( engine.getLastDrawCount() != expected )
+    {
+      std::cerr << what << ": " << engine.getLastDrawCount() << " draws for " << entries << " offspring and "
+                << engine.getLastMutationCount() << " mutations, expected " << expected << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool withinSigmas( double observed, double expected, double variance, const std::string& what )
+  {
+    if ( std::abs(observed - expected) <= 5.0 * std::sqrt(variance) + 1.0 ) return true;
+
+    std::cerr << what << ": observed " << observed << ", expected " << expected << std::endl;
+    return false;
+  }
+
+  // Mutates one offspring at a time so every genome's mutation count is
+  // known, and sorts genomes with a single mutation into those changed at one
+  // gene (points) and those shifted (insertions and duplications)
+  bool checkRates( const Rates& rates, size_t offspring )
+  {
+    GenomeStore genomes;
+    initParents(genomes);
+    MutationEngine engine;
+    engine.init(rates.point, rates.insertion, rates.duplication, Config::MAX_DUPLICATION, STRIDE);
+
+    size_t mutations = 0;
+    size_t singles = 0;
+    size_t singlePoints = 0;
+    for ( size_t i = 0; i < offspring; ++i )
+    {
+      const uint32_t parent = static_cast<uint32_t>(i % PARENTS);
+      uint32_t child = parent;
+      const uint64_t seed = Random::hash(3, i);
+      engine.mutate(genomes, { &child, 1 }, { &seed, 1 });
+      if ( !drawsFollowMutations(engine, 1, rates.name) ) return false;
+
+      mutations += engine.getLastMutationCount();
+      if ( engine.getLastMutationCount() != 1 ) continue;
+
+      std::span<const uint16_t> before = genomes.get(parent);
+      std::span<const uint16_t> after = genomes.get(child);
+      const size_t changed = std::inner_product(before.begin(), before.end(), after.begin(), size_t(0), std::plus<>(), std::not_equal_to<>());
+      singles++;
+      singlePoints += changed <= 1;
+    }
+
+    // Every gene mutates independently, so the count is binomial
+    const double total = rates.point + rates.insertion + rates.duplication;
+    const double genes = static_cast<double>(offspring) * STRIDE;
+    bool passed = withinSigmas(static_cast<double>(mutations), genes * total, genes * total * (1.0 - total), std::string(rates.name) + " mutations");
+
+    // A shift can leave at most one gene changed only at the very end of the genome
+    const double pointShare = rates.point / total;
+    const double slack = 2.0 / STRIDE;
+    passed &= withinSigmas(static_cast<double>(singlePoints), singles * pointShare, singles * pointShare * (1.0 - pointShare) + std::pow(singles * slack, 2.0),
+                           std::string(rates.name) + " single point mutations");
+    return passed;
+  }
+
+  // The offspring of batch entry i, whatever batches and order it was mutated in
+  std::vector<std::vector<uint16_t>> mutateInBatches( const std::vector<size_t>& order, size_t batchSize, size_t& mutations )
+  {
+    GenomeStore genomes;
+    initParents(genomes);
+    MutationEngine engine;
+    engine.init(Config::POINT_MUTATION_RATE * 16, Config::INSERTION_RATE * 16, Config::DUPLICATION_RATE * 16, Config::MAX_DUPLICATION, STRIDE);
+
+    std::vector<uint32_t> children(order.size());
+    std::vector<uint64_t> seeds(order.size());
+    for ( size_t i = 0; i < order.size(); ++i )
+    {
+      children[i] = static_cast<uint32_t>(order[i] % PARENTS);
+      seeds[i] = Random::hash(5, order[i]);
+    }
+
+    mutations = 0;
+    for ( size_t begin = 0; begin < order.size(); begin += batchSize )
+    {
+      const size_t count = std::min(batchSize, order.size() - begin);
+      engine.mutate(genomes, { children.data() + begin, count }, { seeds.data() + begin, count });
+      mutations += engine.getLastMutationCount();
+      if ( !drawsFollowMutations(engine, count, "batched") ) return {};
+    }
+
+    std::vector<std::vector<uint16_t>> result(order.size());
+    for ( size_t i = 0; i < order.size(); ++i )
+    {
+      std::span<const uint16_t> genes = genomes.get(children[i]);
+      result[order[i]].assign(genes.begin(), genes.end());
+    }
+    return result;
+  }
+
+  bool checkBatchOrder()
+  {
+    std::vector<size_t> order(4000);
+    std::iota(order.begin(), order.end(), size_t(0));
+
+    size_t expectedMutations = 0;
+    const std::vector<std::vector<uint16_t>> expected = mutateInBatches(order, order.size(), expectedMutations);
+    if ( expected.empty() || expectedMutations == 0 ) return false;
+
+    Random::SplitMix64 random(9);
+    for ( size_t batchSize : { size_t(1), size_t(37), order.size() } )
+    {
+      for ( size_t i = order.size() - 1; i > 0; --i )
+      {
+        std::swap(order[i], order[random() % (i + 1)]);
+      }
+
+      size_t mutations = 0;
+      if ( mutateInBatches(order, batchSize, mutations) != expected || mutations != expectedMutations )
+      {
+        std::cerr << "Shuffled offspring in batches of " << batchSize << " mutated differently" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  const Rates rates[] = {
+    { "configured", Config::POINT_MUTATION_RATE, Config::INSERTION_RATE, Config::DUPLICATION_RATE },
+    { "points only", 1.0 / 512.0, 0.0, 0.0 },
+    { "insertions only", 0.0, 1.0 / 512.0, 0.0 },
+    { "mixed, high", 1.0 / 64.0, 1.0 / 128.0, 1.0 / 128.0 },
+  };
+
+  bool passed = true;
+  for ( const Rates& rate : rates )
+  {
+    passed &= checkRates(rate, 40000);
+  }
+  passed &= checkBatchOrder();
+
+  std::cout << (passed ? "Mutations follow the configured rates" : "Mutations do not follow the configured rates") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,347 @@
+#include "simulation/organism_registry.h"
+#include "utils/random.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Organisms must be exactly the connected groups of live cells a flood fill
+// finds, however they were grown, cut apart or renumbered
+namespace
+{
+  constexpr uint32_t NONE = OrganismRegistry::NONE;
+  constexpr int DX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+  constexpr int DY[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+
+  struct World
+  {
+    int width;
+    int height;
+    bool useHVDirections;
+    std::vector<Cell> cells;
+    OrganismRegistry registry;
+
+    World( int w, int h, bool hv ) : width(w), height(h), useHVDirections(hv), cells(static_cast<size_t>(w) * h)
+    {
+      registry.init(width, height, useHVDirections);
+    }
+
+    uint32_t index( int x, int y ) const { return static_cast<uint32_t>(y * width + x); }
+
+    int neighbours( uint32_t cell, uint32_t out[8] ) const
+    {
+      const int x = static_cast<int>(cell % width);
+      const int y = static_cast<int>(cell / width);
+      int count = 0;
+      for ( int d = 0; d < 8; d += useHVDirections ? 2 : 1 )
+      {
+        const int nx = x + DX[d];
+        const int ny = y + DY[d];
+        if ( nx >= 0 && nx < width && ny >= 0 && ny < height ) out[count++] = index(nx, ny);
+      }
+      return count;
+    }
+
+    void found( uint32_t cell, uint32_t genomeIndex, uint64_t epoch )
+    {
+      cells[cell] = { CellType::Wood, 0, static_cast<uint16_t>(1 + cell % 97), 0, genomeIndex, 0 };
+      registry.addFounder(cell, genomeIndex, epoch);
+    }
+
+    void grow( uint32_t cell, uint32_t source )
+    {
+      cells[cell] = { CellType::Leaf, 0, static_cast<uint16_t>(1 + cell % 89), 0, cells[source].genomeIndex, 0 };
+      registry.addCell(cell, source);
+    }
+
+    void kill( uint32_t cell )
+    {
+      cells[cell] = {};
+      registry.removeCell(cell);
+    }
+
+    // Grows shape from its first cell, each cell from a neighbour already in it
+    void growShape( const std::vector<uint32_t>& shape, uint32_t genomeIndex )
+    {
+      std::vector<uint8_t> inShape(cells.size(), 0);
+      for ( uint32_t cell : shape ) inShape[cell] = 1;
+
+      found(shape[0], genomeIndex, 0);
+      inShape[shape[0]] = 0;
+      std::vector<uint32_t> queue{ shape[0] };
+      uint32_t around[8];
+      for ( size_t head = 0; head < queue.size(); ++head )
+      {
+        const int count = neighbours(queue[head], around);
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( !inShape[around[i]] ) continue;
+          inShape[around[i]] = 0;
+          grow(around[i], queue[head]);
+          queue.push_back(around[i]);
+        }
+      }
+    }
+  };
+
+  // Brute force: components of live cells, numbered in scan order
+  std::vector<uint32_t> floodFill( const World& world, uint32_t& components )
+  {
+    std::vector<uint32_t> component(world.cells.size(), NONE);
+    std::vector<uint32_t> queue;
+    uint32_t around[8];
+    components = 0;
+    for ( uint32_t start = 0; start < world.cells.size(); ++start )
+    {
+      if ( !world.cells[start].isAlive() || component[start] != NONE ) continue;
+
+      component[start] = components;
+      queue.assign(1, start);
+      for ( size_t head = 0; head < queue.size(); ++head )
+      {
+        const int count = world.neighbours(queue[head], around);
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( !world.cells[around[i]].isAlive() || component[around[i]] != NONE ) continue;
+          component[around[i]] = components;
+          queue.push_back(around[i]);
+        }
+      }
+      components++;
+    }
+    return component;
+  }
+
+  // Same partition, one live organism per component, and matching sizes and energies
+  bool matchesFloodFill( World& world, const std::string& what )
+  {
+    uint32_t components = 0;
+    const std::vector<uint32_t> component = floodFill(world, components);
+    world.registry.refreshEnergy(world.cells.data(), nullptr);
+
+    std::vector<uint32_t> organismOf(components, NONE);
+    std::vector<uint32_t> componentOf(world.registry.getIdCount(), NONE);
+    std::vector<uint32_t> sizes(components, 0);
+    std::vector<uint64_t> energies(components, 0);
+    for ( uint32_t cell = 0; cell < world.cells.size(); ++cell )
+    {
+      const uint32_t organism = world.registry.getOrganism(cell);
+      if ( (organism == NONE) != (component[cell] == NONE) )
+      {
+        std::cerr << what << ": cell " << cell << " is labelled " << (organism == NONE ? "empty" : "live") << std::endl;
+        return false;
+      }
+      if ( organism == NONE ) continue;
+
+      if ( !world.registry.isLive(organism) || organism >= componentOf.size() )
+      {
+        std::cerr << what << ": cell " << cell << " belongs to dead organism " << organism << std::endl;
+        return false;
+      }
+      if ( organismOf[component[cell]] == NONE ) organismOf[component[cell]] = organism;
+      if ( componentOf[organism] == NONE ) componentOf[organism] = component[cell];
+      if ( organismOf[component[cell]] != organism || componentOf[organism] != component[cell] )
+      {
+        std::cerr << what << ": cell " << cell << " has organism " << organism << " but the flood fill disagrees" << std::endl;
+        return false;
+      }
+      sizes[component[cell]]++;
+      energies[component[cell]] += world.cells[cell].energy;
+    }
+
+    if ( world.registry.getOrganismCount() != components )
+    {
+      std::cerr << what << ": " << world.registry.getOrganismCount() << " organisms, flood fill found " << components << std::endl;
+      return false;
+    }
+    for ( uint32_t i = 0; i < components; ++i )
+    {
+      if ( world.registry.getSize(organismOf[i]) != sizes[i] || world.registry.getEnergy(organismOf[i]) != energies[i] )
+      {
+        std::cerr << what << ": organism " << organismOf[i] << " has size " << world.registry.getSize(organismOf[i])
+                  << ", flood fill found " << sizes[i] << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<uint32_t> row( const World& world, int y, int xBegin, int xEnd )
+  {
+    std::vector<uint32_t> cells;
+    for ( int x = xBegin; x < xEnd; ++x ) cells.push_back(world.index(x, y));
+    return cells;
+  }
+
+  // A bar, a ring and a comb, each cut into two or three pieces
+  bool checkCuts( bool useHVDirections )
+  {
+    const std::string directions = useHVDirections ? "4 directions" : "8 directions";
+    World world(48, 32, useHVDirections);
+
+    world.growShape(row(world, 2, 4, 36), 1);
+
+    std::vector<uint32_t> ring = row(world, 8, 4, 14);
+    for ( int y = 9; y < 17; ++y )
+    {
+      ring.push_back(world.index(4, y));
+      ring.push_back(world.index(13, y));
+    }
+    const std::vector<uint32_t> bottom = row(world, 17, 4, 14);
+    ring.insert(ring.end(), bottom.begin(), bottom.end());
+    world.growShape(ring, 2);
+
+    std::vector<uint32_t> comb = row(world, 28, 20, 44);
+    for ( int x = 21; x < 44; x += 4 )
+    {
+      for ( int y = 24; y < 28; ++y ) comb.push_back(world.index(x, y));
+    }
+    world.growShape(comb, 3);
+
+    if ( !matchesFloodFill(world, directions + ", grown") ) return false;
+
+    const struct
+    {
+      const char* name;
+      std::vector<uint32_t> cut;
+      size_t organisms;
+    } cuts[] = {
+      { "bar cut twice", { world.index(14, 2), world.index(25, 2) }, 5 },
+      { "ring cut once", { world.index(4, 12) }, 5 },
+      { "ring cut again", { world.index(13, 12) }, 6 },
+      { "comb cut in two places", { world.index(27, 28), world.index(35, 28) }, 8 },
+      { "comb tooth cut off", { world.index(41, 26) }, 9 },
+    };
+    for ( const auto& step : cuts )
+    {
+      for ( uint32_t cell : step.cut ) world.kill(cell);
+      world.registry.endEpoch(world.cells.data());
+
+      if ( !matchesFloodFill(world, directions + ", " + step.name) ) return false;
+      if ( world.registry.getOrganismCount() != step.organisms )
+      {
+        std::cerr << directions << ", " << step.name << ": " << world.registry.getOrganismCount() << " organisms instead of " << step.organisms << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Random births and deaths around half density, where organisms merge and split all the time
+  bool checkRandom( bool useHVDirections )
+  {
+    const std::string directions = useHVDirections ? "4 directions" : "8 directions";
+    World world(48, 32, useHVDirections);
+    Random::SplitMix64 random(useHVDirections ? 11 : 12);
+    std::vector<uint8_t> diedThisEpoch(world.cells.size(), 0);
+    uint32_t around[8];
+
+    for ( uint64_t epoch = 1; epoch <= 300; ++epoch )
+    {
+      std::fill(diedThisEpoch.begin(), diedThisEpoch.end(), 0);
+      for ( int i = 0; i < 60; ++i )
+      {
+        const uint32_t cell = static_cast<uint32_t>(random() % world.cells.size());
+        if ( world.cells[cell].isAlive() )
+        {
+          world.kill(cell);
+          diedThisEpoch[cell] = 1;
+        }
+      }
+      for ( int i = 0; i < 60; ++i )
+      {
+        const uint32_t cell = static_cast<uint32_t>(random() % world.cells.size());
+        if ( world.cells[cell].isAlive() || diedThisEpoch[cell] ) continue;
+
+        uint32_t source = NONE;
+        const int count = world.neighbours(cell, around);
+        for ( int n = 0; n < count && source == NONE; ++n )
+        {
+          if ( world.cells[around[n]].isAlive() ) source = around[n];
+        }
+        if ( source != NONE && random() % 4 != 0 )
+        {
+          world.grow(cell, source);
+        }
+        else
+        {
+          world.found(cell, static_cast<uint32_t>(epoch), epoch);
+        }
+      }
+      world.registry.endEpoch(world.cells.data());
+
+      if ( !matchesFloodFill(world, directions + ", random epoch " + std::to_string(epoch)) ) return false;
+    }
+    return true;
+  }
+
+  // Rows of founders that each merge into their row leave thousands of
+  // stale ids, so the next split renumbers; every organism must keep its
+  // cells, size, founder genome and age, and ids must keep their order
+  bool checkCompact( bool useHVDirections )
+  {
+    const std::string directions = useHVDirections ? "4 directions" : "8 directions";
+    World world(96, 64, useHVDirections);
+    for ( int y = 0; y < world.height; y += 2 )
+    {
+      for ( int x = 0; x < world.width; ++x )
+      {
+        const uint32_t cell = world.index(x, y);
+        world.found(cell, cell, cell);
+      }
+    }
+    world.registry.endEpoch(world.cells.data());
+
+    const uint64_t generation = world.registry.getGeneration();
+
+    world.kill(world.index(40, 0));
+    world.registry.endEpoch(world.cells.data());
+
+    if ( world.registry.getGeneration() == generation || world.registry.getIdCount() != world.registry.getOrganismCount() )
+    {
+      std::cerr << directions << ": " << world.registry.getIdCount() << " ids after the split, expected them renumbered" << std::endl;
+      return false;
+    }
+    if ( !matchesFloodFill(world, directions + ", compacted") ) return false;
+
+    uint32_t previous = 0;
+    for ( int y = 2; y < world.height; y += 2 )
+    {
+      const uint32_t first = world.index(0, y);
+      const uint32_t organism = world.registry.getOrganism(first);
+      const bool sameCells = [&]
+      {
+        for ( int x = 0; x < world.width; ++x )
+        {
+          if ( world.registry.getOrganism(world.index(x, y)) != organism ) return false;
+        }
+        return true;
+      }();
+
+      // The oldest founder of a row is its first cell, which is also its genome
+      if ( !sameCells || world.registry.getSize(organism) != static_cast<uint32_t>(world.width) ||
+           world.registry.getGenomeIndex(organism) != first || world.registry.getAge(organism, first) != 0 ||
+           (y > 2 && organism <= previous) )
+      {
+        std::cerr << directions << ": row " << y << " did not keep its organism through compaction" << std::endl;
+        return false;
+      }
+      previous = organism;
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  bool passed = true;
+  for ( bool useHVDirections : { true, false } )
+  {
+    passed &= checkCuts(useHVDirections);
+    passed &= checkRandom(useHVDirections);
+    passed &= checkCompact(useHVDirections);
+  }
+
+  std::cout << (passed ? "Organisms match the flood fill" : "Organisms differ from the flood fill") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+# Runs the same headless world in one process and split into slabs, and
+# fails unless the final alive count and pixel checksum agree.
+#   cmake -DEXE=<GenaXIDE> -P partition_checksums.cmake
+
+set(ARGS --headless --seed 42 --epochs 200)
+
+function(run_world processes result)
+  execute_process(
+    COMMAND ${EXE} ${ARGS} --processes ${processes}
+    OUTPUT_VARIABLE output
+    RESULT_VARIABLE status
+  )
+  if(NOT status EQUAL 0)
+    message(FATAL_ERROR "--processes ${processes} exited with ${status}:\n${output}")
+  endif()
+
+  string(REGEX MATCH "Alive cells: [0-9]+" alive "${output}")
+  string(REGEX MATCH "Pixel checksum: [0-9a-f]+" checksum "${output}")
+  if(NOT alive OR NOT checksum)
+    message(FATAL_ERROR "--processes ${processes} printed no results:\n${output}")
+  endif()
+  set(${result} "${alive}, ${checksum}" PARENT_SCOPE)
+endfunction()
+
+run_world(1 expected)
+message(STATUS "1 process: ${expected}")
+
+foreach(processes 2 3 5)
+  run_world(${processes} actual)
+  message(STATUS "${processes} processes: ${actual}")
+  if(NOT actual STREQUAL expected)
+    message(FATAL_ERROR "${processes} processes differ from 1")
+  endif()
+endforeach()
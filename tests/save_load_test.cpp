@@ -0,0 +1,110 @@
+#include "simulation/grid.h"
+#include "utils/thread_pool.h"
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+
+// Saving a world, loading it into a fresh grid and running on must give the
+// same world as never stopping, with corpses still rotting across the save
+namespace
+{
+  constexpr int WIDTH = 128;
+  constexpr int HEIGHT = 96;
+  constexpr int SAVED_EPOCHS = 120;
+  constexpr int MORE_EPOCHS = 2 * Config::CORPSE_DECAY_EPOCHS + 10;
+  constexpr uint64_t SEED = 5;
+
+  // FNV-1a over every cell, its genes and the soil under it
+  uint64_t hashWorld( const Grid& grid )
+  {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto add = [&]( uint64_t value )
+    {
+      hash = (hash ^ value) * 0x100000001B3ull;
+    };
+    for ( int y = 0; y < HEIGHT; ++y )
+    {
+      for ( int x = 0; x < WIDTH; ++x )
+      {
+        const Cell& cell = grid.getCell(x, y);
+        add(static_cast<uint64_t>(cell.type));
+        add(cell.energy);
+        add(cell.age);
+        add(cell.direction);
+        add(std::bit_cast<uint32_t>(grid.getSoil().get(x, y)));
+        if ( !cell.isAlive() ) continue;
+        for ( uint16_t gene : grid.getGenome(cell.genomeIndex) )
+        {
+          add(gene);
+        }
+      }
+    }
+    return hash;
+  }
+
+  bool checkContinuation( ThreadPool* loadedPool )
+  {
+    const size_t threads = loadedPool ? loadedPool->getThreadCount() : 1;
+
+    Grid uninterrupted;
+    uninterrupted.init(Config::MAX_ENERGY, Config::MAX_GENOME, WIDTH, HEIGHT, Config::USE_HV_DIRECTIONS, SEED);
+    for ( int epoch = 0; epoch < SAVED_EPOCHS; ++epoch )
+    {
+      uninterrupted.update();
+    }
+
+    // Corpses that died in the last CORPSE_DECAY_EPOCHS are still on the wheel
+    const size_t pending = uninterrupted.getTimers().size();
+    if ( pending == 0 )
+    {
+      std::cerr << "No corpses are rotting at epoch " << SAVED_EPOCHS << ", so the save carries no timed events" << std::endl;
+      return false;
+    }
+
+    std::stringstream file;
+    if ( !uninterrupted.save(file) )
+    {
+      std::cerr << "Saving at epoch " << SAVED_EPOCHS << " failed" << std::endl;
+      return false;
+    }
+
+    Grid loaded;
+    loaded.setThreadPool(loadedPool);
+    if ( !loaded.load(file) )
+    {
+      std::cerr << "Loading the epoch " << SAVED_EPOCHS << " save failed" << std::endl;
+      return false;
+    }
+    if ( loaded.getEpoch() != uninterrupted.getEpoch() || loaded.getTimers().size() != pending || hashWorld(loaded) != hashWorld(uninterrupted) )
+    {
+      std::cerr << "The loaded world on " << threads << " threads differs from the saved one" << std::endl;
+      return false;
+    }
+
+    for ( int epoch = 1; epoch <= MORE_EPOCHS; ++epoch )
+    {
+      uninterrupted.update();
+      loaded.update();
+      if ( hashWorld(loaded) != hashWorld(uninterrupted) || loaded.getTimers().size() != uninterrupted.getTimers().size() )
+      {
+        std::cerr << "The loaded world on " << threads << " threads differs " << epoch << " epochs after the save" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  ThreadPool pool(3);
+  bool passed = true;
+  for ( ThreadPool* threads : { static_cast<ThreadPool*>(nullptr), &pool } )
+  {
+    passed &= checkContinuation(threads);
+  }
+
+  std::cout << (passed ? "Loaded worlds continue like uninterrupted ones" : "Loaded worlds diverge") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include "simulation/soil_field.h"
+#include "utils/random.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Diffusion must give the same field, bit for bit, as a plain stencil with
+// mirrored edges, whatever the pool and however the rows are split, and the
+// border must lose nothing
+namespace
+{
+  constexpr float RATE = 0.2f;
+
+  // Uneven amounts so every sample differs from its neighbours
+  float initialAmount( int width, int x, int y )
+  {
+    return static_cast<float>(Random::hash(7, static_cast<uint64_t>(y) * width + x) >> 40) * 0x1.0p-12f;
+  }
+
+  void stepReference( std::vector<float>& field, int width, int height )
+  {
+    auto at = [&]( int x, int y )
+    {
+      return field[static_cast<size_t>(std::clamp(y, 0, height - 1)) * width + std::clamp(x, 0, width - 1)];
+    };
+
+    std::vector<float> next(field.size());
+    for ( int y = 0; y < height; ++y )
+    {
+      for ( int x = 0; x < width; ++x )
+      {
+        const float center = at(x, y);
+        const float sum = (at(x, y - 1) + at(x, y + 1)) + (at(x - 1, y) + at(x + 1, y));
+        next[static_cast<size_t>(y) * width + x] = center + RATE * (sum - 4.0f * center);
+      }
+    }
+    field.swap(next);
+  }
+
+  // sliceRows > 0 steps through beginDiffuse()/diffuseRows() in slices of that many rows
+  bool compareReference( int width, int height, int steps, ThreadPool* pool, int sliceRows )
+  {
+    SoilField soil;
+    soil.init(width, height, 1, 1.0f, pool);
+
+    std::vector<float> reference(static_cast<size_t>(width) * height, 1.0f);
+    for ( int y = 0; y < height; ++y )
+    {
+      for ( int x = 0; x < width; ++x )
+      {
+        const float amount = initialAmount(width, x, y);
+        soil.deposit(x, y, amount);
+        reference[static_cast<size_t>(y) * width + x] += amount;
+      }
+    }
+    const double total = soil.getTotal();
+
+    for ( int step = 0; step < steps; ++step )
+    {
+      stepReference(reference, width, height);
+      if ( sliceRows > 0 )
+      {
+        soil.beginDiffuse();
+        for ( int row = 0; row < height; row += sliceRows )
+        {
+          soil.diffuseRows(RATE, row, std::min(height, row + sliceRows));
+        }
+        soil.endDiffuse();
+      }
+      else
+      {
+        soil.diffuse(RATE, pool);
+      }
+    }
+
+    size_t mismatches = 0;
+    for ( int y = 0; y < height; ++y )
+    {
+      for ( int x = 0; x < width; ++x )
+      {
+        mismatches += std::bit_cast<uint32_t>(soil.get(x, y)) != std::bit_cast<uint32_t>(reference[static_cast<size_t>(y) * width + x]);
+      }
+    }
+    const bool conserved = std::abs(soil.getTotal() - total) <= 1e-5 * total;
+
+    if ( mismatches != 0 || !conserved )
+    {
+      std::cerr << width << "x" << height << ", " << steps << " steps, " << (pool ? pool->getThreadCount() : 1)
+                << " threads, slices of " << sliceRows << " rows: " << mismatches << " samples differ, total "
+                << total << " became " << soil.getTotal() << std::endl;
+    }
+    return mismatches == 0 && conserved;
+  }
+}
+
+int main()
+{
+  ThreadPool pool(4);
+  bool passed = true;
+
+  // Two column blocks with a ragged tail, odd sizes, and fields a few samples across
+  for ( ThreadPool* threads : { static_cast<ThreadPool*>(nullptr), &pool } )
+  {
+    passed &= compareReference(1100, 40, 3, threads, 0);
+    passed &= compareReference(517, 259, 4, threads, 0);
+    passed &= compareReference(40, 30, 8, threads, 0);
+    passed &= compareReference(3, 2, 5, threads, 0);
+  }
+  passed &= compareReference(517, 259, 4, nullptr, 7);
+  passed &= compareReference(40, 30, 8, nullptr, 1);
+
+  std::cout << (passed ? "Diffusion matches the reference stencil" : "Diffusion differs from the reference stencil") << std::endl;
+  return passed ? 0 : 1;
+}